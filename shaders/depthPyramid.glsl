@@ -0,0 +1,32 @@
+// Reduction of a level of the depth pyramid, see OcclusionCuller.
+// The shader including it declares the source and how to read it:
+//   float LoadDepth(ivec2 texel)
+// Each texel keeps the farthest depth of the texels it covers in the level below. With reverse-Z the farthest is
+// the smallest. Levels are half the size of the one below rounded up, so edge texels may cover a single column or
+// row of an odd sized level: reads are clamped to its last texel.
+// Only the top left part of the images holds the depth rendered, the sizes are those of that part.
+
+#define GROUP_SIZE 8
+
+layout(local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE) in;
+
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D level;
+
+layout(push_constant) uniform Reduction {
+    ivec2 sourceSize;
+    ivec2 levelSize;
+} reduction;
+
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, reduction.levelSize)))
+        return;
+
+    ivec2 last = reduction.sourceSize - 1;
+    ivec2 source = texel * 2;
+
+    float depth = min(min(LoadDepth(min(source, last)), LoadDepth(min(source + ivec2(1, 0), last))),
+                      min(LoadDepth(min(source + ivec2(0, 1), last)), LoadDepth(min(source + ivec2(1, 1), last))));
+
+    imageStore(level, texel, vec4(depth));
+}
@@ -0,0 +1,6 @@
+// Material features, see ShaderFeature.
+// Specialization constants, so the driver folds the branches away for each pipeline variant.
+// constant_id must match the ShaderFeature value, the defaults match an empty feature mask.
+
+layout(constant_id = 0) const bool FEATURE_VERTEX_COLOR = false;
+layout(constant_id = 1) const bool FEATURE_GRAYSCALE = false;
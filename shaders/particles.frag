@@ -0,0 +1,13 @@
+#version 450
+
+// Round soft sprite, blended additively: the particles need no sorting.
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragCorner;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float falloff = 1.0 - smoothstep(0.5, 1.0, length(fragCorner));
+    outColor = vec4(fragColor.rgb * fragColor.a * falloff, 0.0);
+}
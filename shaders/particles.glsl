@@ -0,0 +1,54 @@
+// GPU particles, see ParticleSystem. Must match ParticleEmitterData and ParticleFrameData.
+// The particles never leave the GPU: the free ones are listed in the dead list, the live ones in one of two alive
+// lists. Emission consumes from the dead list and appends to the alive list of the frame, the simulation appends the
+// survivors to the other alive list and the dead back to the dead list, so the live particles stay packed.
+
+#define PARTICLE_GROUP_SIZE 64
+
+// Stages which only read the particles define it as readonly
+#ifndef PARTICLE_ACCESS
+#define PARTICLE_ACCESS
+#endif
+
+struct Particle {
+    vec4 positionAge;      // Position (xyz), seconds since emitted (w)
+    vec4 velocityLifetime; // Velocity (xyz), seconds it lives (w)
+    vec4 colorSize;        // rgb, and size in world units (w)
+};
+
+struct Emitter {
+    vec4 positionRadius;
+    vec4 velocitySpread;
+    vec4 colorSize;
+    float rate;
+    float lifetime;
+    float remainder;
+    uint padding;
+};
+
+layout(set = 0, binding = 0) PARTICLE_ACCESS buffer Emitters {
+    Emitter emitters[];
+};
+
+layout(set = 0, binding = 1) PARTICLE_ACCESS buffer Particles {
+    Particle particles[];
+};
+
+// Indices of the free particles, deadCount of them
+layout(set = 0, binding = 2) PARTICLE_ACCESS buffer DeadList {
+    uint deadList[];
+};
+
+// Two lists of capacity indices each, one after the other
+layout(set = 0, binding = 3) PARTICLE_ACCESS buffer AliveLists {
+    uint aliveLists[];
+};
+
+// Counters, and the indirect arguments written from them
+layout(set = 0, binding = 4) PARTICLE_ACCESS buffer ParticleState {
+    int deadCount;
+    uint aliveCounts[2];
+    uint statePadding;
+    uvec4 simulateDispatch; // VkDispatchIndirectCommand in xyz
+    uvec4 draw;             // VkDrawIndirectCommand
+} state;
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Camera facing quads, one instance per live particle, see ParticleSystem. Must match ParticleDrawData.
+// The instance count comes from the simulation, the CPU never knows how many particles are alive.
+
+#define PARTICLE_ACCESS readonly
+#include "particles.glsl"
+
+layout(push_constant) uniform ParticleDrawData {
+    mat4 viewProj;
+    uint aliveList;
+    uint capacity;
+} draw;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragCorner;
+
+vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0),
+    vec2(1.0, -1.0),
+    vec2(1.0, 1.0),
+    vec2(-1.0, -1.0),
+    vec2(1.0, 1.0),
+    vec2(-1.0, 1.0)
+);
+
+void main() {
+    uint index = aliveLists[draw.aliveList * draw.capacity + gl_InstanceIndex];
+    Particle particle = particles[index];
+    vec2 corner = corners[gl_VertexIndex];
+
+    // World space axes of the screen: the first two rows of the view projection, for a symmetric frustum
+    vec3 right = normalize(vec3(draw.viewProj[0][0], draw.viewProj[1][0], draw.viewProj[2][0]));
+    vec3 up = normalize(vec3(draw.viewProj[0][1], draw.viewProj[1][1], draw.viewProj[2][1]));
+
+    vec3 position = particle.positionAge.xyz + (right * corner.x + up * corner.y) * particle.colorSize.w;
+    gl_Position = draw.viewProj * vec4(position, 1.0);
+
+    // Fades out over its life
+    float life = clamp(particle.positionAge.w / particle.velocityLifetime.w, 0.0, 1.0);
+    fragColor = vec4(particle.colorSize.rgb, 1.0 - life);
+    fragCorner = corner;
+}
@@ -1,9 +1,16 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "features.glsl"
 
 layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    vec3 color = fragColor;
+    if (FEATURE_GRAYSCALE)
+        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+
+    outColor = vec4(color, 1.0);
 }
\ No newline at end of file
@@ -1,7 +1,24 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "features.glsl"
 
 layout(location = 0) out vec3 fragColor;
 
+// The depth prepass and the color pass must compute the exact same depth
+invariant gl_Position;
+
+// Per draw data, from the uniform ring (dynamic offset)
+layout(set = 1, binding = 0) uniform ObjectData
+{
+    mat4 model;
+} object;
+
+layout(push_constant) uniform CameraData
+{
+    mat4 viewProj;
+} camera;
+
 vec2 positions[3] = vec2[](
     vec2(0.0, -0.5),
     vec2(0.5, 0.5),
@@ -15,6 +32,6 @@ vec3 colors[3] = vec3[](
 );
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = camera.viewProj * object.model * vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    fragColor = FEATURE_VERTEX_COLOR ? colors[gl_VertexIndex] : vec3(1.0);
 }
\ No newline at end of file
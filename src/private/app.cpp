@@ -1,22 +1,56 @@
 #include <app.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
 #include <cstring>
-#include <iostream>
 #include <map>
+#include <sstream>
 #include <tuple>
 #include <vector>
 
+#include <bindlessHeap.h>
+#include <computeScheduler.h>
 #include <config.h>
+#include <descriptorAllocator.h>
+#include <deviceBenchmark.h>
+#include <drawList.h>
+#include <dynamicResolution.h>
+#include <frameCapture.h>
 #include <graphicPipeline.h>
+#include <initGraph.h>
+#include <jobSystem.h>
+#include <log.h>
+#include <memoryBudget.h>
+#include <metrics.h>
+#include <occlusionCuller.h>
+#include <particleSystem.h>
+#include <pipelineCache.h>
+#include <pipelineRegistry.h>
+#include <postProcess.h>
+#include <profiler.h>
+#include <renderServer.h>
+#include <renderTarget.h>
+#include <scene.h>
+#include <shaderInterface.h>
+#include <shaderReloader.h>
 #include <swapChain.h>
+#include <uniformRing.h>
+#include <utils/deviceInfo.h>
+#include <utils/deviceScore.h>
+#include <utils/file.h>
+#include <utils/png.h>
 #include <utils/queueFamily.h>
 #include <utils/utils.h>
 #include <utils/verboseDump.h>
+#include <viewport.h>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <glm/gtc/constants.hpp>
+
 using VulkanRenderer::Application;
 
 namespace Cst
@@ -31,8 +65,200 @@ constexpr bool enableValidationLayers = true;
 #endif
 
 static const float singleQueuePriority = 1.0f;
+
+// Size of the global bindless arrays, clamped to the device limits.
+constexpr uint32_t bindlessMaxTextures = 16384;
+constexpr uint32_t bindlessMaxStorageBuffers = 4096;
+
+// Per frame descriptor pools start small and double when full.
+constexpr uint32_t descriptorSetsPerPool = 64;
+constexpr uint32_t maxDescriptorSetsPerPool = 4096;
+
+// Per frame budget for per draw data, and the biggest struct a draw can read from a dynamic offset.
+constexpr VkDeviceSize uniformRingSizePerFrame = 4 * 1024 * 1024;
+constexpr VkDeviceSize uniformRingBindingRange = 256;
+
+constexpr const char* vertShaderFile = "shaders/simple.vert.spv";
+constexpr const char* fragShaderFile = "shaders/simple.frag.spv";
+constexpr const char* postProcessShaderFile = "shaders/postProcess.comp.spv";
+constexpr const char* occlusionCullShaderFile = "shaders/occlusionCull.comp.spv";
+constexpr const char* depthPyramidShaderFile = "shaders/depthPyramid.comp.spv";
+constexpr const char* depthPyramidMultisampleShaderFile = "shaders/depthPyramidMultisample.comp.spv";
+constexpr const char* deviceBenchmarkShaderFile = "shaders/deviceBenchmark.comp.spv";
+constexpr const char* particleEmitShaderFile = "shaders/particleEmit.comp.spv";
+constexpr const char* particleSimulateShaderFile = "shaders/particleSimulate.comp.spv";
+constexpr const char* particleControlShaderFile = "shaders/particleControl.comp.spv";
+constexpr const char* particleVertShaderFile = "shaders/particles.vert.spv";
+constexpr const char* particleFragShaderFile = "shaders/particles.frag.spv";
+
+// Hot reload: sources of the graphic pipeline shaders, and their SPIR-V cache in the working directory
+#if defined(VULKAN_RENDERER_SHADERS_FOLDER)
+constexpr const char* shaderSourceFolder = VULKAN_RENDERER_SHADERS_FOLDER;
+#else
+constexpr const char* shaderSourceFolder = "shaders";
+#endif
+constexpr const char* vertShaderSource = "simple.vert";
+constexpr const char* fragShaderSource = "simple.frag";
+constexpr const char* shaderCacheFolder = "shaderCache";
+constexpr const char* shaderCompiler = "glslc";
+
+// Dynamic resolution bounds, of the scale applied to both sides of the viewports
+constexpr float dynamicResolutionMinScale = 0.5f;
+constexpr float dynamicResolutionMaxScale = 1.f;
+
+// Pass field of the draw sort keys, in the order the passes are recorded
+constexpr uint32_t depthPrepassKey = 0;
+constexpr uint32_t colorPassKey = 1;
+
+// Preferred first, 32 bits float keeps the most precision with reverse-Z
+constexpr std::array<VkFormat, 3> depthFormats = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32,
+                                                  VK_FORMAT_D16_UNORM};
+
+// Written at exit, in the working directory
+constexpr const char* pipelineCacheFile = "pipelineCache.bin";
+// Written when a device is benchmarked, in the working directory
+constexpr const char* deviceBenchmarkFile = "deviceBenchmark.txt";
+
+// Profiler trace, when no file is given on the command line
+constexpr const char* defaultTraceFile = "trace.json";
+
+// How often the metrics file is written, scrapers don't need it more often
+constexpr std::chrono::milliseconds metricsWriteInterval{10000};
+
+// Fraction of each heap budget kept free. Without VK_EXT_memory_budget, the budget is a fraction of the heap.
+constexpr float memoryBudgetHeadroom = 0.1f;
+constexpr float memoryFallbackBudget = 0.8f;
+
+// Particles: the emitters around the scene, and what every particle goes through
+constexpr uint32_t particleMaxEmitters = 64;
+constexpr uint32_t particleEmitterCount = 4;
+constexpr float particleLifetime = 3.f;
+constexpr float particleGravity = -0.4f;
+constexpr float particleDrag = 0.3f;
+
+// Captures waiting for the GPU or for a worker. A frame is skipped when they are all busy.
+constexpr uint32_t captureBufferCount = VulkanRenderer::maxFramesInFlight + 2;
+// Captures requested with F11, when no folder is given on the command line
+constexpr const char* defaultCaptureFolder = "captures";
+
+// Render server: frames rendered by a single submission, and the limits of a request
+constexpr uint32_t serverMaxFramesPerBatch = 8;
+constexpr uint32_t serverMaxImageSize = 8192;
+constexpr uint32_t serverMaxFrameCount = 1024;
+// How long the server waits for jobs before checking it must stop
+constexpr std::chrono::milliseconds serverPollInterval{100};
+// Shorter when only the jobs of clients still reading their last replies are left
+constexpr std::chrono::milliseconds serverBacklogPollInterval{5};
 } // namespace Cst
 
+namespace
+{
+// Validation messages go through the logger, like everything else
+VKAPI_ATTR VkBool32 VKAPI_CALL DebugMessengerCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                                      VkDebugUtilsMessageTypeFlagsEXT type,
+                                                      const VkDebugUtilsMessengerCallbackDataEXT* callbackData,
+                                                      void* userData)
+{
+    // The message is copied in the record, it doesn't outlive the callback
+    if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+        LOG_ERROR("[Vulkan] ", callbackData->pMessage);
+    else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+        LOG_WARNING("[Vulkan] ", callbackData->pMessage);
+    else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+        LOG_INFO("[Vulkan] ", callbackData->pMessage);
+    else
+        LOG_VERBOSE("[Vulkan] ", callbackData->pMessage);
+
+    // Never abort the call
+    return VK_FALSE;
+}
+
+// Encode the frames rendered for a job and stream them to its client, on a worker.
+// Replies were reserved from firstReply on, one per frame and one for the end of the job.
+void SendRenderedFrames(VulkanRenderer::RenderConnection& connection, const VulkanRenderer::RenderRequest& request,
+                        std::vector<std::vector<uint8_t>>& frames, uint32_t firstFrame, uint64_t firstReply, bool bgra,
+                        bool lastFrames)
+{
+    PROFILE_FUNCTION();
+
+    const size_t pixelCount = static_cast<size_t>(request.width) * request.height;
+    std::vector<uint8_t> rgba;
+
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        const char* encoding = bgra ? "bgra" : "rgba";
+        std::vector<uint8_t>* data = &frames[i];
+        std::vector<uint8_t> png;
+
+        if (request.format == VulkanRenderer::CaptureFormat::Png)
+        {
+            rgba.resize(pixelCount * 4);
+            VulkanRenderer::Utils::ConvertToOpaqueRgba(frames[i].data(), pixelCount, bgra, rgba.data());
+            png = VulkanRenderer::Utils::EncodePng(rgba.data(), request.width, request.height);
+            encoding = "png";
+            data = &png;
+        }
+
+        // Client gone, no need to encode the rest
+        if (!connection.SendFrame(firstReply + i, request.id, firstFrame + static_cast<uint32_t>(i), encoding,
+                                  request.width, request.height, *data))
+            return;
+    }
+
+    if (lastFrames)
+        connection.SendDone(firstReply + frames.size(), request.id);
+}
+
+// Highest sample count up to requested that both color and depth attachments support
+uint32_t ChooseSampleCount(const VkPhysicalDeviceLimits& limits, int requested)
+{
+    const VkSampleCountFlags supported = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+
+    uint32_t samples = VK_SAMPLE_COUNT_64_BIT;
+    while (samples > 1 && (samples > static_cast<uint32_t>(std::max(requested, 1)) || !(supported & samples)))
+        samples >>= 1;
+
+    if (static_cast<int>(samples) != std::max(requested, 1))
+        LOG_WARNING(requested, " MSAA samples are not supported by the device, using ", samples);
+
+    return samples;
+}
+
+// First depth format usable as an attachment, and sampled when it is read back by the culling.
+// VK_FORMAT_UNDEFINED if none.
+VkFormat ChooseDepthFormat(VkPhysicalDevice physicalDevice, bool sampled)
+{
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (sampled)
+        required |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+    for (VkFormat format : Cst::depthFormats)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        if ((properties.optimalTilingFeatures & required) == required)
+            return format;
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+VkDebugUtilsMessengerCreateInfoEXT GetDebugMessengerCreateInfo()
+{
+    VkDebugUtilsMessengerCreateInfoEXT createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+                                 VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
+                                 VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+                                 VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                             VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                             VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    createInfo.pfnUserCallback = DebugMessengerCallback;
+    return createInfo;
+}
+} // namespace
+
 Application::Application(int width, int height, const char* windowName)
     : m_width(width)
     , m_height(height)
@@ -47,11 +273,18 @@ int Application::Init()
     if (m_initialized)
         return 0;
 
-    int res = InitWindow();
-    if (res != 0)
-        return res;
+    m_initStart = std::chrono::steady_clock::now();
+    PROFILE_THREAD_NAME("Main");
 
-    res = InitVulkan();
+    // One worker per hardware thread, this one included
+    VulkanRenderer::JobSystemConfig jobConfig;
+    jobConfig.workerCount = 0;
+    m_jobSystem = std::make_unique<VulkanRenderer::JobSystem>(jobConfig);
+
+    // Needed by both the window and the instance, which are created in parallel
+    glfwInit();
+
+    int res = InitVulkan();
     if (res != 0)
         return res;
 
@@ -64,39 +297,112 @@ int Application::Run()
     if (!m_initialized)
         return -1;
 
+    if (m_renderServer)
+        return RunServer();
+
     int returnCode = 0;
 
     while (!glfwWindowShouldClose(m_window) || returnCode != 0)
     {
         glfwPollEvents();
+
+        // The other windows can be closed on their own
+        auto isClosed = [this](const std::unique_ptr<VulkanRenderer::Viewport>& viewport)
+        {
+            GLFWwindow* window = viewport->GetWindow();
+            return window != nullptr && window != m_window && glfwWindowShouldClose(window);
+        };
+        if (std::any_of(m_viewports.begin(), m_viewports.end(), isClosed))
+        {
+            vkDeviceWaitIdle(m_device);
+
+            // Their targets go with them, the ones left keep theirs
+            for (const std::unique_ptr<VulkanRenderer::Viewport>& viewport : m_viewports)
+            {
+                if (!isClosed(viewport))
+                    continue;
+
+                if (m_postProcess)
+                    m_postProcess->ReleaseTarget(viewport->GetId());
+                if (m_occlusionCuller)
+                    m_occlusionCuller->ReleaseTarget(viewport->GetId());
+            }
+
+            std::erase_if(m_viewports, isClosed);
+        }
+
         returnCode = DrawFrame();
+
+        if (m_traceDumpRequested)
+        {
+            m_traceDumpRequested = false;
+            DumpTrace();
+        }
     }
 
     vkDeviceWaitIdle(m_device);
 
+    if (VulkanRenderer::Parameters().traceFile())
+        DumpTrace();
+
     return 0;
 }
 
 void Application::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
 {
-    if (Application* App = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window)))
-        App->m_framebufferResized = true;
+    Application* App = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
+    if (App == nullptr)
+        return;
+
+    for (std::unique_ptr<VulkanRenderer::Viewport>& viewport : App->m_viewports)
+    {
+        if (viewport->GetWindow() == window)
+            viewport->MarkOutOfDate();
+    }
 }
 
-int Application::InitWindow()
+void Application::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    glfwInit();
+    Application* App = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
+    if (App == nullptr || action != GLFW_PRESS)
+        return;
+
+    // Dumped between two frames, not in the middle of one
+    if (key == GLFW_KEY_F12)
+        App->m_traceDumpRequested = true;
 
+    if (key == GLFW_KEY_F11)
+        App->m_captureRequested = true;
+}
+
+void Application::DumpTrace() const
+{
+    const char* filePath = VulkanRenderer::Parameters().traceFile() ? VulkanRenderer::Parameters().traceFile()->c_str()
+                                                                      : Cst::defaultTraceFile;
+
+    if (PROFILE_DUMP(filePath))
+        LOG_INFO("Profiler trace written to ", filePath);
+    else
+        LOG_WARNING("No profiler trace written, build with VULKAN_RENDERER_PROFILER to enable it");
+}
+
+int Application::InitWindow()
+{
     // First hint glfw to not initialize an OpenGL context
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
+    // The server renders offscreen, the window only keeps the surface based device selection working
+    if (VulkanRenderer::Parameters().serverSocket())
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     m_window = glfwCreateWindow(m_width, m_height, m_windowName, nullptr, nullptr);
     glfwSetWindowUserPointer(m_window, this);
     glfwSetFramebufferSizeCallback(m_window, FramebufferResizeCallback);
+    glfwSetKeyCallback(m_window, KeyCallback);
 
     if (m_window == nullptr)
     {
-        std::cout << "Failed to create window" << std::endl;
+        LOG_ERROR("Failed to create window");
         return -1;
     }
 
@@ -108,31 +414,121 @@ int Application::InitVulkan()
     if (m_initialized)
         return 0;
 
+    // Each step waits for the steps it uses, independent ones overlap on the job system.
+    // Window system calls stay on this thread.
+    using VulkanRenderer::InitThread;
+    auto step = [this](int (Application::*function)()) { return [this, function]() { return (this->*function)(); }; };
+
+    VulkanRenderer::InitGraph graph;
+
     // clang-format off
-    auto AllInitFunctions = {
-        &Application::CreateInstance,
-        &Application::CreateSurface,
-        &Application::PickPhysicalDevice,
-        &Application::CreateLogicalDevice,
-        &Application::CreateSwapChain,
-        &Application::CreateGraphicPipeline,
-        &Application::CreateFramebuffers,
-        &Application::CreateCommandPool,
-        &Application::CreateCommandBuffer,
-        &Application::CreateSyncObjects
-    };
+    auto window = graph.AddStep("Window", step(&Application::InitWindow), {}, InitThread::Main);
+    auto instance = graph.AddStep("Instance", step(&Application::CreateInstance));
+    auto shaderFiles = graph.AddStep("LoadShaderFiles", step(&Application::LoadShaderFiles));
+    auto cacheFile = graph.AddStep("LoadPipelineCacheFile", step(&Application::LoadPipelineCacheFile));
+    auto surface = graph.AddStep("Surface", step(&Application::CreateSurface), {window, instance});
+    auto physicalDevice = graph.AddStep("PhysicalDevice", step(&Application::PickPhysicalDevice), {surface});
+    auto device = graph.AddStep("LogicalDevice", step(&Application::CreateLogicalDevice), {physicalDevice});
+    auto memoryBudget = graph.AddStep("MemoryBudget", step(&Application::CreateMemoryBudget), {device});
+    graph.AddStep("Metrics", step(&Application::CreateMetrics), {memoryBudget});
+    auto mainViewport = graph.AddStep("MainViewport", step(&Application::CreateMainViewport), {device},
+                                      InitThread::Main);
+    auto offscreenPass = graph.AddStep("OffscreenRenderPass", step(&Application::CreateOffscreenRenderPass),
+                                       {mainViewport});
+    graph.AddStep("FrameCapture", step(&Application::CreateFrameCapture), {mainViewport});
+    graph.AddStep("RenderServer", step(&Application::CreateRenderServer), {offscreenPass});
+    auto pipelineCache = graph.AddStep("PipelineCache", step(&Application::CreatePipelineCache), {device, cacheFile});
+    auto registry = graph.AddStep("PipelineRegistry", step(&Application::CreatePipelineRegistry), {pipelineCache});
+    auto bindless = graph.AddStep("BindlessHeap", step(&Application::CreateBindlessHeap), {device});
+    auto descriptors = graph.AddStep("DescriptorAllocator", step(&Application::CreateDescriptorAllocator), {device});
+    auto uniformRing = graph.AddStep("UniformRing", step(&Application::CreateUniformRing), {descriptors});
+    auto pipeline = graph.AddStep("GraphicPipeline", step(&Application::CreateGraphicPipeline),
+                                  {mainViewport, bindless, uniformRing, shaderFiles, registry});
+    graph.AddStep("Scene", step(&Application::CreateScene), {pipeline});
+    graph.AddStep("Framebuffers", step(&Application::CreateFramebuffers), {mainViewport, pipeline});
+    auto postProcess = graph.AddStep("PostProcess", step(&Application::CreatePostProcess),
+                                     {mainViewport, pipelineCache, descriptors});
+    auto occlusionCuller = graph.AddStep("OcclusionCuller", step(&Application::CreateOcclusionCuller),
+                                         {pipelineCache, uniformRing});
+    graph.AddStep("ParticleSystem", step(&Application::CreateParticleSystem),
+                  {pipeline, pipelineCache, descriptors});
+    graph.AddStep("Viewports", step(&Application::CreateViewports),
+                  {pipeline, offscreenPass, postProcess, occlusionCuller}, InitThread::Main);
+    auto commandPool = graph.AddStep("CommandPool", step(&Application::CreateCommandPool), {device});
+    graph.AddStep("CommandBuffer", step(&Application::CreateCommandBuffer), {commandPool});
+    graph.AddStep("SyncObjects", step(&Application::CreateSyncObjects), {device});
+    graph.AddStep("ComputeScheduler", step(&Application::CreateComputeScheduler), {device});
+    graph.AddStep("DynamicResolution", step(&Application::CreateDynamicResolution), {device});
+    graph.AddStep("ShaderReloader", step(&Application::CreateShaderReloader));
     // clang-format on
 
-    for (auto Func : AllInitFunctions)
+    // Serial init is kept to measure what the parallel one brings
+    int res = graph.Run(VulkanRenderer::Parameters().serialInit() ? nullptr : m_jobSystem.get());
+
+    if (VulkanRenderer::Parameters().verbose())
+    {
+        std::ostringstream timings;
+        graph.DumpTimings(timings);
+        LOG_VERBOSE(timings.str());
+    }
+
+    return res;
+}
+
+int Application::LoadShaderFiles()
+{
+    // Only reading files, modules are created with the pipeline once the device exists
+    if (!VulkanRenderer::Utils::ReadFile(Cst::vertShaderFile, m_vertShaderCode))
+    {
+        LOG_ERROR("File ", Cst::vertShaderFile, " was not found.");
+        return -1;
+    }
+
+    if (!VulkanRenderer::Utils::ReadFile(Cst::fragShaderFile, m_fragShaderCode))
     {
-        int res = (this->*Func)();
-        if (res != 0)
-            return res;
+        LOG_ERROR("File ", Cst::fragShaderFile, " was not found.");
+        return -1;
     }
 
     return 0;
 }
 
+int Application::LoadPipelineCacheFile()
+{
+    // Not an error, first run or cache deleted
+    if (!VulkanRenderer::Utils::ReadFile(Cst::pipelineCacheFile, m_pipelineCacheData))
+        m_pipelineCacheData.clear();
+
+    return 0;
+}
+
+int Application::CreatePipelineCache()
+{
+    VulkanRenderer::PipelineCacheConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.initialData = &m_pipelineCacheData;
+
+    m_pipelineCache = std::make_unique<VulkanRenderer::PipelineCache>(config);
+
+    // Data was copied by the driver
+    m_pipelineCacheData = {};
+    return m_pipelineCache->IsValid() ? 0 : -1;
+}
+
+int Application::CreatePipelineRegistry()
+{
+    VulkanRenderer::PipelineRegistryConfig config;
+    config.device = m_device;
+    config.pipelineCache = m_pipelineCache->GetCache();
+    config.useLibraries = m_pipelineLibraries;
+    config.jobSystem = m_jobSystem.get();
+    config.framesInFlight = maxFramesInFlight;
+
+    m_pipelineRegistry = std::make_unique<VulkanRenderer::PipelineRegistry>(config);
+    return 0;
+}
+
 int Application::CreateInstance()
 {
     if (m_instance != nullptr)
@@ -145,7 +541,8 @@ int Application::CreateInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    // 1.2 allows descriptor indexing in core. Devices with a lower version still work, without bindless.
+    appInfo.apiVersion = VK_API_VERSION_1_2;
 
     // Information to create a VkInstance
     VkInstanceCreateInfo createInfo{};
@@ -170,14 +567,34 @@ int Application::CreateInstance()
 
     if (extensionValidation != glfwExtensionCount)
     {
-        std::cout << "Extension " << glfwExtensions[extensionValidation] << " required by glfw not supported..."
-                  << std::endl;
+        LOG_ERROR("Extension ", glfwExtensions[extensionValidation], " required by glfw not supported...");
         return -1;
     }
 
     // When we verified that all extensions are supported, continue filling the create info struct
-    createInfo.enabledExtensionCount = glfwExtensionCount;
-    createInfo.ppEnabledExtensionNames = glfwExtensions;
+    std::vector<const char*> enabledExtensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+
+    // Validation messages are routed to the logger, when the extension is there
+    const char* debugUtilsExtension = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+    bool debugUtilsSupported = false;
+    if constexpr (Cst::enableValidationLayers)
+    {
+        debugUtilsSupported =
+            VulkanRenderer::Utils::ValidateStrings(
+                &debugUtilsExtension, 1, extensions.data(), extensionCount,
+                [](const VkExtensionProperties& property) -> const char* { return property.extensionName; }) == 1;
+    }
+
+    // Chained to the instance create info, so messages of vkCreateInstance/vkDestroyInstance are also routed
+    VkDebugUtilsMessengerCreateInfoEXT debugMessengerInfo = GetDebugMessengerCreateInfo();
+    if (debugUtilsSupported)
+    {
+        enabledExtensions.push_back(debugUtilsExtension);
+        createInfo.pNext = &debugMessengerInfo;
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     // Do the same with validation layers
     if constexpr (Cst::enableValidationLayers)
@@ -194,8 +611,7 @@ int Application::CreateInstance()
 
         if (validationLayersValidation != static_cast<int>(Cst::validationLayers.size()))
         {
-            std::cout << "Validation layer " << Cst::validationLayers[validationLayersValidation] << " not supported..."
-                      << std::endl;
+            LOG_ERROR("Validation layer ", Cst::validationLayers[validationLayersValidation], " not supported...");
             return -1;
         }
 
@@ -210,10 +626,23 @@ int Application::CreateInstance()
     // Finally try to create the instance
     if (vkCreateInstance(&createInfo, nullptr, &m_instance) != VK_SUCCESS)
     {
-        std::cout << "Failed to create Vulkan instance" << std::endl;
+        LOG_ERROR("Failed to create Vulkan instance");
         return -1;
     }
 
+    if (debugUtilsSupported)
+    {
+        auto createDebugMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+            vkGetInstanceProcAddr(m_instance, "vkCreateDebugUtilsMessengerEXT"));
+
+        if (createDebugMessenger == nullptr ||
+            createDebugMessenger(m_instance, &debugMessengerInfo, nullptr, &m_debugMessenger) != VK_SUCCESS)
+        {
+            LOG_WARNING("Failed to create the debug messenger, validation messages won't be logged");
+            m_debugMessenger = VK_NULL_HANDLE;
+        }
+    }
+
     return 0;
 }
 
@@ -232,55 +661,151 @@ int Application::PickPhysicalDevice()
 
     if (nbDevicesFound == 0)
     {
-        std::cout << "Found no capable physical devices." << std::endl;
+        LOG_ERROR("Found no capable physical devices.");
         return -1;
     }
 
-    if (VulkanRenderer::Parameters().verbose())
-        std::cout << "Found " << nbDevicesFound << " physical devices" << std::endl;
+    LOG_VERBOSE("Found ", nbDevicesFound, " physical devices");
 
     std::vector<VkPhysicalDevice> devices(nbDevicesFound);
     vkEnumeratePhysicalDevices(m_instance, &nbDevicesFound, devices.data());
 
-    int i = 0;
-    int selectedDevice = 0;
+    // Probing is only queries, do all the devices at once. Everything is kept, so nothing is queried again later.
+    std::vector<VulkanRenderer::PhysicalDeviceInfo> devicesInfo(devices.size());
+    auto probeRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            ProbePhysicalDevice(devices[i], devicesInfo[i]);
+    };
+
+    m_jobSystem->ParallelFor(devices.size(), 1, probeRange);
 
+    std::vector<int> candidates;
     for (int i = 0; i < (int)devices.size(); ++i)
     {
+        // Dumps are only built when they are written
         if (VulkanRenderer::Parameters().verbose())
-            std::cout << "Device " << i << ":" << std::endl;
+        {
+            LOG_VERBOSE("Device ", i, ":\n",
+                        VulkanRenderer::Utils::PhysicalDevicePropertiesDump(devicesInfo[i].properties), "\n",
+                        VulkanRenderer::Utils::PhysicalDeviceFeaturesDump(devicesInfo[i].features));
+        }
 
-        if (!IsSuitableDevice(devices[i]))
+        if (!devicesInfo[i].IsSuitable())
             continue;
 
         if (VulkanRenderer::Parameters().forceSelectedDevice.count() > 0 &&
             VulkanRenderer::Parameters().forceSelectedDevice() != i)
             continue;
 
-        if (m_physicalDevice == nullptr)
+        candidates.push_back(i);
+    }
+
+    // The fastest by default, whatever the enumeration order: hybrid laptops often list the integrated GPU first
+    std::vector<float> scores(devices.size(), 0.0f);
+    for (int i : candidates)
+    {
+        scores[i] = VulkanRenderer::Utils::ScorePhysicalDevice(devicesInfo[i]);
+        LOG_VERBOSE("Device ", i, " (", std::string(devicesInfo[i].properties.deviceName), ") score: ", scores[i]);
+    }
+
+    // Measures replace the estimates, when all the candidates that can be measured have one. The others (CPU
+    // implementations) rank after all the measured devices.
+    if (candidates.size() > 1)
+    {
+        VulkanRenderer::DeviceBenchmarkConfig config;
+        config.cacheFile = Cst::deviceBenchmarkFile;
+        config.computeShaderFile = Cst::deviceBenchmarkShaderFile;
+
+        VulkanRenderer::DeviceBenchmark benchmark(config);
+        const bool runBenchmark = VulkanRenderer::Parameters().benchmarkDevices().value_or(false);
+
+        std::vector<float> measuredScores(devices.size(), 0.0f);
+        bool allMeasured = true;
+        bool anyMeasured = false;
+        for (int i : candidates)
         {
-            selectedDevice = i;
-            m_physicalDevice = devices[i];
+            if (!VulkanRenderer::DeviceBenchmark::IsMeasurable(devicesInfo[i]))
+                continue;
+
+            VulkanRenderer::DeviceBenchmarkResult result;
+            const bool measured = benchmark.FindResult(devicesInfo[i], result) ||
+                                  (runBenchmark && benchmark.Run(devicesInfo[i], result));
+
+            allMeasured = allMeasured && measured;
+            anyMeasured = anyMeasured || measured;
+            measuredScores[i] = result.GetScore();
+        }
+
+        benchmark.Save();
+        if (allMeasured && anyMeasured)
+        {
+            LOG_VERBOSE("Devices ranked by their benchmark");
+            scores = std::move(measuredScores);
         }
     }
 
-    if (VulkanRenderer::Parameters().verbose())
+    int selectedDevice = -1;
+    for (int i : candidates)
+    {
+        if (selectedDevice < 0 || scores[i] > scores[selectedDevice])
+            selectedDevice = i;
+    }
+
+    LOG_VERBOSE("Selected device: ", selectedDevice);
+
+    if (selectedDevice < 0)
+    {
+        LOG_ERROR("Found no suitable physical devices.");
+        return -1;
+    }
+
+    m_deviceInfo = std::make_unique<VulkanRenderer::PhysicalDeviceInfo>(devicesInfo[selectedDevice]);
+    m_physicalDevice = m_deviceInfo->device;
+    m_bindlessSupported = m_deviceInfo->bindlessSupported;
+
+    LOG_VERBOSE("Bindless descriptors: ", m_bindlessSupported ? "supported" : "not supported");
+
+    m_pipelineLibraries = m_deviceInfo->pipelineLibrarySupported &&
+                          !VulkanRenderer::Parameters().monolithicPipelines().value_or(false);
+    LOG_VERBOSE("Graphics pipeline libraries: ",
+                m_deviceInfo->pipelineLibrarySupported ? "supported" : "not supported");
+
+    m_sampleCount = ChooseSampleCount(m_deviceInfo->properties.limits,
+                                      VulkanRenderer::Parameters().msaaSamples().value_or(1));
+    LOG_VERBOSE("MSAA samples: ", m_sampleCount);
+
+    // Not an error, the scene is then drawn without culling
+    m_occlusionCulling = VulkanRenderer::Parameters().occlusionCulling().value_or(false);
+    if (m_occlusionCulling && !(m_deviceInfo->properties.limits.sampledImageDepthSampleCounts & m_sampleCount))
+    {
+        LOG_WARNING("Depth buffers with ", m_sampleCount, " samples can't be sampled, occlusion culling disabled");
+        m_occlusionCulling = false;
+    }
+
+    VkFormat depthFormat = ChooseDepthFormat(m_physicalDevice, m_occlusionCulling);
+    if (depthFormat == VK_FORMAT_UNDEFINED && m_occlusionCulling)
     {
-        std::cout << "Selected device: " << selectedDevice << std::endl;
+        LOG_WARNING("No depth format can be sampled, occlusion culling disabled");
+        m_occlusionCulling = false;
+        depthFormat = ChooseDepthFormat(m_physicalDevice, false);
     }
 
-    if (m_physicalDevice == nullptr)
+    if (depthFormat == VK_FORMAT_UNDEFINED)
     {
-        std::cout << "Found no suitable physical devices." << std::endl;
+        LOG_ERROR("Found no supported depth format");
         return -1;
     }
 
+    m_depthFormat = depthFormat;
+    LOG_VERBOSE("Depth format: ", m_depthFormat, ", occlusion culling: ", m_occlusionCulling ? "on" : "off");
+
     return 0;
 }
 
 int Application::CreateLogicalDevice()
 {
-    QueueFamilyIndices indices = VulkanRenderer::FindQueueFamilies(m_physicalDevice, m_surface);
+    const QueueFamilyIndices& indices = m_deviceInfo->queueFamilies;
 
     // Store information on all queues we want to gather and their family queue index.
     // clang-format off
@@ -291,6 +816,10 @@ int Application::CreateLogicalDevice()
     };
     // clang-format on
 
+    // Compute work goes to the graphics queue when there is no dedicated family
+    if (indices.asyncComputeFamily.has_value())
+        allQueues.emplace_back(indices.asyncComputeFamily.value(), &m_computeQueue, "compute");
+
     // But each queue needs to have a unique family queue index.
     // It is possible for example that graphicQueue and presentQueue have the same
     // family queue index.
@@ -322,212 +851,913 @@ int Application::CreateLogicalDevice()
     // For now, not used
     VkPhysicalDeviceFeatures deviceFeatures{};
 
+    // Required extensions, plus the ones needed by optional capabilities
+    std::vector<const char*> extensions(Cst::deviceExtensions.begin(), Cst::deviceExtensions.end());
+
+    // Descriptor indexing features are chained if we support bindless
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = VulkanRenderer::BindlessHeap::GetRequiredFeatures();
+
     VkDeviceCreateInfo createDeviceInfo{};
     createDeviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createDeviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createDeviceInfo.pQueueCreateInfos = queueCreateInfos.data();
     createDeviceInfo.pEnabledFeatures = &deviceFeatures;
-    createDeviceInfo.enabledExtensionCount = static_cast<uint32_t>(Cst::deviceExtensions.size());
-    createDeviceInfo.ppEnabledExtensionNames = Cst::deviceExtensions.data();
+
+    if (m_bindlessSupported)
+    {
+        std::vector<const char*> bindlessExtensions =
+            VulkanRenderer::BindlessHeap::GetRequiredDeviceExtensions(m_physicalDevice);
+        extensions.insert(extensions.end(), bindlessExtensions.begin(), bindlessExtensions.end());
+        createDeviceInfo.pNext = &indexingFeatures;
+    }
+
+    // Lets the metrics report the memory used in each heap
+    if (m_deviceInfo->memoryBudgetSupported)
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // Pipelines are linked from parts compiled on their own
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures =
+        VulkanRenderer::PipelineRegistry::GetLibraryFeatures();
+    if (m_pipelineLibraries)
+    {
+        std::vector<const char*> libraryExtensions = VulkanRenderer::PipelineRegistry::GetLibraryDeviceExtensions();
+        extensions.insert(extensions.end(), libraryExtensions.begin(), libraryExtensions.end());
+        libraryFeatures.pNext = const_cast<void*>(createDeviceInfo.pNext);
+        createDeviceInfo.pNext = &libraryFeatures;
+    }
+
+    createDeviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createDeviceInfo.ppEnabledExtensionNames = extensions.data();
 
     if (vkCreateDevice(m_physicalDevice, &createDeviceInfo, nullptr, &m_device) != VK_SUCCESS)
     {
-        std::cout << "Failed to create a logical device" << std::endl;
+        LOG_ERROR("Failed to create a logical device");
         return -1;
     }
 
-    // When logical device is created, we need to get a handle on all the queues we requested
-    uint32_t i = 0;
+    // When logical device is created, we need to get a handle on all the queues we requested.
+    // A single queue is created per family, queues sharing a family share it.
     for (auto it : mapQueueIndexes)
     {
         for (auto queue : it.second)
         {
             VkQueue* vkQueue = std::get<VkQueue*>(queue);
-            vkGetDeviceQueue(m_device, std::get<uint32_t>(queue), static_cast<uint32_t>(i), vkQueue);
+            vkGetDeviceQueue(m_device, std::get<uint32_t>(queue), 0, vkQueue);
 
-            if (vkQueue == nullptr)
+            if (*vkQueue == VK_NULL_HANDLE)
             {
-                std::cout << "Failed to gather the " << std::get<const char*>(queue) << " queue" << std::endl;
+                LOG_ERROR("Failed to gather the ", std::get<const char*>(queue), " queue");
                 return -1;
             }
         }
-
-        i++;
     }
 
+    if (!indices.asyncComputeFamily.has_value())
+        m_computeQueue = m_graphicsQueue;
+
     return 0;
 }
 
-int Application::CreateSwapChain()
+int Application::CreateMainViewport()
 {
-    // To allow re-use of the swap chain, we will pass the old swap chain
-    // So it will create a new one (using the previous one) and destroy the previous one.
-    m_swapChain =
-        std::make_unique<VulkanRenderer::SwapChain>(m_device, m_physicalDevice, m_surface, m_window, m_swapChain.get());
-    return m_swapChain->IsValid() ? 0 : -1;
+    VulkanRenderer::ViewportConfig config;
+    config.instance = m_instance;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.queueFamilies = &m_deviceInfo->queueFamilies;
+    config.framesInFlight = maxFramesInFlight;
+    config.window = m_window;
+    config.surface = m_surface;
+    config.swapChainSupport = &m_deviceInfo->swapChainSupport;
+    config.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    config.depthFormat = static_cast<VkFormat>(m_depthFormat);
+    config.keepDepth = m_occlusionCulling;
+    config.framesInFlight = maxFramesInFlight;
+
+    // Owned by the viewport now, m_window is kept to know the main window
+    m_surface = VK_NULL_HANDLE;
+    config.id = m_nextViewportId++;
+    m_viewports.push_back(std::make_unique<VulkanRenderer::Viewport>(config));
+
+    return m_viewports.front()->IsValid() ? 0 : -1;
 }
 
-int Application::CreateGraphicPipeline()
+int Application::CreateOffscreenRenderPass()
 {
-    if (!m_swapChain)
-    {
-        return -1;
-    }
+    VulkanRenderer::SceneRenderPassDesc desc;
+    desc.colorFormat = m_viewports.front()->GetFormat();
+    desc.depthFormat = static_cast<VkFormat>(m_depthFormat);
+    desc.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    desc.depthPrepass = VulkanRenderer::Parameters().depthPrepass().value_or(false);
 
-    VulkanRenderer::GraphicPipelineConfig config;
-    config.device = m_device;
-    config.pipelineName = "main";
-    config.viewportHeight = m_height;
-    config.viewportWidth = m_width;
-    config.fragShaderFile = "shaders/simple.frag.spv";
-    config.vertShaderFile = "shaders/simple.vert.spv";
-    config.swapChainFormat = m_swapChain->GetFormat();
+    // Left ready to be copied once rendered
+    m_offscreenRenderPass = VulkanRenderer::RenderTarget::CreateRenderPass(
+        m_device, desc, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_occlusionCulling);
 
-    m_graphicPipeline = std::make_unique<VulkanRenderer::GraphicPipeline>(config);
-    return m_graphicPipeline->IsValid() ? 0 : -1;
+    return m_offscreenRenderPass != VK_NULL_HANDLE ? 0 : -1;
 }
 
-int Application::CreateFramebuffers()
+int Application::CreateViewports()
 {
-    if (!m_swapChain || !m_graphicPipeline)
+    const VkFormat format = m_viewports.front()->GetFormat();
+    const int windowCount = VulkanRenderer::Parameters().windowCount().value_or(1);
+    const int offscreenCount = VulkanRenderer::Parameters().offscreenViewports().value_or(0);
+
+    VulkanRenderer::ViewportConfig config;
+    config.instance = m_instance;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.queueFamilies = &m_deviceInfo->queueFamilies;
+    config.framesInFlight = maxFramesInFlight;
+    config.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    config.depthFormat = static_cast<VkFormat>(m_depthFormat);
+    config.keepDepth = m_occlusionCulling;
+
+    // Same size as the main window, they only differ by their camera
+    for (int i = 1; i < windowCount; ++i)
     {
-        return -1;
+        std::string windowName = std::string(m_windowName) + " " + std::to_string(i + 1);
+        GLFWwindow* window = glfwCreateWindow(m_width, m_height, windowName.c_str(), nullptr, nullptr);
+        if (window == nullptr)
+        {
+            LOG_ERROR("Failed to create window");
+            return -1;
+        }
+
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, FramebufferResizeCallback);
+        glfwSetKeyCallback(window, KeyCallback);
+
+        config.window = window;
+        config.surface = VK_NULL_HANDLE;
+        if (glfwCreateWindowSurface(m_instance, window, nullptr, &config.surface) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create the surface of window ", i + 1);
+            glfwDestroyWindow(window);
+            return -1;
+        }
+
+        config.id = m_nextViewportId++;
+        m_viewports.push_back(std::make_unique<VulkanRenderer::Viewport>(config));
+        VulkanRenderer::Viewport& viewport = *m_viewports.back();
+
+        // Pipelines are built for the main window format, a surface choosing another one can't use them
+        if (!viewport.IsValid() || viewport.GetFormat() != format ||
+            !viewport.CreateFramebuffers(m_graphicPipeline->GetRenderPass()))
+        {
+            LOG_ERROR("Window ", i + 1, " can't be rendered with the pipelines of the main window");
+            return -1;
+        }
     }
 
-    std::vector<VkImageView>& imageViews = m_swapChain->GetImageViews();
+    config.window = nullptr;
+    config.surface = VK_NULL_HANDLE;
+    config.offscreenRenderPass = m_offscreenRenderPass;
+    config.format = format;
+    config.extent = {static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height)};
 
-    m_framebuffers.resize(imageViews.size());
+    for (int i = 0; i < offscreenCount; ++i)
+    {
+        config.id = m_nextViewportId++;
+        m_viewports.push_back(std::make_unique<VulkanRenderer::Viewport>(config));
+        if (!m_viewports.back()->IsValid())
+            return -1;
+    }
 
-    VkFramebufferCreateInfo framebufferInfo{};
-    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    framebufferInfo.renderPass = m_graphicPipeline->GetRenderPass();
-    framebufferInfo.attachmentCount = 1;
-    framebufferInfo.width = m_swapChain->GetExtent().width;
-    framebufferInfo.height = m_swapChain->GetExtent().height;
-    framebufferInfo.layers = 1;
+    if (m_viewports.size() > 1)
+        LOG_VERBOSE("Viewports: ", windowCount, " windows, ", offscreenCount, " offscreen");
 
-    for (size_t i = 0; i < m_framebuffers.size(); ++i)
+    // Viewports the post-processing can't write into are rendered directly
+    if (m_postProcess)
     {
-        framebufferInfo.pAttachments = &imageViews[i];
+        for (uint32_t i = 0; i < m_viewports.size(); ++i)
+        {
+            const VulkanRenderer::Viewport& viewport = *m_viewports[i];
+            if (!(viewport.GetImageUsage() & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+            {
+                LOG_WARNING("Viewport ", i, " can't be post-processed");
+                continue;
+            }
+
+            if (!m_postProcess->PrepareTarget(viewport.GetId(), viewport.GetExtent()))
+                return -1;
+        }
+    }
 
-        if (vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &m_framebuffers[i]) != VK_SUCCESS)
+    // Every viewport is culled against its own depth
+    if (m_occlusionCuller)
+    {
+        for (const std::unique_ptr<VulkanRenderer::Viewport>& viewport : m_viewports)
         {
-            std::cout << "Failed to create framebuffers" << std::endl;
-            return -1;
+            if (!m_occlusionCuller->PrepareTarget(viewport->GetId(), viewport->GetExtent()))
+                return -1;
         }
     }
 
     return 0;
 }
 
-int Application::CreateCommandPool()
+int Application::CreateBindlessHeap()
 {
-    QueueFamilyIndices queueFamillyIndices = FindQueueFamilies(m_physicalDevice, m_surface);
+    // Not an error, we will fall back on regular descriptor sets
+    if (!m_bindlessSupported)
+        return 0;
 
-    VkCommandPoolCreateInfo commandPoolInfo{};
-    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    commandPoolInfo.queueFamilyIndex = queueFamillyIndices.graphicsFamily.value();
+    VulkanRenderer::BindlessHeapConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.maxTextures = Cst::bindlessMaxTextures;
+    config.maxStorageBuffers = Cst::bindlessMaxStorageBuffers;
+    config.framesInFlight = maxFramesInFlight;
 
-    if (vkCreateCommandPool(m_device, &commandPoolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
-    {
-        std::cout << "Failed to create command pool" << std::endl;
-        m_commandPool = VK_NULL_HANDLE;
-        return -1;
-    }
+    m_bindlessHeap = std::make_unique<VulkanRenderer::BindlessHeap>(config);
+    return m_bindlessHeap->IsValid() ? 0 : -1;
+}
+
+int Application::CreateMetrics()
+{
+    VulkanRenderer::MetricsConfig config;
+    config.memoryBudget = m_memoryBudget.get();
+    config.outputFile = VulkanRenderer::Parameters().metricsFile().value_or("");
+    config.writeInterval = Cst::metricsWriteInterval;
 
+    m_metrics = std::make_unique<VulkanRenderer::Metrics>(config);
     return 0;
 }
 
-int Application::CreateCommandBuffer()
+int Application::CreateMemoryBudget()
 {
-    if (!m_commandPool)
-    {
-        return -1;
-    }
-
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = m_commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(m_commandBuffers.size());
+    VulkanRenderer::MemoryBudgetConfig config;
+    config.physicalDevice = m_physicalDevice;
+    config.memoryBudgetSupported = m_deviceInfo->memoryBudgetSupported;
+    config.headroom = Cst::memoryBudgetHeadroom;
+    config.fallbackBudget = Cst::memoryFallbackBudget;
+    config.framesInFlight = maxFramesInFlight;
+
+    m_memoryBudget = std::make_unique<VulkanRenderer::MemoryBudget>(config);
+    return 0;
+}
 
-    if (vkAllocateCommandBuffers(m_device, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS)
+int Application::CreateFrameCapture()
+{
+    VulkanRenderer::FrameCaptureConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.jobSystem = m_jobSystem.get();
+    config.bufferCount = Cst::captureBufferCount;
+    config.outputFolder = VulkanRenderer::Parameters().captureFolder().value_or(Cst::defaultCaptureFolder);
+    config.format = VulkanRenderer::Parameters().captureRaw() ? VulkanRenderer::CaptureFormat::Raw
+                                                              : VulkanRenderer::CaptureFormat::Png;
+
+    m_frameCapture = std::make_unique<VulkanRenderer::FrameCapture>(config);
+
+    // Not an error, the application runs the same without captures
+    const VulkanRenderer::Viewport& mainViewport = *m_viewports.front();
+    if (!(mainViewport.GetImageUsage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) ||
+        !VulkanRenderer::FrameCapture::IsFormatSupported(mainViewport.GetFormat()))
     {
-        std::cout << "Failed to allocate command buffer." << std::endl;
-        return -1;
+        LOG_WARNING("Swap chain images can't be captured on this surface");
     }
 
     return 0;
 }
 
-int Application::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+int Application::CreateRenderServer()
 {
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = 0;                  // Optional
-    beginInfo.pInheritanceInfo = nullptr; // Only relevant for secondary command buffers
+    const auto& socketPath = VulkanRenderer::Parameters().serverSocket();
+    if (!socketPath)
+        return 0;
 
-    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    // Targets use the main window format, so they are compatible with the pipelines already built
+    const VkFormat format = m_viewports.front()->GetFormat();
+    if (!VulkanRenderer::FrameCapture::IsFormatSupported(format))
     {
-        std::cout << "Failed to begin command buffer" << std::endl;
+        LOG_ERROR("The render server can't read back images of format ", format);
         return -1;
     }
 
-    // Then we begin a render pass
-    VkRenderPassBeginInfo renderBeginInfo{};
-    renderBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderBeginInfo.renderPass = m_graphicPipeline->GetRenderPass();
-    renderBeginInfo.framebuffer = m_framebuffers[imageIndex];
-    renderBeginInfo.renderArea.offset = {0, 0};
-    renderBeginInfo.renderArea.extent = m_swapChain->GetExtent();
+    m_serverEncodings = std::make_unique<VulkanRenderer::JobCounter>();
 
-    // Turquoise: #40e0d0, with alpha 0.7
-    static constexpr VkClearValue clearColor = {{{64.f / 255.f, 224.f / 255.f, 208.f / 255.f, 0.7f}}};
+    const VkPhysicalDeviceLimits& limits = m_deviceInfo->properties.limits;
 
-    renderBeginInfo.clearValueCount = 1;
-    renderBeginInfo.pClearValues = &clearColor;
+    VulkanRenderer::RenderServerConfig config;
+    config.socketPath = *socketPath;
+    config.maxImageSize = std::min({Cst::serverMaxImageSize, limits.maxImageDimension2D, limits.maxFramebufferWidth,
+                                    limits.maxFramebufferHeight});
+    config.maxFrameCount = Cst::serverMaxFrameCount;
+
+    m_renderServer = std::make_unique<VulkanRenderer::RenderServer>(config);
+    if (!m_renderServer->IsValid())
+        return -1;
+
+    LOG_INFO("Render server listening on ", *socketPath);
+    return 0;
+}
+
+int Application::CreateDescriptorAllocator()
+{
+    m_descriptorLayoutCache = std::make_unique<VulkanRenderer::DescriptorLayoutCache>(m_device);
+
+    VulkanRenderer::DescriptorAllocatorConfig config;
+    config.device = m_device;
+    config.framesInFlight = maxFramesInFlight;
+    config.initialSetsPerPool = Cst::descriptorSetsPerPool;
+    config.maxSetsPerPool = Cst::maxDescriptorSetsPerPool;
+
+    m_descriptorAllocator = std::make_unique<VulkanRenderer::DescriptorAllocator>(config);
+    return 0;
+}
+
+int Application::CreateUniformRing()
+{
+    VulkanRenderer::UniformRingConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.layoutCache = m_descriptorLayoutCache.get();
+    config.descriptorAllocator = m_descriptorAllocator.get();
+    config.sizePerFrame = Cst::uniformRingSizePerFrame;
+    config.bindingRange = Cst::uniformRingBindingRange;
+    config.framesInFlight = maxFramesInFlight;
+
+    m_uniformRing = std::make_unique<VulkanRenderer::UniformRing>(config);
+    if (!m_uniformRing->IsValid())
+        return -1;
+
+    // Draws are recorded through the list, with the per draw data in the ring
+    m_drawList = std::make_unique<VulkanRenderer::DrawList>();
+    return 0;
+}
+
+int Application::CreateGraphicPipeline()
+{
+    if (m_viewports.empty())
+    {
+        return -1;
+    }
+
+    VulkanRenderer::GraphicPipelineConfig config;
+    config.device = m_device;
+    config.pipelineName = "main";
+    config.viewportHeight = m_height;
+    config.viewportWidth = m_width;
+    config.fragShaderFile = Cst::fragShaderFile;
+    config.vertShaderFile = Cst::vertShaderFile;
+    config.fragShaderCode = &m_fragShaderCode;
+    config.vertShaderCode = &m_vertShaderCode;
+    config.registry = m_pipelineRegistry.get();
+    config.swapChainFormat = m_viewports.front()->GetFormat();
+    config.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    config.depthFormat = static_cast<VkFormat>(m_depthFormat);
+    config.depthPrepass = VulkanRenderer::Parameters().depthPrepass().value_or(false);
+    config.keepDepth = m_occlusionCulling;
+
+    // Set 0 is the bindless set when available, otherwise an empty set to keep the other indices stable
+    config.descriptorSetLayouts.resize(2);
+    config.descriptorSetLayouts[VulkanRenderer::bindlessSetIndex] =
+        m_bindlessHeap ? m_bindlessHeap->GetLayout() : m_descriptorLayoutCache->GetLayout({});
+    config.descriptorSetLayouts[VulkanRenderer::objectSetIndex] = m_uniformRing->GetLayout();
+
+    VkPushConstantRange cameraRange{};
+    cameraRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    cameraRange.offset = 0;
+    cameraRange.size = sizeof(VulkanRenderer::CameraData);
+    config.pushConstantRanges.push_back(cameraRange);
+
+    // Features can be forced from the command line, to check a variant
+    const auto& forcedFeatures = VulkanRenderer::Parameters().shaderFeatures();
+    config.defaultFeatures = VulkanRenderer::ShaderFeatureBit(VulkanRenderer::ShaderFeature::VertexColor);
+    if (forcedFeatures)
+        config.defaultFeatures = static_cast<VulkanRenderer::ShaderFeatureMask>(*forcedFeatures);
+
+    m_graphicPipeline = std::make_unique<VulkanRenderer::GraphicPipeline>(config);
+    return m_graphicPipeline->IsValid() ? 0 : -1;
+}
+
+int Application::CreatePostProcess()
+{
+    const auto& effectsParameter = VulkanRenderer::Parameters().postProcess();
+
+    VulkanRenderer::PostEffectMask effects = 0;
+    if (effectsParameter && !VulkanRenderer::PostProcess::ParseEffects(*effectsParameter, effects))
+        return -1;
+
+    // Scenes rendered at a lower resolution are upscaled by the post-processing, even with no effect
+    if (effects == 0 && !VulkanRenderer::Parameters().dynamicResolution())
+        return 0;
+
+    VulkanRenderer::PostProcessConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.pipelineCache = m_pipelineCache->GetCache();
+    config.layoutCache = m_descriptorLayoutCache.get();
+    config.shaderFile = Cst::postProcessShaderFile;
+    config.sceneFormat = m_viewports.front()->GetFormat();
+    config.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    config.depthFormat = static_cast<VkFormat>(m_depthFormat);
+    config.depthPrepass = VulkanRenderer::Parameters().depthPrepass().value_or(false);
+    config.keepDepth = m_occlusionCulling;
+    config.effects = effects;
+
+    m_postProcess = std::make_unique<VulkanRenderer::PostProcess>(config);
+    return m_postProcess->IsValid() ? 0 : -1;
+}
+
+int Application::CreateDynamicResolution()
+{
+    const auto& targetFrameTime = VulkanRenderer::Parameters().dynamicResolution();
+    if (!targetFrameTime)
+        return 0;
+
+    if (*targetFrameTime <= 0.f)
+    {
+        LOG_ERROR("The dynamic resolution frame time must be positive");
+        return -1;
+    }
+
+    // Timestamps are written on the graphics queue
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &familyCount, families.data());
+
+    VulkanRenderer::DynamicResolutionConfig config;
+    config.device = m_device;
+    config.timestampPeriod = m_deviceInfo->properties.limits.timestampPeriod;
+    config.timestampValidBits = families[m_deviceInfo->queueFamilies.graphicsFamily.value()].timestampValidBits;
+    config.framesInFlight = maxFramesInFlight;
+    config.targetFrameTime = *targetFrameTime;
+    config.minScale = Cst::dynamicResolutionMinScale;
+    config.maxScale = Cst::dynamicResolutionMaxScale;
+
+    m_dynamicResolution = std::make_unique<VulkanRenderer::DynamicResolution>(config);
+    return m_dynamicResolution->IsValid() ? 0 : -1;
+}
+
+int Application::CreateShaderReloader()
+{
+    if (!VulkanRenderer::Parameters().hotReload().value_or(false))
+        return 0;
+
+    VulkanRenderer::ShaderReloaderConfig config;
+    config.sourceFolder = Cst::shaderSourceFolder;
+    config.cacheFolder = Cst::shaderCacheFolder;
+    config.compiler = Cst::shaderCompiler;
+    config.shaders = {Cst::vertShaderSource, Cst::fragShaderSource};
+
+    m_shaderReloader = std::make_unique<VulkanRenderer::ShaderReloader>(config);
+    m_programBuild = std::make_unique<VulkanRenderer::JobCounter>();
+    return m_shaderReloader->IsValid() ? 0 : -1;
+}
+
+int Application::CreateOcclusionCuller()
+{
+    if (!m_occlusionCulling)
+        return 0;
+
+    VulkanRenderer::OcclusionCullerConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.pipelineCache = m_pipelineCache->GetCache();
+    config.layoutCache = m_descriptorLayoutCache.get();
+    config.uniformRingLayout = m_uniformRing->GetLayout();
+    config.cullShaderFile = Cst::occlusionCullShaderFile;
+    config.pyramidShaderFile = Cst::depthPyramidShaderFile;
+    config.pyramidMultisampleShaderFile = Cst::depthPyramidMultisampleShaderFile;
+    config.depthSamples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    config.framesInFlight = maxFramesInFlight;
+
+    m_occlusionCuller = std::make_unique<VulkanRenderer::OcclusionCuller>(config);
+    return m_occlusionCuller->IsValid() ? 0 : -1;
+}
+
+int Application::CreateParticleSystem()
+{
+    const auto& particles = VulkanRenderer::Parameters().particles();
+    if (!particles || *particles <= 0)
+        return 0;
+
+    VulkanRenderer::ParticleSystemConfig config;
+    config.device = m_device;
+    config.physicalDevice = m_physicalDevice;
+    config.pipelineCache = m_pipelineCache->GetCache();
+    config.layoutCache = m_descriptorLayoutCache.get();
+    config.registry = m_pipelineRegistry.get();
+    // Drawn with the scene, after the depth when it has its own pass
+    config.renderPass = m_graphicPipeline->GetRenderPass();
+    config.subpass = m_graphicPipeline->HasDepthPrepass() ? 1 : 0;
+    config.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+    config.emitShaderFile = Cst::particleEmitShaderFile;
+    config.simulateShaderFile = Cst::particleSimulateShaderFile;
+    config.controlShaderFile = Cst::particleControlShaderFile;
+    config.vertShaderFile = Cst::particleVertShaderFile;
+    config.fragShaderFile = Cst::particleFragShaderFile;
+    config.capacity = static_cast<uint32_t>(*particles);
+    config.maxEmitters = Cst::particleMaxEmitters;
+    config.gravity = glm::vec3(0.f, Cst::particleGravity, 0.f);
+    config.drag = Cst::particleDrag;
+
+    m_particleSystem = std::make_unique<VulkanRenderer::ParticleSystem>(config);
+    if (!m_particleSystem->IsValid())
+        return -1;
+
+    // Fountains around the triangle, emitting just enough to keep the pool full
+    const float rate = static_cast<float>(config.capacity) / (Cst::particleEmitterCount * Cst::particleLifetime);
+    for (uint32_t i = 0; i < Cst::particleEmitterCount; ++i)
+    {
+        const float angle = glm::two_pi<float>() * i / Cst::particleEmitterCount;
+        const glm::vec3 position(std::cos(angle), -0.5f, std::sin(angle));
+
+        VulkanRenderer::ParticleEmitterData emitter{};
+        emitter.positionRadius = glm::vec4(position, 0.05f);
+        emitter.velocitySpread = glm::vec4(0.f, 0.8f, 0.f, 0.2f);
+        emitter.colorSize = glm::vec4(0.5f + 0.5f * position.x, 0.4f, 0.5f + 0.5f * position.z, 0.01f);
+        emitter.rate = rate;
+        emitter.lifetime = Cst::particleLifetime;
+
+        m_particleSystem->AddEmitter(emitter);
+    }
+
+    return 0;
+}
+
+int Application::CreateScene()
+{
+    m_scene = std::make_unique<VulkanRenderer::Scene>(*m_jobSystem);
+
+    // For now, a root and our triangle
+    VulkanRenderer::EntityId root = m_scene->CreateNode();
+    VulkanRenderer::EntityId triangle = m_scene->CreateNode(root);
+
+    m_scene->SetBounds(triangle, VulkanRenderer::Bounds{glm::vec3(0.f), 0.5f});
+
+    VulkanRenderer::RenderComponent component;
+    component.features = m_graphicPipeline->GetDefaultFeatures();
+    m_scene->SetRenderComponent(triangle, component);
+
+    return 0;
+}
+
+int Application::CreateFramebuffers()
+{
+    if (m_viewports.empty() || !m_graphicPipeline)
+    {
+        return -1;
+    }
+
+    // The other viewports are created once the pipeline exists, with their framebuffers
+    return m_viewports.front()->CreateFramebuffers(m_graphicPipeline->GetRenderPass()) ? 0 : -1;
+}
+
+int Application::CreateCommandPool()
+{
+    const QueueFamilyIndices& queueFamillyIndices = m_deviceInfo->queueFamilies;
+
+    VkCommandPoolCreateInfo commandPoolInfo{};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamillyIndices.graphicsFamily.value();
+
+    if (vkCreateCommandPool(m_device, &commandPoolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create command pool");
+        m_commandPool = VK_NULL_HANDLE;
+        return -1;
+    }
+
+    return 0;
+}
+
+int Application::CreateComputeScheduler()
+{
+    const QueueFamilyIndices& indices = m_deviceInfo->queueFamilies;
+
+    VulkanRenderer::ComputeSchedulerConfig config;
+    config.device = m_device;
+    config.queue = m_computeQueue;
+    config.queueFamily = indices.asyncComputeFamily.value_or(indices.graphicsFamily.value());
+    config.graphicsFamily = indices.graphicsFamily.value();
+    config.framesInFlight = maxFramesInFlight;
+
+    m_computeScheduler = std::make_unique<VulkanRenderer::ComputeScheduler>(config);
+
+    return m_computeScheduler->IsValid() ? 0 : -1;
+}
+
+int Application::CreateCommandBuffer()
+{
+    if (!m_commandPool)
+    {
+        return -1;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(m_commandBuffers.size());
+
+    if (vkAllocateCommandBuffers(m_device, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to allocate command buffer.");
+        return -1;
+    }
+
+    return 0;
+}
+
+int Application::RecordCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    PROFILE_FUNCTION();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = 0;                  // Optional
+    beginInfo.pInheritanceInfo = nullptr; // Only relevant for secondary command buffers
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to begin command buffer");
+        return -1;
+    }
+
+    // The GPU time of the last use of this command buffer sets the resolution of this frame
+    if (m_dynamicResolution)
+    {
+        m_dynamicResolution->BeginFrame(m_currentFrame);
+        m_dynamicResolution->RecordStart(commandBuffer, m_currentFrame);
+
+        using VulkanRenderer::Gauge;
+        m_metrics->Set(Gauge::GpuFrameMicroseconds, m_dynamicResolution->GetLastFrameMicroseconds());
+        m_metrics->Set(Gauge::RenderScalePercent,
+                       static_cast<uint64_t>(m_dynamicResolution->GetScale() * 100.f + 0.5f));
+    }
+
+    // Instances culled by every viewport, their draws start with everything visible
+    const std::vector<VulkanRenderer::InstanceData>& instances = m_scene->GetInstances();
+    if (m_occlusionCuller)
+    {
+        VkDrawIndirectCommand* draws = m_occlusionCuller->BeginFrame(m_currentFrame, instances);
+        if (!draws)
+            return -1;
+
+        for (size_t i = 0; i < instances.size(); ++i)
+            draws[i] = {3, 1, 0, 0}; // Only our triangle for now, hardcoded in the shader
+    }
+
+    // Simulated once for all the viewports, on the compute queue when the device has one. The render passes only
+    // wait for it at the stages drawing the particles.
+    if (m_particleSystem)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const float deltaTime = m_lastUpdateTime == std::chrono::steady_clock::time_point{}
+                                    ? 0.f
+                                    : std::chrono::duration<float>(now - m_lastUpdateTime).count();
+        m_lastUpdateTime = now;
+
+        if (!m_particleSystem->RecordUpdate(*m_computeScheduler, deltaTime, *m_descriptorAllocator))
+            return -1;
+
+        m_computeScheduler->RecordGraphicsAcquire(commandBuffer);
+    }
+
+    // One render pass per viewport, they all share the pipelines and the per frame resources
+    for (uint32_t viewportIndex : m_frameViewports)
+    {
+        const VulkanRenderer::Viewport& viewport = *m_viewports[viewportIndex];
+        const uint32_t viewportId = viewport.GetId();
+        const bool postProcessed = m_postProcess && m_postProcess->HasTarget(viewportId);
+
+        // Only the scenes rendered in a target can be upscaled
+        const VkExtent2D renderExtent = postProcessed && m_dynamicResolution && m_postProcess->CanUpscale()
+                                            ? m_dynamicResolution->GetRenderExtent(viewport.GetExtent())
+                                            : viewport.GetExtent();
+
+        // Culled against the depth of its last frame, before its render pass starts
+        VkBuffer drawBuffer = VK_NULL_HANDLE;
+        if (m_occlusionCuller)
+        {
+            if (!m_occlusionCuller->RecordCull(commandBuffer, viewportId, viewport.GetCamera().viewProj,
+                                               *m_uniformRing, *m_descriptorAllocator))
+                return -1;
+
+            drawBuffer = m_occlusionCuller->GetDrawBuffer(viewportId);
+        }
+
+        // Post-processed viewports render the scene in their own target first, the result is blitted into them
+        if (postProcessed)
+        {
+            if (RecordScene(commandBuffer, m_postProcess->GetSceneRenderPass(),
+                            m_postProcess->GetSceneFramebuffer(viewportId), renderExtent, viewport.GetCamera(),
+                            drawBuffer) != 0)
+                return -1;
+        }
+        else if (RecordScene(commandBuffer, viewport.GetRenderPass(), viewport.GetFramebuffer(),
+                             viewport.GetExtent(), viewport.GetCamera(), drawBuffer) != 0)
+        {
+            return -1;
+        }
+
+        // For the next frame, the render pass left the depth readable
+        if (m_occlusionCuller)
+        {
+            VkImageView depthView = postProcessed ? m_postProcess->GetSceneDepthView(viewportId)
+                                                  : viewport.GetDepthView();
+            if (!m_occlusionCuller->RecordPyramid(commandBuffer, viewportId, depthView, renderExtent,
+                                                  viewport.GetCamera().viewProj, *m_descriptorAllocator))
+                return -1;
+        }
+
+        if (postProcessed && !m_postProcess->Record(commandBuffer, viewportId, *m_descriptorAllocator,
+                                                    static_cast<uint32_t>(m_frameNumber), renderExtent,
+                                                    viewport.GetImage(), viewport.GetFinalLayout()))
+            return -1;
+    }
+
+    // The copy is read back once this frame's fence is waited on again, encoding runs on the workers
+    if (VulkanRenderer::Parameters().captureFolder() || m_captureRequested)
+    {
+        m_captureRequested = false;
+
+        for (uint32_t viewportIndex : m_frameViewports)
+        {
+            const VulkanRenderer::Viewport& viewport = *m_viewports[viewportIndex];
+            if (!(viewport.GetImageUsage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+                continue;
+
+            m_frameCapture->RecordCopy(commandBuffer, m_currentFrame, m_frameNumber, viewport.GetId(),
+                                       viewport.GetImage(), viewport.GetFormat(), viewport.GetExtent(),
+                                       viewport.GetFinalLayout());
+        }
+    }
+
+    if (m_dynamicResolution)
+        m_dynamicResolution->RecordEnd(commandBuffer, m_currentFrame);
+
+    // The next compute work updates the particles again
+    m_computeScheduler->RecordGraphicsRelease(commandBuffer);
+
+    // We can also end the command buffer
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to end command buffer");
+        return -1;
+    }
+
+    return 0;
+}
+
+int Application::RecordGraphicsHandback(VkCommandBuffer commandBuffer)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to begin command buffer");
+        return -1;
+    }
+
+    m_computeScheduler->RecordGraphicsAcquire(commandBuffer);
+    m_computeScheduler->RecordGraphicsRelease(commandBuffer);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to end command buffer");
+        return -1;
+    }
+
+    return 0;
+}
+
+int Application::RecordScene(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer,
+                             const VkExtent2D& extent, const VulkanRenderer::CameraData& camera, VkBuffer drawBuffer)
+{
+    // Then we begin a render pass
+    VkRenderPassBeginInfo renderBeginInfo{};
+    renderBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderBeginInfo.renderPass = renderPass;
+    renderBeginInfo.framebuffer = framebuffer;
+    renderBeginInfo.renderArea.offset = {0, 0};
+    renderBeginInfo.renderArea.extent = extent;
+
+    // Turquoise: #40e0d0, with alpha 0.7. Reverse-Z: the depth is cleared to the far plane, at 0.
+    // Same order as the attachments, the resolve one is not cleared.
+    std::array<VkClearValue, 2> clearValues{};
+    clearValues[0].color = {{64.f / 255.f, 224.f / 255.f, 208.f / 255.f, 0.7f}};
+    clearValues[1].depthStencil = {0.f, 0};
+
+    renderBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderBeginInfo.pClearValues = clearValues.data();
 
     // Start render pass!
     vkCmdBeginRenderPass(commandBuffer, &renderBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicPipeline->GetPipeline());
+
+    // All the resources are reachable through the bindless set, so bind it once for the whole frame
+    VkPipelineLayout pipelineLayout = m_graphicPipeline->GetPipelineLayout();
+    if (m_bindlessHeap)
+        m_bindlessHeap->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+                             VulkanRenderer::bindlessSetIndex);
+
+    // Camera is common to all draws
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(camera), &camera);
 
     // Viewport and scissors were marked dynamic, so set them here
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = static_cast<float>(m_swapChain->GetExtent().width);
-    viewport.height = static_cast<float>(m_swapChain->GetExtent().height);
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
     vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
     VkRect2D scissor{};
     scissor.offset = {0, 0};
-    scissor.extent = m_swapChain->GetExtent();
+    scissor.extent = extent;
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-    // Let's draw our triangle!
-    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+    // Let's draw our scene!
+    // Draws are sorted by state, so the list only binds what changes between two draws.
+    m_drawList->Clear();
 
-    // And finish the render pass
-    vkCmdEndRenderPass(commandBuffer);
+    const bool depthPrepass = m_graphicPipeline->HasDepthPrepass();
+    const std::vector<VulkanRenderer::InstanceData>& instances = m_scene->GetInstances();
 
-    // We can also end the command buffer
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    for (uint32_t i = 0; i < instances.size(); ++i)
     {
-        std::cout << "Failed to end command buffer" << std::endl;
-        return -1;
+        const VulkanRenderer::InstanceData& instance = instances[i];
+
+        // Per draw data is written straight in the mapped ring, and bound with a dynamic offset
+        VulkanRenderer::RingAllocation objectAllocation =
+            m_uniformRing->Push(VulkanRenderer::ObjectData{instance.model});
+        if (!objectAllocation.IsValid())
+            return -1;
+
+        VulkanRenderer::DrawCommand command;
+        command.pipeline = m_graphicPipeline->GetPipeline(instance.features);
+        command.pipelineLayout = pipelineLayout;
+        command.objectOffset = objectAllocation.offset;
+        command.vertexCount = 3; // Only our triangle for now, hardcoded in the shader
+        command.key = VulkanRenderer::MakeSortKey(Cst::colorPassKey, instance.features, instance.material,
+                                                  instance.mesh, 0.f);
+
+        // Same draw for both passes, hidden instances are left with no instance by the culling
+        if (drawBuffer != VK_NULL_HANDLE)
+        {
+            command.indirectBuffer = drawBuffer;
+            command.indirectOffset = VulkanRenderer::OcclusionCuller::GetDrawOffset(i);
+        }
+
+        if (command.pipeline == VK_NULL_HANDLE)
+            continue;
+
+        m_drawList->Add(command);
+
+        // Materials don't matter to the depth, only what moves the vertices
+        if (depthPrepass)
+        {
+            command.pipeline = m_graphicPipeline->GetDepthPipeline(instance.features);
+            command.key =
+                VulkanRenderer::MakeSortKey(Cst::depthPrepassKey, instance.features, 0, instance.mesh, 0.f);
+
+            if (command.pipeline != VK_NULL_HANDLE)
+                m_drawList->Add(command);
+        }
     }
 
+    m_drawList->Sort();
+
+    // The depth first, then the color where it matches, each pixel is shaded once
+    VulkanRenderer::DrawListStats drawStats;
+    if (depthPrepass)
+    {
+        drawStats += m_drawList->Record(commandBuffer, *m_uniformRing, VulkanRenderer::objectSetIndex,
+                                        Cst::depthPrepassKey);
+        vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    drawStats +=
+        m_drawList->Record(commandBuffer, *m_uniformRing, VulkanRenderer::objectSetIndex, Cst::colorPassKey);
+
+    // Blended over the scene, they don't write the depth
+    if (m_particleSystem)
+        m_particleSystem->RecordDraw(commandBuffer, camera);
+
+    using VulkanRenderer::Counter;
+    m_metrics->Add(Counter::Draws, drawStats.draws);
+    m_metrics->Add(Counter::Triangles, drawStats.triangles);
+    m_metrics->Add(Counter::PipelineBinds, drawStats.pipelineBinds);
+    m_metrics->Add(Counter::DescriptorBinds, drawStats.descriptorBinds);
+
+    // And finish the render pass
+    vkCmdEndRenderPass(commandBuffer);
+
     return 0;
 }
 
 int Application::CreateSyncObjects()
 {
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
     VkFenceCreateInfo fenceInfo{};
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     // Create the fence signaled to avoid blocking on the first frame!
@@ -535,11 +1765,9 @@ int Application::CreateSyncObjects()
 
     for (int i = 0; i < maxFramesInFlight; ++i)
     {
-        if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
+        if (vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
         {
-            std::cout << "Failed to initialize sync objects" << std::endl;
+            LOG_ERROR("Failed to initialize sync objects");
             return -1;
         }
     }
@@ -551,12 +1779,6 @@ int Application::Cleanup()
 {
     for (int i = 0; i < maxFramesInFlight; ++i)
     {
-        if (m_imageAvailableSemaphores[i])
-            vkDestroySemaphore(m_device, m_imageAvailableSemaphores[i], nullptr);
-
-        if (m_renderFinishedSemaphores[i])
-            vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
-
         if (m_inFlightFences[i])
             vkDestroyFence(m_device, m_inFlightFences[i], nullptr);
     }
@@ -564,17 +1786,59 @@ int Application::Cleanup()
     if (m_commandPool)
         vkDestroyCommandPool(m_device, m_commandPool, nullptr);
 
-    for (VkFramebuffer& framebuffer : m_framebuffers)
-    {
-        if (framebuffer != VK_NULL_HANDLE)
-            vkDestroyFramebuffer(m_device, framebuffer, nullptr);
-    }
+    m_computeScheduler.reset();
+
+    // Keep what the driver compiled for the next run
+    if (m_pipelineCache)
+        m_pipelineCache->Save(Cst::pipelineCacheFile);
 
-    m_framebuffers.clear();
+    // Server mode, RunServer already waited for the encodings
+    m_renderServer.reset();
+    m_pendingJobs.clear();
+    m_serverTargets.clear();
+    m_serverTargetEvictables.clear();
+    m_serverEncodings.reset();
+
+    // A program may still be building from reloaded shaders
+    if (m_programBuild)
+        m_jobSystem->Wait(*m_programBuild);
+
+    m_reloadedProgram.reset();
+    m_shaderReloader.reset();
 
     // We need to delete the swap chain and graphic pipeline before deleting the device.
+    m_particleSystem.reset();
     m_graphicPipeline.reset();
-    m_swapChain.reset();
+    if (m_pipelineRegistry)
+        LOG_VERBOSE("Graphics pipelines compiled: ", m_pipelineRegistry->GetCompileCount(), ", still alive: ",
+                    m_pipelineRegistry->GetPipelineCount());
+
+    m_pipelineRegistry.reset();
+    m_postProcess.reset();
+    m_occlusionCuller.reset();
+    m_dynamicResolution.reset();
+    m_pipelineCache.reset();
+    m_bindlessHeap.reset();
+    m_scene.reset();
+    m_drawList.reset();
+    m_metrics.reset();
+    m_memoryBudget.reset();
+    m_frameCapture.reset();
+    m_uniformRing.reset();
+    m_descriptorAllocator.reset();
+    m_descriptorLayoutCache.reset();
+
+    // Viewports own their window and surface, the main ones included once it is created
+    if (!m_viewports.empty())
+        m_window = nullptr;
+
+    m_frameViewports.clear();
+    m_viewports.clear();
+
+    if (m_offscreenRenderPass)
+        vkDestroyRenderPass(m_device, m_offscreenRenderPass, nullptr);
+
+    m_offscreenRenderPass = VK_NULL_HANDLE;
 
     if (m_device)
         vkDestroyDevice(m_device, nullptr);
@@ -582,56 +1846,68 @@ int Application::Cleanup()
     if (m_surface)
         vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
 
+    if (m_debugMessenger)
+    {
+        auto destroyDebugMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+            vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT"));
+        if (destroyDebugMessenger != nullptr)
+            destroyDebugMessenger(m_instance, m_debugMessenger, nullptr);
+
+        m_debugMessenger = VK_NULL_HANDLE;
+    }
+
     if (m_instance)
         vkDestroyInstance(m_instance, nullptr);
 
     if (m_window)
-    {
         glfwDestroyWindow(m_window);
-        glfwTerminate();
-    }
 
     m_window = nullptr;
+    glfwTerminate();
+
+    // No job should be running anymore, stop the workers
+    m_jobSystem.reset();
+
     m_initialized = false;
 
     return 0;
 }
 
-bool Application::IsSuitableDevice(VkPhysicalDevice device) const
+void Application::ProbePhysicalDevice(VkPhysicalDevice device, VulkanRenderer::PhysicalDeviceInfo& outInfo) const
 {
-    // Gather properties of the device
-    VkPhysicalDeviceProperties deviceProperties;
-    vkGetPhysicalDeviceProperties(device, &deviceProperties);
+    outInfo.device = device;
 
-    // Also gather features of the device
-    VkPhysicalDeviceFeatures deviceFeatures;
-    vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+    // Gather properties and features of the device
+    vkGetPhysicalDeviceProperties(device, &outInfo.properties);
+    vkGetPhysicalDeviceFeatures(device, &outInfo.features);
+    vkGetPhysicalDeviceMemoryProperties(device, &outInfo.memoryProperties);
 
-    if (VulkanRenderer::Parameters().verbose())
-    {
-        std::cout << VulkanRenderer::Utils::PhysicalDevicePropertiesDump(deviceProperties) << std::endl;
-        std::cout << VulkanRenderer::Utils::PhysicalDeviceFeaturesDump(deviceFeatures) << std::endl;
-    }
+    VkPhysicalDeviceIDProperties idProperties{};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
 
-    // TODO: Add more capabilities as we need it.
-    QueueFamilyIndices indices = VulkanRenderer::FindQueueFamilies(device, m_surface);
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(device, &properties2);
+    std::copy(std::begin(idProperties.deviceUUID), std::end(idProperties.deviceUUID), outInfo.uuid.begin());
 
-    // If we didn't found all our requested queue family, early out
-    if (!indices.IsComplete())
-        return false;
+    // TODO: Add more capabilities as we need it.
+    outInfo.queueFamilies = VulkanRenderer::FindQueueFamilies(device, m_surface);
 
-    // If the current device doesn't supported wanted extensions, early out
-    if (!CheckDeviceExtensionSupport(device))
-        return false;
+    // If we didn't found all our requested queue family, no need to go further
+    if (!outInfo.queueFamilies.IsComplete())
+        return;
 
-    // If the current device doesn't support all our swap chain requirements, early out
-    VulkanRenderer::SwapChainSupportDetails details{};
-    VulkanRenderer::SwapChain::FillSwapChainSupportDetails(device, m_surface, details);
+    outInfo.extensionsSupported = CheckDeviceExtensionSupport(device);
+    if (!outInfo.extensionsSupported)
+        return;
 
-    if (details.formats.empty() || details.presentModes.empty())
-        return false;
+    VulkanRenderer::SwapChain::FillSwapChainSupportDetails(device, m_surface, outInfo.swapChainSupport);
 
-    return true;
+    // Optional capabilities
+    outInfo.bindlessSupported = VulkanRenderer::BindlessHeap::IsSupported(device);
+    outInfo.memoryBudgetSupported = VulkanRenderer::MemoryBudget::IsMemoryBudgetSupported(device);
+    outInfo.pipelineLibrarySupported = VulkanRenderer::PipelineRegistry::IsLibrarySupported(device);
 }
 
 bool Application::CheckDeviceExtensionSupport(VkPhysicalDevice device) const
@@ -649,8 +1925,61 @@ bool Application::CheckDeviceExtensionSupport(VkPhysicalDevice device) const
     return nbFoundExtensions == static_cast<int>(Cst::deviceExtensions.size());
 }
 
+void Application::ReloadShaders()
+{
+    PROFILE_FUNCTION();
+
+    // Built on a worker during the previous frames, nothing is recorded with the current program at this point
+    if (m_programBuild->IsDone() && m_reloadedProgram)
+    {
+        m_graphicPipeline->SwapProgram(std::move(m_reloadedProgram));
+        LOG_INFO("Shaders reloaded");
+    }
+
+    m_shaderReloader->Poll();
+    for (auto& shader : m_shaderReloader->TakeCompiled())
+    {
+        if (shader.name == Cst::vertShaderSource)
+            m_vertShaderCode = std::move(shader.code);
+        else if (shader.name == Cst::fragShaderSource)
+            m_fragShaderCode = std::move(shader.code);
+
+        m_shaderCodeChanged = true;
+    }
+
+    // One build at a time, what changes meanwhile is built once it is done
+    if (!m_shaderCodeChanged || !m_programBuild->IsDone())
+        return;
+
+    m_shaderCodeChanged = false;
+
+    // The worker gets its own copies, and the variants in use now so the swap doesn't create any on the main thread
+    m_jobSystem->Run(
+        [this, vertCode = m_vertShaderCode, fragCode = m_fragShaderCode,
+         features = m_graphicPipeline->GetFeatureVariants()]()
+        {
+            PROFILE_SCOPE("Build reloaded shaders");
+            m_reloadedProgram = m_graphicPipeline->CreateProgram(vertCode, fragCode, features);
+            if (!m_reloadedProgram)
+                LOG_ERROR("Failed to build the reloaded shaders, the previous ones are kept");
+        },
+        m_programBuild.get());
+}
+
+void Application::BeginMemoryBudgetFrame()
+{
+    const VkDeviceSize evictedBefore = m_memoryBudget->GetEvictedBytes();
+    m_memoryBudget->BeginFrame();
+    m_metrics->Add(VulkanRenderer::Counter::EvictedBytes, m_memoryBudget->GetEvictedBytes() - evictedBefore);
+}
+
 int Application::DrawFrame()
 {
+    PROFILE_FUNCTION();
+
+    // Every frame is closed in the metrics, those skipped or failed too
+    VulkanRenderer::Utils::ScopeExit endMetricsFrame([this]() { m_metrics->EndFrame(); });
+
     // High level of a frame:
     // * Wait for the previous frame to finish
     // * Acquire an image from the swap chain
@@ -661,82 +1990,241 @@ int Application::DrawFrame()
     // Since all command as asynchronous with the GPU, we'll have to add synchronisation
     // primitives, such as Semaphores or Fences
 
+    // Scene update doesn't touch any GPU resource, so do it before waiting on the GPU
+    {
+        PROFILE_SCOPE("Scene update");
+        m_scene->Update();
+    }
+
     // At the start of our frame, we wait until the previous frame has rendered
-    vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    {
+        PROFILE_SCOPE("Wait for fence");
+        auto waitStart = std::chrono::steady_clock::now();
+        vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+
+        auto waitTime = std::chrono::steady_clock::now() - waitStart;
+        m_metrics->Add(VulkanRenderer::Counter::FenceWaitMicroseconds,
+                       std::chrono::duration_cast<std::chrono::microseconds>(waitTime).count());
+    }
 
-    // Acquire an image from the swap chain, will signal the semaphore when it's done.
-    // We use no fences here.
-    uint32_t imageIndex = 0;
-    VkResult result = vkAcquireNextImageKHR(m_device, m_swapChain->GetSwapChain(), UINT64_MAX,
-                                            m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+    // Frame boundary: the pipelines are only used by the frames in flight, they can be swapped
+    m_pipelineRegistry->BeginFrame();
+    m_graphicPipeline->BeginFrame();
+    BeginMemoryBudgetFrame();
+    if (m_shaderReloader)
+        ReloadShaders();
 
-    // When we acquire the next image, we swap chain might be out of date,
-    // in that case, we recreate it and exit
-    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    // Acquire an image from each window, will signal their semaphore when it's done. We use no fences here.
+    // A window out of date is recreated and skipped this frame, the other viewports still render.
+    m_frameViewports.clear();
     {
-        RecreateSwapChain();
-        return 0;
+        PROFILE_SCOPE("Acquire image");
+
+        for (uint32_t i = 0; i < m_viewports.size(); ++i)
+        {
+            VkResult result = m_viewports[i]->AcquireImage(m_currentFrame);
+
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                if (RecreateSwapChain(*m_viewports[i]) != 0)
+                    return -1;
+            }
+            else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+            {
+                // We can also have a suboptimal swap chain, but that's OK, we can still use it.
+                // If it is either a success nor a suboptimal, we need to exit.
+                LOG_ERROR("Failed to acquire swap chain image");
+                return -1;
+            }
+            else
+            {
+                m_frameViewports.push_back(i);
+            }
+        }
     }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+
+    // All minimized, nothing to do until a window comes back
+    if (m_frameViewports.empty())
     {
-        // We can also have a suboptimal swap chain, but that's OK, we can still use it.
-        // If it is either a success nor a suboptimal, we need to exit.
-        std::cout << "Failed to acquire swap chain image" << std::endl;
-        return -1;
+        glfwWaitEvents();
+        return 0;
     }
 
-    // Reset fences only after we know we don't have to recreate the swap chain, to avoid a deadlock
+    // Reset fences only after we know we submit something, to avoid a deadlock
     vkResetFences(m_device, 1, &m_inFlightFences[m_currentFrame]);
 
+    // The GPU is done with this frame, bindless indices released back then can be reused
+    if (m_bindlessHeap)
+        m_bindlessHeap->BeginFrame(m_currentFrame);
+
+    // Same for all the descriptor sets allocated for this frame, and its region of the uniform ring
+    m_descriptorAllocator->BeginFrame(m_currentFrame);
+    m_uniformRing->BeginFrame(m_currentFrame);
+    m_frameCapture->BeginFrame(m_currentFrame);
+    m_computeScheduler->BeginFrame(m_currentFrame);
+
     vkResetCommandBuffer(m_commandBuffers[m_currentFrame], 0);
 
-    RecordCommandBuffer(m_commandBuffers[m_currentFrame], imageIndex);
+    // A failure leaves the command buffer recording, it can't be submitted. The frame is dropped, but still
+    // submitted empty below: the fence must be signaled and the acquired images waited on.
+    bool recorded = RecordCommandBuffer(m_commandBuffers[m_currentFrame]) == 0;
+    if (!recorded)
+    {
+        LOG_ERROR("Failed to record the frame, it is dropped");
+        vkEndCommandBuffer(m_commandBuffers[m_currentFrame]);
+    }
+
+    // Compute work recorded this frame goes first, on its own queue when the device has one. Graphics only waits
+    // for it where its results are read. When it fails, the buffers it hands over were never released: the frame
+    // acquiring them is dropped too.
+    VkSemaphore computeFinished = VK_NULL_HANDLE;
+    if (!m_computeScheduler->Submit(computeFinished) && recorded)
+    {
+        LOG_ERROR("Failed to submit the compute work, the frame is dropped");
+        recorded = false;
+    }
+
+    bool handedBack = recorded;
+    if (!recorded)
+    {
+        vkResetCommandBuffer(m_commandBuffers[m_currentFrame], 0);
+        m_frameCapture->DiscardFrame(m_currentFrame);
+
+        // Buffers the compute work handed over must still go back to it, in a command buffer with only that
+        if (m_computeScheduler->HasGraphicsHandoff())
+            handedBack = RecordGraphicsHandback(m_commandBuffers[m_currentFrame]) == 0;
+    }
+
+    // Totals of the frame, all the viewports included
+    m_metrics->Add(VulkanRenderer::Counter::BytesUploaded, m_uniformRing->GetUsedBytes());
+    m_metrics->Add(VulkanRenderer::Counter::DescriptorAllocations, m_descriptorAllocator->GetFrameAllocationCount());
+
+    // A single submission for all the viewports: it waits for all the acquired images, and signals each window
+    // when it can be presented
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
+    std::vector<VkSemaphore> signalSemaphores;
+    std::vector<VkSwapchainKHR> swapChains;
+    std::vector<uint32_t> imageIndices;
+
+    for (uint32_t viewportIndex : m_frameViewports)
+    {
+        const VulkanRenderer::Viewport& viewport = *m_viewports[viewportIndex];
+        if (viewport.IsOffscreen())
+            continue;
+
+        waitSemaphores.push_back(viewport.GetImageAvailableSemaphore(m_currentFrame));
+        waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        signalSemaphores.push_back(viewport.GetRenderFinishedSemaphore(m_currentFrame));
+        swapChains.push_back(viewport.GetSwapChain());
+        imageIndices.push_back(viewport.GetImageIndex());
+    }
+
+    if (computeFinished != VK_NULL_HANDLE)
+    {
+        waitSemaphores.push_back(computeFinished);
+        waitStages.push_back(VulkanRenderer::ComputeScheduler::consumerStages);
+    }
 
     // When the command is recorded, submit it to the queue
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore waitSemaphores[] = {m_imageAvailableSemaphores[m_currentFrame]};
-    VkSemaphore signalSemaphores[] = {m_renderFinishedSemaphores[m_currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &m_commandBuffers[m_currentFrame];
 
+    // Nothing rendered, nothing to present. Only the buffers of the compute work may be given back.
+    std::vector<VkSemaphore> submitSignals;
+    if (recorded)
+        submitSignals = signalSemaphores;
+    else
+        submitInfo.commandBufferCount = handedBack ? 1 : 0;
+
+    // The next compute submission waits for the buffers given back
+    VkSemaphore graphicsReleased = handedBack ? m_computeScheduler->GetGraphicsReleaseSemaphore() : VK_NULL_HANDLE;
+    if (graphicsReleased != VK_NULL_HANDLE)
+        submitSignals.push_back(graphicsReleased);
+
+    submitInfo.signalSemaphoreCount = static_cast<uint32_t>(submitSignals.size());
+    submitInfo.pSignalSemaphores = submitSignals.data();
+
     // Do it!
-    if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
+    VkResult submitResult = VK_SUCCESS;
     {
-        std::cout << "Failed to submit to the graphics queue..." << std::endl;
-        return -1;
+        PROFILE_SCOPE("Submit");
+        submitResult = vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]);
     }
 
-    // When all is submitted, we need to present the image to the screen
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    if (submitResult != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to submit to the graphics queue...");
+        m_frameCapture->DiscardFrame(m_currentFrame);
+        return -1;
+    }
 
-    VkSwapchainKHR swapChains[] = {m_swapChain->GetSwapChain()};
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
-    presentInfo.pImageIndices = &imageIndex;
+    if (!recorded)
+    {
+        // The images stay acquired, recreating the swap chains gives them back
+        for (uint32_t viewportIndex : m_frameViewports)
+        {
+            if (!m_viewports[viewportIndex]->IsOffscreen())
+                m_viewports[viewportIndex]->MarkOutOfDate();
+        }
 
-    VkResult presentResult = vkQueuePresentKHR(m_graphicsQueue, &presentInfo);
+        return -1;
+    }
 
-    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || m_framebufferResized)
+    // When all is submitted, we need to present the images to the screens, all at once
+    if (!swapChains.empty())
     {
-        m_framebufferResized = false;
-        RecreateSwapChain();
+        std::vector<VkResult> presentResults(swapChains.size(), VK_SUCCESS);
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        presentInfo.pWaitSemaphores = signalSemaphores.data();
+        presentInfo.swapchainCount = static_cast<uint32_t>(swapChains.size());
+        presentInfo.pSwapchains = swapChains.data();
+        presentInfo.pImageIndices = imageIndices.data();
+        presentInfo.pResults = presentResults.data();
+
+        {
+            PROFILE_SCOPE("Present");
+            vkQueuePresentKHR(m_graphicsQueue, &presentInfo);
+        }
+
+        // Out of date windows are recreated on their next acquire
+        size_t presented = 0;
+        for (uint32_t viewportIndex : m_frameViewports)
+        {
+            VulkanRenderer::Viewport& viewport = *m_viewports[viewportIndex];
+            if (viewport.IsOffscreen())
+                continue;
+
+            VkResult presentResult = presentResults[presented++];
+            if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+            {
+                viewport.MarkOutOfDate();
+            }
+            else if (presentResult != VK_SUCCESS)
+            {
+                LOG_ERROR("Failed to present...");
+                return -1;
+            }
+        }
     }
-    else if (presentResult != VK_SUCCESS)
+
+    ++m_frameNumber;
+
+    if (!m_firstFramePresented)
     {
-        std::cout << "Failed to present..." << std::endl;
-        return -1;
+        m_firstFramePresented = true;
+
+        auto timeToFirstFrame = std::chrono::steady_clock::now() - m_initStart;
+        LOG_VERBOSE("Time to first frame: ", std::chrono::duration<double, std::milli>(timeToFirstFrame).count(),
+                    " ms");
     }
 
     if (++m_currentFrame >= maxFramesInFlight)
@@ -745,35 +2233,289 @@ int Application::DrawFrame()
     return 0;
 }
 
-int Application::RecreateSwapChain()
+int Application::RunServer()
 {
-    // If we ever have to recreate the swap chain, check if we are in a minimized window.
-    // If so wait until we re-open the window.
-    int width = 0, height = 0;
-    glfwGetFramebufferSize(m_window, &width, &height);
-    while (width == 0 || height == 0)
+    int returnCode = 0;
+
+    auto isReady = [](const VulkanRenderer::RenderJob& job) { return !job.connection->IsBacklogged(); };
+
+    while (returnCode == 0 && !m_renderServer->IsStopRequested())
     {
-        glfwWaitEvents();
-        glfwGetFramebufferSize(m_window, &width, &height);
+        // Their clients are gone, nothing to answer
+        std::erase_if(m_pendingJobs, [](const VulkanRenderer::RenderJob& job) { return job.connection->IsBroken(); });
+
+        // Don't wait when jobs are left from the last batch, unless their clients must read their replies first
+        std::chrono::milliseconds timeout = Cst::serverPollInterval;
+        if (std::any_of(m_pendingJobs.begin(), m_pendingJobs.end(), isReady))
+            timeout = std::chrono::milliseconds(0);
+        else if (!m_pendingJobs.empty())
+            timeout = Cst::serverBacklogPollInterval;
+
+        std::vector<VulkanRenderer::RenderJob> jobs = m_renderServer->WaitForJobs(timeout);
+
+        for (VulkanRenderer::RenderJob& job : jobs)
+            m_pendingJobs.push_back(std::move(job));
+
+        if (!m_pendingJobs.empty())
+            returnCode = RenderServerBatch();
     }
 
-    // First we need to wait until any task on the GPU is done
+    LOG_INFO("Render server stopping");
+
     vkDeviceWaitIdle(m_device);
+    m_jobSystem->Wait(*m_serverEncodings);
+
+    // The jobs not rendered yet are answered, then no more requests. The server flushes the replies left.
+    for (VulkanRenderer::RenderJob& job : m_pendingJobs)
+        job.connection->SendError(job.request.id, "server stopping");
+
+    m_pendingJobs.clear();
+    m_renderServer.reset();
+
+    if (VulkanRenderer::Parameters().traceFile())
+        DumpTrace();
+
+    return returnCode;
+}
+
+int Application::RenderServerBatch()
+{
+    PROFILE_FUNCTION();
+
+    using VulkanRenderer::RenderJob;
+
+    // The jobs of a client still reading its last replies wait, the other clients go on
+    std::vector<bool> ready(m_pendingJobs.size());
+    for (size_t i = 0; i < m_pendingJobs.size(); ++i)
+        ready[i] = !m_pendingJobs[i].connection->IsBacklogged();
 
-    // Then we will clean the frame buffers
-    for (VkFramebuffer& framebuffer : m_framebuffers)
+    auto firstReady = std::find(ready.begin(), ready.end(), true);
+    if (firstReady == ready.end())
+        return 0;
+
+    // Jobs of the same size are compatible: they share the submission, and the targets when the last batch had
+    // the same size too. Long jobs span several batches.
+    const RenderJob& firstJob = m_pendingJobs[static_cast<size_t>(firstReady - ready.begin())];
+    const VkExtent2D extent = {firstJob.request.width, firstJob.request.height};
+
+    struct BatchEntry
+    {
+        RenderJob* job;
+        uint32_t firstFrame;
+        uint32_t frameCount;
+        uint32_t firstTarget;
+    };
+
+    std::vector<BatchEntry> entries;
+    uint32_t targetCount = 0;
+
+    for (size_t i = 0; i < m_pendingJobs.size(); ++i)
     {
-        if (framebuffer != VK_NULL_HANDLE)
-            vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+        if (targetCount == Cst::serverMaxFramesPerBatch)
+            break;
+
+        RenderJob& job = m_pendingJobs[i];
+        if (!ready[i] || job.request.width != extent.width || job.request.height != extent.height)
+            continue;
+
+        uint32_t frameCount =
+            std::min(job.request.frameCount - job.renderedFrames, Cst::serverMaxFramesPerBatch - targetCount);
+        entries.push_back({&job, job.renderedFrames, frameCount, targetCount});
+        targetCount += frameCount;
     }
 
-    m_framebuffers.clear();
+    // Failed batches are closed in the metrics too
+    VulkanRenderer::Utils::ScopeExit endMetricsFrame([this]() { m_metrics->EndFrame(); });
 
-    // We will create the swap chain (will re-use the old one, and clean that one up)
-    int res = CreateSwapChain();
-    if (res != 0)
-        return res;
+    // Answered, and dropped from the pending jobs
+    auto failBatch = [this, &entries](const char* message)
+    {
+        for (const BatchEntry& entry : entries)
+        {
+            entry.job->connection->SendError(entry.job->request.id, message);
+            entry.job->renderedFrames = entry.job->request.frameCount;
+        }
+
+        std::erase_if(m_pendingJobs,
+                      [](const RenderJob& job) { return job.renderedFrames == job.request.frameCount; });
+        return 0;
+    };
+
+    // The last submission is done, its targets can be replaced
+    if (m_serverTargets.size() < targetCount)
+    {
+        m_serverTargets.resize(targetCount);
+        m_serverTargetEvictables.resize(targetCount, VulkanRenderer::MemoryBudget::invalidEvictable);
+    }
+
+    for (uint32_t i = 0; i < targetCount; ++i)
+    {
+        std::unique_ptr<VulkanRenderer::RenderTarget>& target = m_serverTargets[i];
+        if (target && target->GetExtent().width == extent.width && target->GetExtent().height == extent.height)
+        {
+            m_memoryBudget->Touch(m_serverTargetEvictables[i]);
+            continue;
+        }
+
+        m_memoryBudget->RemoveEvictable(m_serverTargetEvictables[i]);
+        m_serverTargetEvictables[i] = VulkanRenderer::MemoryBudget::invalidEvictable;
+
+        VulkanRenderer::RenderTargetConfig config;
+        config.device = m_device;
+        config.physicalDevice = m_physicalDevice;
+        config.renderPass = m_offscreenRenderPass;
+        config.format = m_viewports.front()->GetFormat();
+        config.extent = extent;
+        config.readback = true;
+        config.samples = static_cast<VkSampleCountFlagBits>(m_sampleCount);
+        config.depthFormat = static_cast<VkFormat>(m_depthFormat);
+        // Never culled, but rendered with the offscreen render pass, which stores the depth when culling
+        config.keepDepth = m_occlusionCulling;
+
+        target = std::make_unique<VulkanRenderer::RenderTarget>(config);
+        if (!target->IsValid())
+        {
+            target.reset();
+            return failBatch("failed to create the render targets");
+        }
+
+        // Kept for the next batches, created again if evicted meanwhile
+        auto evict = [this, i]()
+        {
+            m_serverTargets[i].reset();
+            m_serverTargetEvictables[i] = VulkanRenderer::MemoryBudget::invalidEvictable;
+        };
+        m_serverTargetEvictables[i] = m_memoryBudget->AddEvictable(target->GetMemories(), evict);
+    }
+
+    m_scene->Update();
+
+    // A single submission in flight, the resources of frame 0 are free again
+    if (m_bindlessHeap)
+        m_bindlessHeap->BeginFrame(0);
+
+    m_descriptorAllocator->BeginFrame(0);
+    m_uniformRing->BeginFrame(0);
+
+    VkCommandBuffer commandBuffer = m_commandBuffers[0];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    bool recorded = vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS;
+    for (const BatchEntry& entry : entries)
+    {
+        VulkanRenderer::CameraData camera{entry.job->request.viewProj};
+
+        for (uint32_t i = 0; recorded && i < entry.frameCount; ++i)
+        {
+            const VulkanRenderer::RenderTarget& target = *m_serverTargets[entry.firstTarget + i];
+            recorded = RecordScene(commandBuffer, m_offscreenRenderPass, target.GetFramebuffer(), extent, camera) == 0;
+
+            // Nothing read back from a scene which failed, the whole batch is answered with an error below
+            if (recorded)
+                target.RecordReadback(commandBuffer);
+        }
+    }
+
+    // Totals of the batch, all the targets included
+    m_metrics->Add(VulkanRenderer::Counter::BytesUploaded, m_uniformRing->GetUsedBytes());
+    m_metrics->Add(VulkanRenderer::Counter::DescriptorAllocations, m_descriptorAllocator->GetFrameAllocationCount());
+
+    if (!recorded || vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to record a render server batch");
+        vkResetCommandBuffer(commandBuffer, 0);
+        return failBatch("failed to record the commands");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    VkFence fence = m_inFlightFences[0];
+    vkResetFences(m_device, 1, &fence);
+
+    if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to submit to the graphics queue...");
+        failBatch("failed to submit");
+        return -1;
+    }
+
+    {
+        PROFILE_SCOPE("Wait for fence");
+        auto waitStart = std::chrono::steady_clock::now();
+        vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
 
-    // And we can re-create the framebuffers too
-    return CreateFramebuffers();
+        auto waitTime = std::chrono::steady_clock::now() - waitStart;
+        m_metrics->Add(VulkanRenderer::Counter::FenceWaitMicroseconds,
+                       std::chrono::duration_cast<std::chrono::microseconds>(waitTime).count());
+    }
+
+    // Optimized pipelines are used from the next batch
+    m_pipelineRegistry->BeginFrame();
+    BeginMemoryBudgetFrame();
+
+    const size_t imageSize = static_cast<size_t>(extent.width) * extent.height * 4;
+    const bool bgra = VulkanRenderer::FrameCapture::IsBgra(m_viewports.front()->GetFormat());
+
+    for (const BatchEntry& entry : entries)
+    {
+        // Copied out of the targets, so the next batch renders while this one is encoded
+        auto frames = std::make_shared<std::vector<std::vector<uint8_t>>>(entry.frameCount);
+        for (uint32_t i = 0; i < entry.frameCount; ++i)
+        {
+            const uint8_t* pixels =
+                static_cast<const uint8_t*>(m_serverTargets[entry.firstTarget + i]->GetReadbackData());
+            (*frames)[i].assign(pixels, pixels + imageSize);
+        }
+
+        RenderJob& job = *entry.job;
+        job.renderedFrames += entry.frameCount;
+        const bool lastFrames = job.renderedFrames == job.request.frameCount;
+
+        // Frames are sent in order through the connection, even when the encodings of a later batch end first
+        const uint64_t firstReply = job.connection->ReserveReplies(entry.frameCount + (lastFrames ? 1 : 0));
+
+        m_jobSystem->Run(
+            [connection = job.connection, request = job.request, frames, firstFrame = entry.firstFrame, firstReply,
+             bgra, lastFrames]()
+            { SendRenderedFrames(*connection, request, *frames, firstFrame, firstReply, bgra, lastFrames); },
+            m_serverEncodings.get());
+    }
+
+    // Done jobs only live in their encodings now
+    std::erase_if(m_pendingJobs, [](const RenderJob& job) { return job.renderedFrames == job.request.frameCount; });
+    return 0;
+}
+
+int Application::RecreateSwapChain(VulkanRenderer::Viewport& viewport)
+{
+    // If we ever have to recreate the swap chain, check if we are in a minimized window.
+    // If so skip it, the other windows keep rendering. Tried again on the next frame.
+    if (viewport.IsMinimized())
+        return 0;
+
+    // First we need to wait until any task on the GPU is done
+    vkDeviceWaitIdle(m_device);
+
+    m_metrics->Add(VulkanRenderer::Counter::SwapChainRecreations);
+
+    // Re-uses the old swap chain, and re-creates the framebuffers too
+    if (!viewport.Recreate())
+        return -1;
+
+    // Post-processing images and depth pyramids follow the size of the window
+    const uint32_t id = viewport.GetId();
+    if (m_postProcess && m_postProcess->HasTarget(id) && !m_postProcess->PrepareTarget(id, viewport.GetExtent()))
+        return -1;
+
+    if (m_occlusionCuller && !m_occlusionCuller->PrepareTarget(id, viewport.GetExtent()))
+        return -1;
+
+    return 0;
 }
@@ -0,0 +1,69 @@
+#include <attachment.h>
+
+#include <log.h>
+#include <utils/memory.h>
+
+using VulkanRenderer::Attachment;
+using VulkanRenderer::AttachmentConfig;
+
+Attachment::Attachment(AttachmentConfig& config)
+    : m_deviceCache(config.device)
+{
+    const bool isDepth = (config.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = config.format;
+    imageInfo.extent = {config.extent.width, config.extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = config.samples;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = isDepth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageInfo.usage |= config.sampled ? VK_IMAGE_USAGE_SAMPLED_BIT : VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    // Lazily allocated memory only accepts transient images
+    const VkMemoryPropertyFlags preferredProperties = config.sampled ? 0 : VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+    if (!VulkanRenderer::Utils::CreateImage(m_deviceCache, config.physicalDevice, imageInfo,
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_image, m_memory,
+                                            preferredProperties))
+        return;
+
+    // Same lookup as CreateImage, which prefers lazily allocated memory
+    if (!config.sampled)
+    {
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_deviceCache, m_image, &requirements);
+        m_lazilyAllocated = VulkanRenderer::Utils::FindMemoryType(
+                                config.physicalDevice, requirements.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) !=
+                            VulkanRenderer::Utils::invalidMemoryType;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = config.format;
+    viewInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                           VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    viewInfo.subresourceRange = {config.aspect, 0, 1, 0, 1};
+
+    if (vkCreateImageView(m_deviceCache, &viewInfo, nullptr, &m_imageView) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the attachment view");
+        m_imageView = VK_NULL_HANDLE;
+    }
+}
+
+Attachment::~Attachment()
+{
+    if (m_imageView != VK_NULL_HANDLE)
+        vkDestroyImageView(m_deviceCache, m_imageView, nullptr);
+
+    VulkanRenderer::Utils::DestroyImage(m_deviceCache, m_image, m_memory);
+}
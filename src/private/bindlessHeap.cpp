@@ -0,0 +1,323 @@
+#include <bindlessHeap.h>
+
+#include <log.h>
+#include <utils/utils.h>
+
+#include <algorithm>
+
+using VulkanRenderer::BindlessHeap;
+using VulkanRenderer::BindlessHeapConfig;
+using VulkanRenderer::BindlessIndex;
+using VulkanRenderer::BindlessResourceType;
+
+namespace
+{
+constexpr uint32_t textureBinding = 0;
+constexpr uint32_t storageBufferBinding = 1;
+
+// Binding flags shared by all our arrays:
+// * Partially bound: unused slots can stay empty.
+// * Update after bind: we can register new resources while the set is bound in a command buffer.
+// * Update unused while pending: slots not used by in-flight frames can be written.
+constexpr VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                  VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                  VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+bool HasDescriptorIndexingExtension(VkPhysicalDevice physicalDevice)
+{
+    uint32_t extensionsCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionsCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionsCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionsCount, availableExtensions.data());
+
+    const char* extensionName = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+    return VulkanRenderer::Utils::ValidateStrings(
+               &extensionName, 1, availableExtensions.data(), extensionsCount,
+               [](const VkExtensionProperties& properties) -> const char* { return properties.extensionName; }) == 1;
+}
+} // namespace
+
+BindlessHeap::BindlessHeap(BindlessHeapConfig& config)
+    : m_deviceCache(config.device)
+{
+    // Clamp the requested sizes to what the device supports when updating after bind
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(config.physicalDevice, &properties);
+
+    Slots& textures = m_slots[static_cast<size_t>(BindlessResourceType::Texture)];
+    textures.capacity =
+        std::min({config.maxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+                  indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                  indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+                  indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+    Slots& buffers = m_slots[static_cast<size_t>(BindlessResourceType::StorageBuffer)];
+    buffers.capacity =
+        std::min({config.maxStorageBuffers, indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                  indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+
+    for (Slots& slots : m_slots)
+        slots.pendingReleases.resize(std::max(config.framesInFlight, 1u));
+
+    CreateLayout();
+    CreatePoolAndSet();
+}
+
+BindlessHeap::~BindlessHeap()
+{
+    // Descriptor sets are freed with their pool
+    vkDestroyDescriptorPool(m_deviceCache, m_pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_deviceCache, m_layout, nullptr);
+}
+
+void BindlessHeap::CreateLayout()
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+
+    bindings[0].binding = textureBinding;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = GetCapacity(BindlessResourceType::Texture);
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+    bindings[1].binding = storageBufferBinding;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = GetCapacity(BindlessResourceType::StorageBuffer);
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    std::array<VkDescriptorBindingFlags, 2> flags = {bindingFlags, bindingFlags};
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(flags.size());
+    bindingFlagsInfo.pBindingFlags = flags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_deviceCache, &layoutInfo, nullptr, &m_layout) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the bindless descriptor set layout");
+        m_layout = VK_NULL_HANDLE;
+    }
+}
+
+void BindlessHeap::CreatePoolAndSet()
+{
+    if (m_layout == VK_NULL_HANDLE)
+        return;
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = GetCapacity(BindlessResourceType::Texture);
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = GetCapacity(BindlessResourceType::StorageBuffer);
+
+    // A single set, that lives as long as the heap
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(m_deviceCache, &poolInfo, nullptr, &m_pool) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the bindless descriptor pool");
+        m_pool = VK_NULL_HANDLE;
+        return;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_layout;
+
+    if (vkAllocateDescriptorSets(m_deviceCache, &allocInfo, &m_descriptorSet) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to allocate the bindless descriptor set");
+        m_descriptorSet = VK_NULL_HANDLE;
+    }
+}
+
+bool BindlessHeap::IsValid() const
+{
+    return m_layout != VK_NULL_HANDLE && m_pool != VK_NULL_HANDLE && m_descriptorSet != VK_NULL_HANDLE;
+}
+
+BindlessIndex BindlessHeap::AllocateIndex(BindlessResourceType type)
+{
+    Slots& slots = m_slots[static_cast<size_t>(type)];
+
+    // Prefer recycled indices, to keep the used range of the arrays compact
+    if (!slots.freeList.empty())
+    {
+        BindlessIndex index = slots.freeList.back();
+        slots.freeList.pop_back();
+        return index;
+    }
+
+    if (slots.highWaterMark < slots.capacity)
+        return slots.highWaterMark++;
+
+    return invalidBindlessIndex;
+}
+
+BindlessIndex BindlessHeap::RegisterTexture(VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    std::lock_guard lock(m_mutex);
+
+    BindlessIndex index = AllocateIndex(BindlessResourceType::Texture);
+    if (index == invalidBindlessIndex)
+    {
+        LOG_ERROR("Bindless heap is out of texture slots");
+        return index;
+    }
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = sampler;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_descriptorSet;
+    write.dstBinding = textureBinding;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(m_deviceCache, 1, &write, 0, nullptr);
+    return index;
+}
+
+BindlessIndex BindlessHeap::RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    std::lock_guard lock(m_mutex);
+
+    BindlessIndex index = AllocateIndex(BindlessResourceType::StorageBuffer);
+    if (index == invalidBindlessIndex)
+    {
+        LOG_ERROR("Bindless heap is out of storage buffer slots");
+        return index;
+    }
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_descriptorSet;
+    write.dstBinding = storageBufferBinding;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(m_deviceCache, 1, &write, 0, nullptr);
+    return index;
+}
+
+void BindlessHeap::Release(BindlessResourceType type, BindlessIndex index)
+{
+    if (index == invalidBindlessIndex)
+        return;
+
+    std::lock_guard lock(m_mutex);
+
+    // Frames still in flight might reference this index, so wait for this frame slot to come back
+    // before handing the index out again. The descriptor itself is left as is (partially bound).
+    Slots& slots = m_slots[static_cast<size_t>(type)];
+    slots.pendingReleases[m_currentFrame].push_back(index);
+}
+
+void BindlessHeap::BeginFrame(uint32_t frameIndex)
+{
+    std::lock_guard lock(m_mutex);
+
+    // All resource types track the same number of frames
+    frameIndex %= static_cast<uint32_t>(m_slots[0].pendingReleases.size());
+
+    for (Slots& slots : m_slots)
+    {
+        std::vector<BindlessIndex>& released = slots.pendingReleases[frameIndex];
+        slots.freeList.insert(slots.freeList.end(), released.begin(), released.end());
+        released.clear();
+    }
+
+    m_currentFrame = frameIndex;
+}
+
+void BindlessHeap::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+                        uint32_t setIndex) const
+{
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setIndex, 1, &m_descriptorSet, 0, nullptr);
+}
+
+bool BindlessHeap::IsSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // We need vkGetPhysicalDeviceFeatures2 (1.1) to query the features, and either
+    // core 1.2 or the extension.
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+        return false;
+
+    if (properties.apiVersion < VK_API_VERSION_1_2 && !HasDescriptorIndexingExtension(physicalDevice))
+        return false;
+
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &indexingFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound &&
+           indexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+           indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+           indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+           indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+           indexingFeatures.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+std::vector<const char*> BindlessHeap::GetRequiredDeviceExtensions(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // Promoted to core in 1.2. Its maintenance3 dependency is core since 1.1.
+    if (properties.apiVersion >= VK_API_VERSION_1_2)
+        return {};
+
+    return {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
+}
+
+VkPhysicalDeviceDescriptorIndexingFeatures BindlessHeap::GetRequiredFeatures()
+{
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    indexingFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+    return indexingFeatures;
+}
@@ -0,0 +1,103 @@
+#include <computePipeline.h>
+#include <log.h>
+#include <shader.h>
+#include <utils/pipeline.h>
+
+using VulkanRenderer::ComputePipeline;
+using VulkanRenderer::ComputePipelineConfig;
+using VulkanRenderer::Shader;
+using VulkanRenderer::ShaderFeatureMask;
+using VulkanRenderer::ShaderType;
+
+ComputePipeline::ComputePipeline(ComputePipelineConfig& config)
+    : m_deviceCache(config.device)
+    , m_entryPoint(config.pipelineName)
+    , m_pipelineCache(config.pipelineCache)
+    , m_defaultFeatures(config.defaultFeatures & VulkanRenderer::allShaderFeatures)
+{
+    // Kept alive, every feature variant is created from it
+    m_shader = Shader::Create(m_deviceCache, ShaderType::Compute, config.shaderCode, config.shaderFile);
+    if (!m_shader)
+    {
+        LOG_ERROR("Failed to create compute shader");
+        return;
+    }
+
+    m_pipelineLayout = VulkanRenderer::Utils::CreatePipelineLayout(m_deviceCache, config.descriptorSetLayouts,
+                                                                   config.pushConstantRanges);
+    if (m_pipelineLayout == VK_NULL_HANDLE)
+        return;
+
+    GetPipeline(m_defaultFeatures);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    for (auto& [features, pipeline] : m_pipelines)
+        vkDestroyPipeline(m_deviceCache, pipeline, nullptr);
+
+    vkDestroyPipelineLayout(m_deviceCache, m_pipelineLayout, nullptr);
+}
+
+VkPipeline ComputePipeline::GetPipeline(ShaderFeatureMask features)
+{
+    features &= VulkanRenderer::allShaderFeatures;
+
+    auto it = m_pipelines.find(features);
+    if (it != m_pipelines.end())
+        return it->second;
+
+    if (m_pipelineLayout == VK_NULL_HANDLE)
+        return VK_NULL_HANDLE;
+
+    // Failures are cached too, so a broken variant is not rebuilt every frame
+    VkPipeline pipeline = CreatePipelineVariant(features);
+    m_pipelines.emplace(features, pipeline);
+    return pipeline;
+}
+
+void ComputePipeline::Dispatch(VkCommandBuffer commandBuffer, ShaderFeatureMask features, uint32_t invocationCount,
+                               uint32_t groupSize)
+{
+    VkPipeline pipeline = GetPipeline(features);
+    if (pipeline == VK_NULL_HANDLE || invocationCount == 0)
+        return;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdDispatch(commandBuffer, (invocationCount + groupSize - 1) / groupSize, 1, 1);
+}
+
+VkPipeline ComputePipeline::CreatePipelineVariant(ShaderFeatureMask features)
+{
+    VulkanRenderer::ShaderSpecialization specialization(features);
+
+    VkPipelineShaderStageCreateInfo stageInfo{};
+    stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stageInfo.module = m_shader->GetModule();
+    stageInfo.pName = m_entryPoint.c_str();
+    stageInfo.pSpecializationInfo = specialization.GetInfo();
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = stageInfo;
+    pipelineInfo.layout = m_pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateComputePipelines(m_deviceCache, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create compute pipeline for features ", features);
+        return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+}
+
+bool ComputePipeline::IsValid() const
+{
+    auto defaultPipeline = m_pipelines.find(m_defaultFeatures);
+    return m_shader && m_pipelineLayout != VK_NULL_HANDLE && defaultPipeline != m_pipelines.end() &&
+           defaultPipeline->second != VK_NULL_HANDLE;
+}
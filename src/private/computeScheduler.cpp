@@ -0,0 +1,277 @@
+#include <computeScheduler.h>
+
+#include <log.h>
+#include <profiler.h>
+
+#include <algorithm>
+#include <cassert>
+
+using VulkanRenderer::ComputeScheduler;
+using VulkanRenderer::ComputeSchedulerConfig;
+
+namespace
+{
+VkBufferMemoryBarrier OwnershipTransfer(VkBuffer buffer, uint32_t srcFamily, uint32_t dstFamily)
+{
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    return barrier;
+}
+} // namespace
+
+ComputeScheduler::ComputeScheduler(ComputeSchedulerConfig& config)
+    : m_deviceCache(config.device)
+    , m_queue(config.queue)
+    , m_queueFamily(config.queueFamily)
+    , m_graphicsFamily(config.graphicsFamily)
+{
+    VkCommandPoolCreateInfo commandPoolInfo{};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = m_queueFamily;
+
+    if (vkCreateCommandPool(m_deviceCache, &commandPoolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the compute command pool");
+        m_commandPool = VK_NULL_HANDLE;
+        return;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = config.framesInFlight;
+
+    m_commandBuffers.resize(config.framesInFlight, VK_NULL_HANDLE);
+    if (vkAllocateCommandBuffers(m_deviceCache, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to allocate the compute command buffers");
+        m_commandBuffers.clear();
+        return;
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for (uint32_t i = 0; i < 2 * config.framesInFlight; ++i)
+    {
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        if (vkCreateSemaphore(m_deviceCache, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create the compute semaphores");
+            return;
+        }
+
+        (i < config.framesInFlight ? m_finished : m_graphicsReleased).push_back(semaphore);
+    }
+
+    LOG_VERBOSE("Compute work submitted to queue family ", m_queueFamily, IsAsync() ? ", async" : "");
+}
+
+ComputeScheduler::~ComputeScheduler()
+{
+    for (VkSemaphore semaphore : m_finished)
+        vkDestroySemaphore(m_deviceCache, semaphore, nullptr);
+
+    for (VkSemaphore semaphore : m_graphicsReleased)
+        vkDestroySemaphore(m_deviceCache, semaphore, nullptr);
+
+    // Frees the command buffers too
+    if (m_commandPool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(m_deviceCache, m_commandPool, nullptr);
+}
+
+bool ComputeScheduler::IsValid() const
+{
+    return !m_commandBuffers.empty() && m_finished.size() == m_commandBuffers.size() &&
+           m_graphicsReleased.size() == m_commandBuffers.size();
+}
+
+void ComputeScheduler::BeginFrame(uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex;
+    m_recording = false;
+    m_submitted = false;
+    m_handoff.clear();
+    m_taken.clear();
+}
+
+VkCommandBuffer ComputeScheduler::GetCommandBuffer()
+{
+    VkCommandBuffer commandBuffer = m_commandBuffers[m_frameIndex];
+    if (m_recording)
+        return commandBuffer;
+
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to begin the compute command buffer");
+        return VK_NULL_HANDLE;
+    }
+
+    m_recording = true;
+    return commandBuffer;
+}
+
+void ComputeScheduler::AcquireFromGraphics(VkBuffer buffer, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+{
+    // Never handed to graphics, or already taken back
+    auto returned = std::find_if(m_returned.begin(), m_returned.end(),
+                                 [buffer](const Handoff& handoff) { return handoff.buffer == buffer; });
+    if (returned == m_returned.end())
+        return;
+
+    VkCommandBuffer commandBuffer = GetCommandBuffer();
+    if (commandBuffer == VK_NULL_HANDLE)
+        return;
+
+    // The semaphore of the graphics release orders it after the reads of graphics
+    VkBufferMemoryBarrier acquire = OwnershipTransfer(buffer, m_graphicsFamily, m_queueFamily);
+    acquire.dstAccessMask = dstAccess;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStages, 0, 0, nullptr, 1, &acquire, 0,
+                         nullptr);
+
+    m_taken.push_back(*returned);
+    m_returned.erase(returned);
+}
+
+void ComputeScheduler::ReleaseToGraphics(VkBuffer buffer, VkAccessFlags srcAccess, VkPipelineStageFlags graphicsStages,
+                                         VkAccessFlags graphicsAccess)
+{
+    if (!IsAsync())
+        return;
+
+    VkCommandBuffer commandBuffer = GetCommandBuffer();
+    if (commandBuffer == VK_NULL_HANDLE)
+        return;
+
+    // The destination access is ignored on release, the acquire makes the writes visible
+    VkBufferMemoryBarrier release = OwnershipTransfer(buffer, m_queueFamily, m_graphicsFamily);
+    release.srcAccessMask = srcAccess;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 1, &release, 0, nullptr);
+
+    m_handoff.push_back({buffer, graphicsStages, graphicsAccess});
+}
+
+void ComputeScheduler::RecordGraphicsAcquire(VkCommandBuffer graphicsCommandBuffer) const
+{
+    if (m_handoff.empty())
+        return;
+
+    std::vector<VkBufferMemoryBarrier> barriers;
+    VkPipelineStageFlags dstStages = 0;
+    for (const Handoff& handoff : m_handoff)
+    {
+        VkBufferMemoryBarrier& acquire =
+            barriers.emplace_back(OwnershipTransfer(handoff.buffer, m_queueFamily, m_graphicsFamily));
+        acquire.dstAccessMask = handoff.graphicsAccess;
+        dstStages |= handoff.graphicsStages;
+    }
+
+    vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStages, 0, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+}
+
+void ComputeScheduler::RecordGraphicsRelease(VkCommandBuffer graphicsCommandBuffer) const
+{
+    if (m_handoff.empty())
+        return;
+
+    // Only read by graphics, no write to make available
+    std::vector<VkBufferMemoryBarrier> barriers;
+    VkPipelineStageFlags srcStages = 0;
+    for (const Handoff& handoff : m_handoff)
+    {
+        barriers.push_back(OwnershipTransfer(handoff.buffer, m_graphicsFamily, m_queueFamily));
+        srcStages |= handoff.graphicsStages;
+    }
+
+    vkCmdPipelineBarrier(graphicsCommandBuffer, srcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+}
+
+bool ComputeScheduler::Submit(VkSemaphore& finished)
+{
+    PROFILE_FUNCTION();
+
+    finished = VK_NULL_HANDLE;
+    if (!m_recording)
+        return true;
+
+    m_recording = false;
+
+    // Nothing handed over for graphics to acquire, and the buffers taken back are still to take back
+    auto fail = [this]()
+    {
+        m_handoff.clear();
+        m_returned.insert(m_returned.end(), m_taken.begin(), m_taken.end());
+        m_taken.clear();
+        return false;
+    };
+
+    VkCommandBuffer commandBuffer = m_commandBuffers[m_frameIndex];
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to record the compute command buffer");
+        return fail();
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_finished[m_frameIndex];
+
+    // Graphics is done reading the buffers it gave back
+    const VkPipelineStageFlags returnedStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    if (m_returnedSemaphore != VK_NULL_HANDLE)
+    {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &m_returnedSemaphore;
+        submitInfo.pWaitDstStageMask = &returnedStages;
+    }
+
+    // No fence, the graphics submission waiting on the semaphore carries the frame fence
+    if (vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to submit to the compute queue");
+        return fail();
+    }
+
+    m_returnedSemaphore = VK_NULL_HANDLE;
+    m_taken.clear();
+    m_submitted = true;
+    finished = m_finished[m_frameIndex];
+    return true;
+}
+
+VkSemaphore ComputeScheduler::GetGraphicsReleaseSemaphore()
+{
+    if (m_handoff.empty())
+        return VK_NULL_HANDLE;
+
+    // Graphics acquires the buffers handed over, their release must be on the compute queue first
+    assert(m_submitted);
+
+    // Taken back by the next compute work, once the graphics submission signaled it
+    m_returned.insert(m_returned.end(), m_handoff.begin(), m_handoff.end());
+    m_handoff.clear();
+
+    m_returnedSemaphore = m_graphicsReleased[m_frameIndex];
+    return m_returnedSemaphore;
+}
@@ -0,0 +1,260 @@
+#include <descriptorAllocator.h>
+
+#include <log.h>
+#include <utils/utils.h>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+using VulkanRenderer::DescriptorAllocator;
+using VulkanRenderer::DescriptorAllocatorConfig;
+using VulkanRenderer::DescriptorLayoutCache;
+
+namespace
+{
+// Number of descriptors of each type per set in a pool.
+// Rough average of what a material/object set needs.
+constexpr std::array<std::pair<VkDescriptorType, float>, 7> poolSizeRatios = {{
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+}};
+
+bool IsPooled(VkDescriptorType type)
+{
+    return std::any_of(poolSizeRatios.begin(), poolSizeRatios.end(),
+                       [type](const std::pair<VkDescriptorType, float>& ratio) { return ratio.first == type; });
+}
+} // namespace
+
+DescriptorLayoutCache::DescriptorLayoutCache(VkDevice device)
+    : m_deviceCache(device)
+{
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache()
+{
+    for (auto& [key, layout] : m_layouts)
+        vkDestroyDescriptorSetLayout(m_deviceCache, layout, nullptr);
+}
+
+bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const
+{
+    if (bindings.size() != other.bindings.size())
+        return false;
+
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        const VkDescriptorSetLayoutBinding& left = bindings[i];
+        const VkDescriptorSetLayoutBinding& right = other.bindings[i];
+
+        if (left.binding != right.binding || left.descriptorType != right.descriptorType ||
+            left.descriptorCount != right.descriptorCount || left.stageFlags != right.stageFlags)
+            return false;
+    }
+
+    return true;
+}
+
+size_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const
+{
+    size_t seed = key.bindings.size();
+
+    for (const VkDescriptorSetLayoutBinding& binding : key.bindings)
+    {
+        // Pack everything but the count in a single integer
+        uint64_t packed = static_cast<uint64_t>(binding.binding) |
+                          (static_cast<uint64_t>(binding.descriptorType) << 16) |
+                          (static_cast<uint64_t>(binding.stageFlags) << 32);
+
+        VulkanRenderer::Utils::HashCombine(seed, packed);
+        VulkanRenderer::Utils::HashCombine(seed, binding.descriptorCount);
+    }
+
+    return seed;
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    // Normalize the key, so the same bindings in a different order give the same layout
+    LayoutKey key{bindings};
+    std::sort(key.bindings.begin(), key.bindings.end(),
+              [](const VkDescriptorSetLayoutBinding& left, const VkDescriptorSetLayoutBinding& right)
+              { return left.binding < right.binding; });
+
+    for (const VkDescriptorSetLayoutBinding& binding : key.bindings)
+    {
+        if (binding.pImmutableSamplers != nullptr)
+        {
+            LOG_ERROR("Immutable samplers are not supported by the descriptor layout cache");
+            return VK_NULL_HANDLE;
+        }
+
+        // A set with a type the pools don't have could never be allocated, each try would grab a new pool
+        if (!IsPooled(binding.descriptorType))
+        {
+            LOG_ERROR("Descriptor type ", binding.descriptorType, " is not supported by the descriptor allocator");
+            return VK_NULL_HANDLE;
+        }
+    }
+
+    auto it = m_layouts.find(key);
+    if (it != m_layouts.end())
+        return it->second;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(key.bindings.size());
+    layoutInfo.pBindings = key.bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(m_deviceCache, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create descriptor set layout");
+        return VK_NULL_HANDLE;
+    }
+
+    m_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+DescriptorAllocator::DescriptorAllocator(DescriptorAllocatorConfig& config)
+    : m_deviceCache(config.device)
+    , m_frames(std::max(config.framesInFlight, 1u))
+    , m_nextSetsPerPool(std::max(config.initialSetsPerPool, 1u))
+    , m_maxSetsPerPool(std::max(config.maxSetsPerPool, config.initialSetsPerPool))
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    for (FramePools& frame : m_frames)
+    {
+        if (frame.current != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_deviceCache, frame.current, nullptr);
+
+        for (VkDescriptorPool pool : frame.full)
+            vkDestroyDescriptorPool(m_deviceCache, pool, nullptr);
+    }
+
+    for (VkDescriptorPool pool : m_freePools)
+        vkDestroyDescriptorPool(m_deviceCache, pool, nullptr);
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t setCount)
+{
+    std::array<VkDescriptorPoolSize, poolSizeRatios.size()> poolSizes{};
+    for (size_t i = 0; i < poolSizeRatios.size(); ++i)
+    {
+        poolSizes[i].type = poolSizeRatios[i].first;
+        poolSizes[i].descriptorCount = static_cast<uint32_t>(poolSizeRatios[i].second * setCount);
+    }
+
+    // No FREE_DESCRIPTOR_SET_BIT: sets are never freed individually, the whole pool is reset.
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = 0;
+    poolInfo.maxSets = setCount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(m_deviceCache, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create descriptor pool");
+        return VK_NULL_HANDLE;
+    }
+
+    ++m_poolCount;
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::GrabPool()
+{
+    // Reuse a pool already reset if we can
+    if (!m_freePools.empty())
+    {
+        VkDescriptorPool pool = m_freePools.back();
+        m_freePools.pop_back();
+        return pool;
+    }
+
+    // Otherwise grow: each new pool is bigger than the previous one
+    VkDescriptorPool pool = CreatePool(m_nextSetsPerPool);
+    m_nextSetsPerPool = std::min(m_nextSetsPerPool * 2, m_maxSetsPerPool);
+    return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+    FramePools& frame = m_frames[m_currentFrame];
+
+    if (frame.current == VK_NULL_HANDLE)
+    {
+        frame.current = GrabPool();
+        if (frame.current == VK_NULL_HANDLE)
+            return VK_NULL_HANDLE;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = frame.current;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkResult result = vkAllocateDescriptorSets(m_deviceCache, &allocInfo, &set);
+
+    if (result == VK_SUCCESS)
+    {
+        ++m_frameAllocationCount;
+        return set;
+    }
+
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+    {
+        LOG_ERROR("Failed to allocate descriptor set");
+        return VK_NULL_HANDLE;
+    }
+
+    // The current pool is full, keep it until the frame comes back and try again in a new one
+    frame.full.push_back(frame.current);
+    frame.current = GrabPool();
+    if (frame.current == VK_NULL_HANDLE)
+        return VK_NULL_HANDLE;
+
+    allocInfo.descriptorPool = frame.current;
+    if (vkAllocateDescriptorSets(m_deviceCache, &allocInfo, &set) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to allocate descriptor set, even from a new pool");
+        return VK_NULL_HANDLE;
+    }
+
+    ++m_frameAllocationCount;
+    return set;
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+    m_currentFrame = frameIndex % static_cast<uint32_t>(m_frames.size());
+    m_frameAllocationCount = 0;
+    FramePools& frame = m_frames[m_currentFrame];
+
+    // The GPU is done with all the sets allocated for this frame, reset the pools in one go.
+    // Full pools go back to the free list, the current one is kept.
+    for (VkDescriptorPool pool : frame.full)
+    {
+        vkResetDescriptorPool(m_deviceCache, pool, 0);
+        m_freePools.push_back(pool);
+    }
+
+    frame.full.clear();
+
+    if (frame.current != VK_NULL_HANDLE)
+        vkResetDescriptorPool(m_deviceCache, frame.current, 0);
+}
@@ -0,0 +1,390 @@
+#include <deviceBenchmark.h>
+
+#include <computePipeline.h>
+#include <log.h>
+#include <profiler.h>
+#include <utils/deviceInfo.h>
+#include <utils/memory.h>
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+using VulkanRenderer::DeviceBenchmark;
+using VulkanRenderer::DeviceBenchmarkConfig;
+using VulkanRenderer::DeviceBenchmarkResult;
+
+namespace
+{
+// Large enough to go past the caches, repeated to last a few milliseconds on a fast GPU
+constexpr VkDeviceSize fillBufferSize = 64ull * 1024 * 1024;
+constexpr uint32_t fillRepeats = 16;
+
+// Local size of the shader
+constexpr uint32_t computeGroupSize = 256;
+constexpr uint32_t computeGroupCount = 256;
+constexpr uint32_t computeIterations = 128;
+// Four vec4 multiply-adds per iteration, two operations each
+constexpr double flopsPerIteration = 4.0 * 4.0 * 2.0;
+
+// Start, fills done, compute done
+constexpr uint32_t timestampCount = 3;
+
+// Must match deviceBenchmark.comp
+struct BenchmarkData
+{
+    uint32_t iterations;
+    float seed;
+};
+
+// Everything created for the probe, on a device of its own
+struct ProbeContext
+{
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+
+    VkBuffer fillBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory fillMemory = VK_NULL_HANDLE;
+    VkBuffer resultBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory resultMemory = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    std::unique_ptr<VulkanRenderer::ComputePipeline> pipeline;
+
+    ~ProbeContext()
+    {
+        if (device == VK_NULL_HANDLE)
+            return;
+
+        vkDeviceWaitIdle(device);
+
+        pipeline.reset();
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        VulkanRenderer::Utils::DestroyBuffer(device, resultBuffer, resultMemory);
+        VulkanRenderer::Utils::DestroyBuffer(device, fillBuffer, fillMemory);
+        vkDestroyQueryPool(device, queryPool, nullptr);
+        vkDestroyFence(device, fence, nullptr);
+        vkDestroyCommandPool(device, commandPool, nullptr);
+        vkDestroyDevice(device, nullptr);
+    }
+};
+
+bool CreateDevice(const VulkanRenderer::PhysicalDeviceInfo& info, uint32_t queueFamily, ProbeContext& context)
+{
+    const float queuePriority = 1.0f;
+
+    VkDeviceQueueCreateInfo queueInfo{};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    // No extension nor feature, the probes only use the core ones
+    VkDeviceCreateInfo deviceInfo{};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+
+    if (vkCreateDevice(info.device, &deviceInfo, nullptr, &context.device) != VK_SUCCESS)
+    {
+        context.device = VK_NULL_HANDLE;
+        return false;
+    }
+
+    vkGetDeviceQueue(context.device, queueFamily, 0, &context.queue);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkQueryPoolCreateInfo queryInfo{};
+    queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = timestampCount;
+
+    if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &context.commandPool) != VK_SUCCESS)
+        return false;
+
+    allocInfo.commandPool = context.commandPool;
+    return vkAllocateCommandBuffers(context.device, &allocInfo, &context.commandBuffer) == VK_SUCCESS &&
+           vkCreateFence(context.device, &fenceInfo, nullptr, &context.fence) == VK_SUCCESS &&
+           vkCreateQueryPool(context.device, &queryInfo, nullptr, &context.queryPool) == VK_SUCCESS;
+}
+
+bool CreateResources(const VulkanRenderer::PhysicalDeviceInfo& info, const std::string& shaderFile,
+                     ProbeContext& context)
+{
+    if (!VulkanRenderer::Utils::CreateBuffer(context.device, info.device, fillBufferSize,
+                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                             context.fillBuffer, context.fillMemory) ||
+        !VulkanRenderer::Utils::CreateBuffer(context.device, info.device, sizeof(float) * 4,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                             context.resultBuffer, context.resultMemory))
+        return false;
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(context.device, &layoutInfo, nullptr, &context.setLayout) != VK_SUCCESS)
+        return false;
+
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(context.device, &poolInfo, nullptr, &context.descriptorPool) != VK_SUCCESS)
+        return false;
+
+    VkDescriptorSetAllocateInfo setInfo{};
+    setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool = context.descriptorPool;
+    setInfo.descriptorSetCount = 1;
+    setInfo.pSetLayouts = &context.setLayout;
+
+    if (vkAllocateDescriptorSets(context.device, &setInfo, &context.descriptorSet) != VK_SUCCESS)
+        return false;
+
+    VkDescriptorBufferInfo bufferInfo{context.resultBuffer, 0, VK_WHOLE_SIZE};
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = context.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(context.device, 1, &write, 0, nullptr);
+
+    VkPushConstantRange dataRange{};
+    dataRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    dataRange.offset = 0;
+    dataRange.size = sizeof(BenchmarkData);
+
+    VulkanRenderer::ComputePipelineConfig pipelineConfig;
+    pipelineConfig.device = context.device;
+    pipelineConfig.shaderFile = shaderFile.c_str();
+    pipelineConfig.pipelineName = "main";
+    pipelineConfig.descriptorSetLayouts = {context.setLayout};
+    pipelineConfig.pushConstantRanges = {dataRange};
+    pipelineConfig.defaultFeatures = 0;
+
+    context.pipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+    return context.pipeline->IsValid();
+}
+
+bool RecordProbes(ProbeContext& context)
+{
+    VkCommandBuffer commandBuffer = context.commandBuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        return false;
+
+    vkCmdResetQueryPool(commandBuffer, context.queryPool, 0, timestampCount);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, context.queryPool, 0);
+
+    for (uint32_t i = 0; i < fillRepeats; ++i)
+        vkCmdFillBuffer(commandBuffer, context.fillBuffer, 0, VK_WHOLE_SIZE, i);
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context.queryPool, 1);
+
+    // The dispatch starts once the fills are done, each probe has the whole device
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 0, nullptr);
+
+    const BenchmarkData data{computeIterations, 0.5f};
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, context.pipeline->GetPipelineLayout(), 0,
+                            1, &context.descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, context.pipeline->GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(data), &data);
+    context.pipeline->Dispatch(commandBuffer, 0, computeGroupCount * computeGroupSize, computeGroupSize);
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context.queryPool, 2);
+
+    return vkEndCommandBuffer(commandBuffer) == VK_SUCCESS;
+}
+
+bool Submit(ProbeContext& context)
+{
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &context.commandBuffer;
+
+    vkResetFences(context.device, 1, &context.fence);
+    return vkQueueSubmit(context.queue, 1, &submitInfo, context.fence) == VK_SUCCESS &&
+           vkWaitForFences(context.device, 1, &context.fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS;
+}
+} // namespace
+
+float DeviceBenchmarkResult::GetScore() const { return std::sqrt(fillRate * computeRate); }
+
+DeviceBenchmark::DeviceBenchmark(DeviceBenchmarkConfig& config)
+    : m_cacheFile(config.cacheFile)
+    , m_computeShaderFile(config.computeShaderFile)
+{
+    Load();
+}
+
+bool DeviceBenchmark::IsMeasurable(const PhysicalDeviceInfo& info)
+{
+    if (info.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU || !info.queueFamilies.graphicsFamily)
+        return false;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(info.device, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(info.device, &familyCount, families.data());
+
+    return families[*info.queueFamilies.graphicsFamily].timestampValidBits != 0;
+}
+
+bool DeviceBenchmark::FindResult(const PhysicalDeviceInfo& info, DeviceBenchmarkResult& outResult) const
+{
+    auto cached = m_results.find(GetKey(info));
+    if (cached == m_results.end() || cached->second.driverVersion != info.properties.driverVersion)
+        return false;
+
+    outResult = cached->second.result;
+    return true;
+}
+
+bool DeviceBenchmark::Run(const PhysicalDeviceInfo& info, DeviceBenchmarkResult& outResult)
+{
+    PROFILE_FUNCTION();
+
+    if (!IsMeasurable(info))
+    {
+        LOG_WARNING("Device ", std::string(info.properties.deviceName), " can't be benchmarked");
+        return false;
+    }
+
+    // Graphics families always support compute and transfers
+    const uint32_t queueFamily = *info.queueFamilies.graphicsFamily;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(info.device, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(info.device, &familyCount, families.data());
+
+    const uint32_t validBits = families[queueFamily].timestampValidBits;
+
+    ProbeContext context;
+    if (!CreateDevice(info, queueFamily, context) || !CreateResources(info, m_computeShaderFile, context) ||
+        !RecordProbes(context))
+    {
+        LOG_ERROR("Failed to set up the benchmark of ", std::string(info.properties.deviceName));
+        return false;
+    }
+
+    // The first run brings the clocks up, only the second one is measured
+    if (!Submit(context) || !Submit(context))
+    {
+        LOG_ERROR("Failed to run the benchmark of ", std::string(info.properties.deviceName));
+        return false;
+    }
+
+    std::array<uint64_t, timestampCount> timestamps{};
+    if (vkGetQueryPoolResults(context.device, context.queryPool, 0, timestampCount, sizeof(timestamps),
+                              timestamps.data(), sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+        return false;
+
+    const uint64_t mask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    const double period = info.properties.limits.timestampPeriod;
+    const double fillNanoseconds = static_cast<double>((timestamps[1] - timestamps[0]) & mask) * period;
+    const double computeNanoseconds = static_cast<double>((timestamps[2] - timestamps[1]) & mask) * period;
+    if (fillNanoseconds <= 0.0 || computeNanoseconds <= 0.0)
+        return false;
+
+    // Bytes per nanosecond are GB/s, operations per nanosecond GFLOPS
+    const double fillBytes = static_cast<double>(fillBufferSize) * fillRepeats;
+    const double operations =
+        static_cast<double>(computeGroupCount) * computeGroupSize * computeIterations * flopsPerIteration;
+    outResult.fillRate = static_cast<float>(fillBytes / fillNanoseconds);
+    outResult.computeRate = static_cast<float>(operations / computeNanoseconds);
+
+    LOG_INFO("Benchmarked ", std::string(info.properties.deviceName), ": ", outResult.fillRate, " GB/s fill, ",
+             outResult.computeRate, " GFLOPS");
+
+    m_results[GetKey(info)] = {info.properties.driverVersion, outResult};
+    m_changed = true;
+    return true;
+}
+
+bool DeviceBenchmark::Save() const
+{
+    if (!m_changed)
+        return true;
+
+    std::ofstream file(m_cacheFile, std::ios::trunc);
+    if (!file.is_open())
+    {
+        LOG_ERROR("Failed to write the device benchmark cache ", m_cacheFile);
+        return false;
+    }
+
+    for (const auto& [key, cached] : m_results)
+        file << key << ' ' << cached.driverVersion << ' ' << cached.result.fillRate << ' '
+             << cached.result.computeRate << '\n';
+
+    return file.good();
+}
+
+std::string DeviceBenchmark::GetKey(const PhysicalDeviceInfo& info)
+{
+    std::ostringstream key;
+    key << std::hex << std::setfill('0');
+    for (uint8_t byte : info.uuid)
+        key << std::setw(2) << static_cast<uint32_t>(byte);
+
+    return key.str();
+}
+
+void DeviceBenchmark::Load()
+{
+    // Missing on the first run
+    std::ifstream file(m_cacheFile);
+    if (!file.is_open())
+        return;
+
+    std::string key;
+    CachedResult cached{};
+    while (file >> key >> cached.driverVersion >> cached.result.fillRate >> cached.result.computeRate)
+        m_results[key] = cached;
+
+    LOG_VERBOSE("Loaded ", m_results.size(), " device benchmark results from ", m_cacheFile);
+}
@@ -0,0 +1,186 @@
+#include <drawList.h>
+
+#include <uniformRing.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using VulkanRenderer::DrawCommand;
+using VulkanRenderer::DrawList;
+using VulkanRenderer::DrawListStats;
+using VulkanRenderer::SortKey;
+using VulkanRenderer::SortKeyBits;
+
+namespace
+{
+constexpr SortKey Mask(uint32_t bits)
+{
+    return (SortKey(1) << bits) - 1;
+}
+
+// 8 bits per radix pass, so 8 passes for the whole key
+constexpr uint32_t radixBits = 8;
+constexpr uint32_t radixSize = 1u << radixBits;
+constexpr uint32_t radixPasses = sizeof(SortKey) * 8 / radixBits;
+} // namespace
+
+SortKey VulkanRenderer::MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    float clampedDepth = std::isnan(depth) ? 0.f : std::clamp(depth, 0.f, 1.f);
+    SortKey quantizedDepth = static_cast<SortKey>(clampedDepth * static_cast<float>(Mask(SortKeyBits::depth)));
+
+    SortKey key = pass & Mask(SortKeyBits::pass);
+    key = (key << SortKeyBits::pipeline) | (pipeline & Mask(SortKeyBits::pipeline));
+    key = (key << SortKeyBits::material) | (material & Mask(SortKeyBits::material));
+    key = (key << SortKeyBits::mesh) | (mesh & Mask(SortKeyBits::mesh));
+    key = (key << SortKeyBits::depth) | (quantizedDepth & Mask(SortKeyBits::depth));
+    return key;
+}
+
+uint32_t VulkanRenderer::GetSortKeyPass(SortKey key)
+{
+    return static_cast<uint32_t>(key >> (SortKeyBits::total - SortKeyBits::pass));
+}
+
+DrawListStats& DrawListStats::operator+=(const DrawListStats& other)
+{
+    draws += other.draws;
+    triangles += other.triangles;
+    pipelineBinds += other.pipelineBinds;
+    descriptorBinds += other.descriptorBinds;
+    vertexBufferBinds += other.vertexBufferBinds;
+    return *this;
+}
+
+void DrawList::Clear()
+{
+    m_commands.clear();
+    m_order.clear();
+    m_boundCommandBuffer = VK_NULL_HANDLE;
+    m_boundLayout = VK_NULL_HANDLE;
+    m_boundObjectOffset = 0;
+}
+
+void DrawList::Add(const DrawCommand& command)
+{
+    m_commands.push_back(command);
+}
+
+void DrawList::Sort()
+{
+    const size_t count = m_commands.size();
+
+    m_keys.resize(count);
+    m_keysTemp.resize(count);
+    m_order.resize(count);
+    m_orderTemp.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_keys[i] = m_commands[i].key;
+        m_order[i] = static_cast<uint32_t>(i);
+    }
+
+    // All the histograms in a single read of the keys
+    std::array<std::array<uint32_t, radixSize>, radixPasses> histograms{};
+    for (SortKey key : m_keys)
+    {
+        for (uint32_t pass = 0; pass < radixPasses; ++pass)
+            ++histograms[pass][(key >> (pass * radixBits)) & (radixSize - 1)];
+    }
+
+    // LSD radix sort, each pass is stable so the order of the previous ones is kept
+    for (uint32_t pass = 0; pass < radixPasses; ++pass)
+    {
+        std::array<uint32_t, radixSize>& histogram = histograms[pass];
+
+        // All the keys share this byte (unused fields, single pass...), nothing to do
+        if (std::find(histogram.begin(), histogram.end(), count) != histogram.end())
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram)
+        {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        const uint32_t shift = pass * radixBits;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t destination = histogram[(m_keys[i] >> shift) & (radixSize - 1)]++;
+            m_keysTemp[destination] = m_keys[i];
+            m_orderTemp[destination] = m_order[i];
+        }
+
+        m_keys.swap(m_keysTemp);
+        m_order.swap(m_orderTemp);
+    }
+}
+
+DrawListStats DrawList::Record(VkCommandBuffer commandBuffer, const UniformRing& objectRing, uint32_t objectSetIndex,
+                               uint32_t pass)
+{
+    DrawListStats stats;
+
+    // Not sorted, record in submission order
+    const bool sorted = m_order.size() == m_commands.size();
+
+    // Sets stay bound across subpasses, the previous pass of this command buffer may have bound the same offset
+    if (commandBuffer != m_boundCommandBuffer)
+    {
+        m_boundCommandBuffer = commandBuffer;
+        m_boundLayout = VK_NULL_HANDLE;
+    }
+
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundVertexBufferOffset = 0;
+
+    for (size_t i = 0; i < m_commands.size(); ++i)
+    {
+        const DrawCommand& command = m_commands[sorted ? m_order[i] : i];
+        if (pass != allPasses && VulkanRenderer::GetSortKeyPass(command.key) != pass)
+            continue;
+
+        if (command.pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.pipeline);
+            boundPipeline = command.pipeline;
+            ++stats.pipelineBinds;
+        }
+
+        // A different layout may disturb the sets, so bind again in this case
+        if (command.pipelineLayout != m_boundLayout || command.objectOffset != m_boundObjectOffset)
+        {
+            objectRing.Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.pipelineLayout, objectSetIndex,
+                            command.objectOffset);
+            m_boundLayout = command.pipelineLayout;
+            m_boundObjectOffset = command.objectOffset;
+            ++stats.descriptorBinds;
+        }
+
+        if (command.vertexBuffer != VK_NULL_HANDLE &&
+            (command.vertexBuffer != boundVertexBuffer || command.vertexBufferOffset != boundVertexBufferOffset))
+        {
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &command.vertexBuffer, &command.vertexBufferOffset);
+            boundVertexBuffer = command.vertexBuffer;
+            boundVertexBufferOffset = command.vertexBufferOffset;
+            ++stats.vertexBufferBinds;
+        }
+
+        if (command.indirectBuffer != VK_NULL_HANDLE)
+            vkCmdDrawIndirect(commandBuffer, command.indirectBuffer, command.indirectOffset, 1,
+                              sizeof(VkDrawIndirectCommand));
+        else
+            vkCmdDraw(commandBuffer, command.vertexCount, command.instanceCount, command.firstVertex,
+                      command.firstInstance);
+        ++stats.draws;
+        // Only triangle lists for now
+        stats.triangles += command.vertexCount / 3 * command.instanceCount;
+    }
+
+    return stats;
+}
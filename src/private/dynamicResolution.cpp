@@ -0,0 +1,123 @@
+#include <dynamicResolution.h>
+
+#include <log.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using VulkanRenderer::DynamicResolution;
+using VulkanRenderer::DynamicResolutionConfig;
+
+namespace
+{
+// Start and end of a frame
+constexpr uint32_t queriesPerFrame = 2;
+
+// Weight of the last frame in the smoothed frame time, a single slow frame doesn't change the scale much
+constexpr float frameTimeSmoothing = 0.1f;
+// Aim a bit under the target, so the usual frame to frame noise stays under it
+constexpr float targetHeadroom = 0.9f;
+// Scale changes smaller than this are ignored, the resolution doesn't flicker around a stable load
+constexpr float scaleDeadband = 0.02f;
+// Per frame, down fast and up slowly
+constexpr float maxScaleDecrease = 0.1f;
+constexpr float maxScaleIncrease = 0.02f;
+} // namespace
+
+DynamicResolution::DynamicResolution(DynamicResolutionConfig& config)
+    : m_deviceCache(config.device)
+    , m_timestampPeriod(config.timestampPeriod)
+    , m_targetFrameTime(config.targetFrameTime)
+    , m_minScale(std::min(config.minScale, config.maxScale))
+    , m_maxScale(config.maxScale)
+    , m_scale(config.maxScale)
+{
+    m_pending.resize(config.framesInFlight, false);
+
+    if (config.timestampValidBits == 0)
+    {
+        LOG_ERROR("The graphics queue doesn't support timestamps, the GPU frame time can't be measured");
+        return;
+    }
+
+    if (config.timestampValidBits < 64)
+        m_timestampMask = (1ull << config.timestampValidBits) - 1;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = config.framesInFlight * queriesPerFrame;
+
+    if (vkCreateQueryPool(m_deviceCache, &poolInfo, nullptr, &m_queryPool) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the timestamp query pool");
+        m_queryPool = VK_NULL_HANDLE;
+    }
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    if (m_queryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(m_deviceCache, m_queryPool, nullptr);
+}
+
+void DynamicResolution::BeginFrame(uint32_t frameIndex)
+{
+    if (!m_pending[frameIndex])
+        return;
+
+    m_pending[frameIndex] = false;
+
+    // The fence was waited on, the results are there unless the submission failed
+    std::array<uint64_t, queriesPerFrame> timestamps{};
+    if (vkGetQueryPoolResults(m_deviceCache, m_queryPool, frameIndex * queriesPerFrame, queriesPerFrame,
+                              sizeof(timestamps), timestamps.data(), sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+
+    const uint64_t ticks = (timestamps[1] - timestamps[0]) & m_timestampMask;
+    const double nanoseconds = static_cast<double>(ticks) * m_timestampPeriod;
+    m_lastFrameMicroseconds = static_cast<uint64_t>(nanoseconds / 1000.0);
+
+    UpdateScale(static_cast<float>(nanoseconds / 1000000.0));
+}
+
+void DynamicResolution::RecordStart(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    vkCmdResetQueryPool(commandBuffer, m_queryPool, frameIndex * queriesPerFrame, queriesPerFrame);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool,
+                        frameIndex * queriesPerFrame);
+}
+
+void DynamicResolution::RecordEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool,
+                        frameIndex * queriesPerFrame + 1);
+    m_pending[frameIndex] = true;
+}
+
+VkExtent2D DynamicResolution::GetRenderExtent(VkExtent2D extent) const
+{
+    return {std::max(1u, static_cast<uint32_t>(static_cast<float>(extent.width) * m_scale)),
+            std::max(1u, static_cast<uint32_t>(static_cast<float>(extent.height) * m_scale))};
+}
+
+void DynamicResolution::UpdateScale(float frameTime)
+{
+    m_frameTime = m_frameTime == 0.f ? frameTime : m_frameTime + (frameTime - m_frameTime) * frameTimeSmoothing;
+    if (m_frameTime <= 0.f)
+        return;
+
+    // The GPU time mostly follows the pixel count, the square of the scale
+    const float wantedScale = m_scale * std::sqrt(m_targetFrameTime * targetHeadroom / m_frameTime);
+    const float change = std::clamp(wantedScale - m_scale, -maxScaleDecrease, maxScaleIncrease);
+    if (std::abs(change) < scaleDeadband && wantedScale > m_minScale && wantedScale < m_maxScale)
+        return;
+
+    const float scale = std::clamp(m_scale + change, m_minScale, m_maxScale);
+    if (scale != m_scale)
+        LOG_VERBOSE("Render scale ", scale, ", GPU frame time ", m_frameTime, " ms");
+
+    m_scale = scale;
+}
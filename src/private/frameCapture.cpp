@@ -0,0 +1,257 @@
+#include <frameCapture.h>
+
+#include <log.h>
+#include <utils/file.h>
+#include <utils/memory.h>
+#include <utils/png.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+using VulkanRenderer::CaptureFormat;
+using VulkanRenderer::FrameCapture;
+using VulkanRenderer::FrameCaptureConfig;
+
+namespace
+{
+constexpr VkDeviceSize bytesPerPixel = 4;
+} // namespace
+
+FrameCapture::FrameCapture(FrameCaptureConfig& config)
+    : m_deviceCache(config.device)
+    , m_physicalDevice(config.physicalDevice)
+    , m_jobSystem(config.jobSystem)
+    , m_outputFolder(config.outputFolder)
+    , m_format(config.format)
+{
+    std::error_code error;
+    if (!m_outputFolder.empty() && !std::filesystem::create_directories(m_outputFolder, error) && error)
+        LOG_ERROR("Failed to create the capture folder ", m_outputFolder, ": ", error.message());
+
+    // Buffers are only allocated on the first capture, most runs never capture anything
+    m_readbacks.resize(config.bufferCount);
+    for (std::unique_ptr<Readback>& readback : m_readbacks)
+        readback = std::make_unique<Readback>();
+}
+
+FrameCapture::~FrameCapture()
+{
+    // Copies still waiting for their frame were never read, only the encodings need to end
+    m_jobSystem->Wait(m_encodings);
+
+    for (std::unique_ptr<Readback>& readback : m_readbacks)
+        VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, readback->buffer, readback->memory);
+}
+
+bool FrameCapture::IsFormatSupported(VkFormat format)
+{
+    return IsBgra(format) || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+bool FrameCapture::IsBgra(VkFormat format)
+{
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+bool FrameCapture::Reserve(Readback& readback, VkDeviceSize size)
+{
+    if (readback.size >= size)
+        return true;
+
+    // Free, so neither the GPU nor a worker uses it anymore
+    VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, readback.buffer, readback.memory);
+    readback.buffer = VK_NULL_HANDLE;
+    readback.memory = VK_NULL_HANDLE;
+    readback.mapped = nullptr;
+    readback.size = 0;
+
+    // Read by the CPU, cached memory makes a big difference there
+    if (!VulkanRenderer::Utils::CreateBuffer(
+            m_deviceCache, m_physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback.buffer,
+            readback.memory, VK_MEMORY_PROPERTY_HOST_CACHED_BIT))
+    {
+        LOG_ERROR("Failed to create a capture readback buffer");
+        return false;
+    }
+
+    if (vkMapMemory(m_deviceCache, readback.memory, 0, VK_WHOLE_SIZE, 0, &readback.mapped) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to map a capture readback buffer");
+        VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, readback.buffer, readback.memory);
+        readback.buffer = VK_NULL_HANDLE;
+        readback.memory = VK_NULL_HANDLE;
+        return false;
+    }
+
+    readback.size = size;
+    return true;
+}
+
+bool FrameCapture::RecordCopy(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber, uint32_t view,
+                              VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout)
+{
+    if (!IsFormatSupported(format))
+    {
+        ++m_skippedCount;
+        return false;
+    }
+
+    Readback* readback = nullptr;
+    for (std::unique_ptr<Readback>& candidate : m_readbacks)
+    {
+        if (candidate->state.load(std::memory_order_acquire) == ReadbackState::Free)
+        {
+            readback = candidate.get();
+            break;
+        }
+    }
+
+    // All the buffers are waiting for the GPU or for a worker, skip this frame rather than waiting
+    const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * bytesPerPixel;
+    if (readback == nullptr || !Reserve(*readback, size))
+    {
+        ++m_skippedCount;
+        return false;
+    }
+
+    readback->state.store(ReadbackState::Copying, std::memory_order_relaxed);
+    readback->frameIndex = frameIndex;
+    readback->frameNumber = frameNumber;
+    readback->view = view;
+    readback->format = format;
+    readback->extent = extent;
+
+    // Rendering must be done before the copy reads the image
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = layout;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    // Rows tightly packed
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {extent.width, extent.height, 1};
+
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback->buffer, 1, &region);
+
+    // Give the image back as it was, and make the copy visible to the host once the frame fence is signaled
+    VkImageMemoryBarrier toOriginal = toTransfer;
+    toOriginal.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toOriginal.dstAccessMask = 0;
+    toOriginal.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toOriginal.newLayout = layout;
+
+    VkBufferMemoryBarrier toHost{};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = readback->buffer;
+    toHost.offset = 0;
+    toHost.size = size;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                         &toHost, 1, &toOriginal);
+
+    return true;
+}
+
+void FrameCapture::BeginFrame(uint32_t frameIndex)
+{
+    for (std::unique_ptr<Readback>& readback : m_readbacks)
+    {
+        if (readback->frameIndex != frameIndex ||
+            readback->state.load(std::memory_order_relaxed) != ReadbackState::Copying)
+            continue;
+
+        readback->state.store(ReadbackState::Encoding, std::memory_order_relaxed);
+
+        Readback* encoded = readback.get();
+        m_jobSystem->Run([this, encoded]() { Encode(*encoded); }, &m_encodings);
+    }
+}
+
+void FrameCapture::DiscardFrame(uint32_t frameIndex)
+{
+    for (std::unique_ptr<Readback>& readback : m_readbacks)
+    {
+        if (readback->frameIndex != frameIndex ||
+            readback->state.load(std::memory_order_relaxed) != ReadbackState::Copying)
+            continue;
+
+        // The buffer was never written, its content must not reach a file
+        Release(*readback);
+        ++m_skippedCount;
+    }
+}
+
+void FrameCapture::Encode(Readback& readback)
+{
+    // The readback can be reused as soon as it is released, keep what is needed after
+    const uint64_t frameNumber = readback.frameNumber;
+    const uint32_t view = readback.view;
+    const VkExtent2D extent = readback.extent;
+    const bool bgra = IsBgra(readback.format);
+
+    // Several views of the same frame don't overwrite each other, the first one keeps the plain name
+    char viewSuffix[16] = "";
+    if (view != 0)
+        std::snprintf(viewSuffix, sizeof(viewSuffix), "_view%u", view);
+
+    char fileName[96];
+    if (m_format == CaptureFormat::Png)
+        std::snprintf(fileName, sizeof(fileName), "frame_%06llu%s.png", static_cast<unsigned long long>(frameNumber),
+                      viewSuffix);
+    else
+        std::snprintf(fileName, sizeof(fileName), "frame_%06llu%s_%ux%u_%s.raw",
+                      static_cast<unsigned long long>(frameNumber), viewSuffix, extent.width, extent.height,
+                      bgra ? "bgra" : "rgba");
+
+    const std::string path = (std::filesystem::path(m_outputFolder) / fileName).string();
+    const uint8_t* pixels = static_cast<const uint8_t*>(readback.mapped);
+    const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+
+    bool written = false;
+    if (m_format == CaptureFormat::Raw)
+    {
+        written = VulkanRenderer::Utils::WriteFile(path.c_str(), pixels, pixelCount * bytesPerPixel);
+        Release(readback);
+    }
+    else
+    {
+        // Swizzled out of the mapped memory first, so the buffer is free before the slow part
+        // The swap chain is presented opaque, whatever its alpha
+        std::vector<uint8_t> rgba(pixelCount * bytesPerPixel);
+        VulkanRenderer::Utils::ConvertToOpaqueRgba(pixels, pixelCount, bgra, rgba.data());
+
+        Release(readback);
+        written = VulkanRenderer::Utils::WritePng(path.c_str(), rgba.data(), extent.width, extent.height);
+    }
+
+    if (written)
+        m_writtenCount.fetch_add(1, std::memory_order_relaxed);
+    else
+        LOG_ERROR("Failed to write the capture ", path);
+}
+
+void FrameCapture::Release(Readback& readback)
+{
+    readback.state.store(ReadbackState::Free, std::memory_order_release);
+}
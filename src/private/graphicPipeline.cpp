@@ -1,20 +1,42 @@
 #include <graphicPipeline.h>
+#include <log.h>
+#include <renderTarget.h>
 #include <shader.h>
+#include <utils/pipeline.h>
 
-#include <array>
 #include <cstdint>
-#include <iostream>
 
 using VulkanRenderer::GraphicPipeline;
 using VulkanRenderer::GraphicPipelineConfig;
+using VulkanRenderer::GraphicProgram;
 using VulkanRenderer::Shader;
+using VulkanRenderer::ShaderFeatureMask;
 using VulkanRenderer::ShaderType;
 
+GraphicProgram::GraphicProgram(VulkanRenderer::PipelineRegistry* registry)
+    : registry(registry)
+{
+}
+
+GraphicProgram::~GraphicProgram()
+{
+    for (auto& [features, handle] : pipelines)
+        registry->Release(handle);
+
+    for (auto& [features, handle] : depthPipelines)
+        registry->Release(handle);
+}
+
 GraphicPipeline::GraphicPipeline(GraphicPipelineConfig& config)
     : m_deviceCache(config.device)
+    , m_framesInFlight(config.framesInFlight)
     , m_renderPass(VK_NULL_HANDLE)
-    , m_pipeline(VK_NULL_HANDLE)
     , m_pipelineLayout(VK_NULL_HANDLE)
+    , m_samples(config.samples)
+    , m_depthPrepass(config.depthPrepass)
+    , m_entryPoint(config.pipelineName)
+    , m_registry(config.registry)
+    , m_defaultFeatures(config.defaultFeatures & VulkanRenderer::allShaderFeatures)
 {
     CreateRenderPass(config);
     CreatePipelineLayoutAndPipeline(config);
@@ -22,59 +44,15 @@ GraphicPipeline::GraphicPipeline(GraphicPipelineConfig& config)
 
 void GraphicPipeline::CreateRenderPass(GraphicPipelineConfig& config)
 {
-    VkAttachmentDescription colorAttachment{};
-    // We need to have exactly the same format as the swap chain
-    colorAttachment.format = config.swapChainFormat;
-    // No multisampling for now, so use only a single sample
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    // Nothing fancy done while loading/storing color/depth/stencil data
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    // Don't care about the previous image layout, and the final layout
-    // is in our swap chain
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    // Reference for the above description.
-    // Will be at the index 0 for the glsl layout
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // For now we only have a single subpass
-    VkSubpassDescription subpassDesc{};
-    subpassDesc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpassDesc.colorAttachmentCount = 1;
-    subpassDesc.pColorAttachments = &colorAttachmentRef;
-
-    // But we still have "implicit" subpasses (before and after), so we need to add dependencies
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0; // Our subpass
-
-    // We need for the swap chain to finish reading from the image before accessing it
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    // Finally create the renderpass
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpassDesc;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-
-    if (vkCreateRenderPass(m_deviceCache, &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS)
-    {
-        std::cout << "Failed to create the render pass" << std::endl;
-        m_renderPass = VK_NULL_HANDLE;
-    }
+    // Same as the offscreen targets, so they can all be drawn with the same pipelines
+    VulkanRenderer::SceneRenderPassDesc desc;
+    desc.colorFormat = config.swapChainFormat;
+    desc.depthFormat = config.depthFormat;
+    desc.samples = m_samples;
+    desc.depthPrepass = m_depthPrepass;
+
+    m_renderPass = VulkanRenderer::RenderTarget::CreateRenderPass(m_deviceCache, desc, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                                                  config.keepDepth);
 }
 
 void GraphicPipeline::CreatePipelineLayoutAndPipeline(GraphicPipelineConfig& config)
@@ -84,167 +62,238 @@ void GraphicPipeline::CreatePipelineLayoutAndPipeline(GraphicPipelineConfig& con
         return;
     }
 
-    // Step 1: Shaders
-    m_vertShader = Shader::CreateFromFile(m_deviceCache, ShaderType::Vertex, config.vertShaderFile);
-    if (!m_vertShader)
+    // Step 1: Viewport and scissors
+    // Note that since we went with a dynamic state, viewport and scissors will be given
+    // when we are drawing.
+    m_viewport.x = 0.0f;
+    m_viewport.y = 0.0f;
+    m_viewport.width = (float)config.viewportWidth;
+    m_viewport.height = (float)config.viewportHeight;
+    m_viewport.minDepth = 0.0f;
+    m_viewport.maxDepth = 1.0f;
+
+    m_scissors.offset = {0, 0};
+    m_scissors.extent = VkExtent2D{config.viewportWidth, config.viewportHeight};
+
+    // Step 2: Layout, shared by all the variants
+    m_pipelineLayout = VulkanRenderer::Utils::CreatePipelineLayout(m_deviceCache, config.descriptorSetLayouts,
+                                                                   config.pushConstantRanges);
+    if (m_pipelineLayout == VK_NULL_HANDLE)
+        return;
+
+    // Step 3: Shaders
+    // Modules are kept alive, every feature variant is created from them.
+    auto vertShader = Shader::Create(m_deviceCache, ShaderType::Vertex, config.vertShaderCode, config.vertShaderFile);
+    if (!vertShader)
     {
-        std::cout << "Failed to create vertex shader" << std::endl;
+        LOG_ERROR("Failed to create vertex shader");
         return;
     }
 
-    m_fragShader = Shader::CreateFromFile(m_deviceCache, ShaderType::Fragment, config.fragShaderFile);
-    if (!m_fragShader)
+    auto fragShader = Shader::Create(m_deviceCache, ShaderType::Fragment, config.fragShaderCode, config.fragShaderFile);
+    if (!fragShader)
     {
-        std::cout << "Failed to create fragment shader" << std::endl;
+        LOG_ERROR("Failed to create fragment shader");
         return;
     }
 
-    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStageInfos{};
-    for (auto i = 0; i < 2; ++i)
+    // And finally create the default variant, others will come on demand
+    m_program = CreateProgram(std::move(vertShader), std::move(fragShader), {m_defaultFeatures});
+}
+
+std::unique_ptr<GraphicProgram> GraphicPipeline::CreateProgram(const std::vector<char>& vertCode,
+                                                               const std::vector<char>& fragCode,
+                                                               const std::vector<ShaderFeatureMask>& features) const
+{
+    if (m_pipelineLayout == VK_NULL_HANDLE)
+        return nullptr;
+
+    auto vertShader = Shader::Create(m_deviceCache, ShaderType::Vertex, &vertCode, nullptr);
+    auto fragShader = Shader::Create(m_deviceCache, ShaderType::Fragment, &fragCode, nullptr);
+    if (!vertShader || !fragShader)
     {
-        shaderStageInfos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        shaderStageInfos[i].pName = config.pipelineName;
+        LOG_ERROR("Failed to create the reloaded shaders");
+        return nullptr;
     }
 
-    // Vertex (first index)
-    shaderStageInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    shaderStageInfos[0].module = m_vertShader->GetModule();
-    // Fragment (second index)
-    shaderStageInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    shaderStageInfos[1].module = m_fragShader->GetModule();
+    // Keep the current program rather than losing the variant drawn by default
+    auto program = CreateProgram(std::move(vertShader), std::move(fragShader), features);
+    auto defaultPipeline = program->pipelines.find(m_defaultFeatures);
+    if (defaultPipeline != program->pipelines.end() &&
+        VulkanRenderer::PipelineRegistry::Get(defaultPipeline->second) == VK_NULL_HANDLE)
+        return nullptr;
 
-    // Step 2: Dynamic state
-    std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    return program;
+}
 
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-    dynamicState.pDynamicStates = dynamicStates.data();
+std::unique_ptr<GraphicProgram> GraphicPipeline::CreateProgram(std::unique_ptr<Shader> vertShader,
+                                                               std::unique_ptr<Shader> fragShader,
+                                                               const std::vector<ShaderFeatureMask>& features) const
+{
+    auto program = std::make_unique<GraphicProgram>(m_registry);
+    program->vertShader = std::move(vertShader);
+    program->fragShader = std::move(fragShader);
 
-    // Step 3: Vertex input
-    // Note: As vertex data is hardcoded in the shader (for now), there is not a lot to do.
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.pVertexBindingDescriptions = nullptr; // Optional
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions = nullptr; // Optional
-
-    // Step 4: Input assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    // Step 5: Viewport and scissors
-    // Note that since we went with a dynamic state, viewport and scissors will be given
-    // when we are drawing.
-    m_viewport.x = 0.0f;
-    m_viewport.y = 0.0f;
-    m_viewport.width = (float)config.viewportWidth;
-    m_viewport.height = (float)config.viewportHeight;
-    m_viewport.minDepth = 0.0f;
-    m_viewport.maxDepth = 1.0f;
+    // Failures are kept too, a variant broken by an edit is not rebuilt every frame
+    for (ShaderFeatureMask variant : features)
+    {
+        variant &= VulkanRenderer::allShaderFeatures;
+        program->pipelines.emplace(variant, CreatePipelineVariant(*program, variant, false));
+        if (m_depthPrepass)
+            program->depthPipelines.emplace(variant, CreatePipelineVariant(*program, variant, true));
+    }
 
-    m_scissors.offset = {0, 0};
-    m_scissors.extent = VkExtent2D{config.viewportWidth, config.viewportHeight};
+    return program;
+}
 
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount = 1;
-
-    // Step 6: Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-    rasterizer.depthBiasClamp = 0.0f;          // Optional
-    rasterizer.depthBiasSlopeFactor = 0.0f;    // Optional
-
-    // Step 7: Multisampling
-    // For now, it is disabled
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f;          // Optional
-    multisampling.pSampleMask = nullptr;            // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE;      // Optional
-
-    // Step 8: Depth and stencil testing
-    // Not used for now
-    VkPipelineDepthStencilStateCreateInfo depthStencilState{};
-
-    // Step 9: Color blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.colorWriteMask =
-        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-
-    // Step 10: Viewport
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0;            // Optional
-    pipelineLayoutInfo.pSetLayouts = nullptr;         // Optional
-    pipelineLayoutInfo.pushConstantRangeCount = 0;    // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-    if (vkCreatePipelineLayout(m_deviceCache, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
-    {
-        std::cout << "Failed to create pipeline layout!" << std::endl;
-        m_pipelineLayout = VK_NULL_HANDLE;
+void GraphicPipeline::SwapProgram(std::unique_ptr<GraphicProgram> program)
+{
+    if (!program)
         return;
-    }
 
-    // And finally create the pipeline
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStageInfos.data();
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = m_pipelineLayout;
-    pipelineInfo.renderPass = m_renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1;              // Optional
-
-    if (vkCreateGraphicsPipelines(m_deviceCache, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS)
+    // Frames in flight may still draw with the previous variants
+    if (m_program)
+        m_retiredPrograms.push_back({std::move(m_program), m_framesInFlight});
+
+    m_program = std::move(program);
+}
+
+void GraphicPipeline::BeginFrame()
+{
+    for (RetiredProgram& retired : m_retiredPrograms)
+        --retired.framesLeft;
+
+    std::erase_if(m_retiredPrograms, [](const RetiredProgram& retired) { return retired.framesLeft == 0; });
+}
+
+std::vector<ShaderFeatureMask> GraphicPipeline::GetFeatureVariants() const
+{
+    std::vector<ShaderFeatureMask> features;
+    if (!m_program)
+        return features;
+
+    features.reserve(m_program->pipelines.size());
+    for (const auto& [variant, handle] : m_program->pipelines)
+        features.push_back(variant);
+
+    return features;
+}
+
+VkPipeline GraphicPipeline::GetPipeline(ShaderFeatureMask features)
+{
+    features &= VulkanRenderer::allShaderFeatures;
+
+    if (!m_program)
+        return VK_NULL_HANDLE;
+
+    // The registry may have replaced the pipeline with a faster one since the last frame
+    auto it = m_program->pipelines.find(features);
+    if (it != m_program->pipelines.end())
+        return VulkanRenderer::PipelineRegistry::Get(it->second);
+
+    // Failures are cached too, so a broken variant is not rebuilt every frame
+    auto handle = CreatePipelineVariant(*m_program, features, false);
+    m_program->pipelines.emplace(features, handle);
+    return VulkanRenderer::PipelineRegistry::Get(handle);
+}
+
+VkPipeline GraphicPipeline::GetDepthPipeline(ShaderFeatureMask features)
+{
+    features &= VulkanRenderer::allShaderFeatures;
+
+    if (!m_program || !m_depthPrepass)
+        return VK_NULL_HANDLE;
+
+    auto it = m_program->depthPipelines.find(features);
+    if (it != m_program->depthPipelines.end())
+        return VulkanRenderer::PipelineRegistry::Get(it->second);
+
+    auto handle = CreatePipelineVariant(*m_program, features, true);
+    m_program->depthPipelines.emplace(features, handle);
+    return VulkanRenderer::PipelineRegistry::Get(handle);
+}
+
+VulkanRenderer::PipelineRegistry::Handle GraphicPipeline::CreatePipelineVariant(const GraphicProgram& program,
+                                                                               ShaderFeatureMask features,
+                                                                               bool depthOnly) const
+{
+    VulkanRenderer::GraphicPipelineState state;
+
+    // Step 1: Shader stages, specialized for the features
+    // Both stages share the same constants, each one only reads those it declares.
+    state.stages.push_back({VK_SHADER_STAGE_VERTEX_BIT, program.vertShader->GetModule(),
+                            program.vertShader->GetCodeHash(), m_entryPoint});
+    // Nothing to shade for the depth only variant
+    if (!depthOnly)
+        state.stages.push_back({VK_SHADER_STAGE_FRAGMENT_BIT, program.fragShader->GetModule(),
+                                program.fragShader->GetCodeHash(), m_entryPoint});
+
+    VulkanRenderer::ShaderSpecialization specialization(features);
+    const VkSpecializationInfo* specializationInfo = specialization.GetInfo();
+    const auto* specializationData = static_cast<const uint8_t*>(specializationInfo->pData);
+    state.specializationEntries.assign(specializationInfo->pMapEntries,
+                                       specializationInfo->pMapEntries + specializationInfo->mapEntryCount);
+    state.specializationData.assign(specializationData, specializationData + specializationInfo->dataSize);
+
+    // Step 2: Dynamic state
+    state.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    // Step 3: Vertex input
+    // Note: As vertex data is hardcoded in the shader (for now), there is not a lot to do.
+    state.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    // Step 4: Rasterizer and multisampling, same samples as the render pass
+    state.polygonMode = VK_POLYGON_MODE_FILL;
+    state.cullMode = VK_CULL_MODE_BACK_BIT;
+    state.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    state.samples = m_samples;
+
+    // Step 5: Depth testing
+    // Reverse-Z, nearer is greater. After a prepass the depth is final, the color subpass only shades the
+    // fragments that wrote it, which needs an invariant position in the vertex shader.
+    const bool depthFinal = m_depthPrepass && !depthOnly;
+    state.depthTest = true;
+    state.depthWrite = !depthFinal;
+    state.depthCompareOp = depthFinal ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_GREATER_OR_EQUAL;
+
+    // Step 6: Color blending
+    // The prepass subpass has no color attachment
+    if (!depthOnly)
     {
-        std::cout << "Failed to create pipeline" << std::endl;
-        m_pipeline = VK_NULL_HANDLE;
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        colorBlendAttachment.colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_FALSE;
+        state.colorBlend.push_back(colorBlendAttachment);
     }
+
+    // And finally get the pipeline, compiled only if no other program has the same state
+    state.layout = m_pipelineLayout;
+    state.renderPass = m_renderPass;
+    state.subpass = m_depthPrepass && !depthOnly ? 1 : 0;
+
+    auto handle = m_registry->Acquire(state);
+    if (VulkanRenderer::PipelineRegistry::Get(handle) == VK_NULL_HANDLE)
+        LOG_ERROR("Failed to create pipeline for features ", features);
+
+    return handle;
 }
 
 GraphicPipeline::~GraphicPipeline()
 {
-    vkDestroyPipeline(m_deviceCache, m_pipeline, nullptr);
+    m_program.reset();
+    m_retiredPrograms.clear();
+
     vkDestroyPipelineLayout(m_deviceCache, m_pipelineLayout, nullptr);
     vkDestroyRenderPass(m_deviceCache, m_renderPass, nullptr);
 }
 
 bool GraphicPipeline::IsValid() const
 {
-    return m_vertShader && m_fragShader && m_pipelineLayout != VK_NULL_HANDLE && m_pipeline != VK_NULL_HANDLE &&
-           m_renderPass != VK_NULL_HANDLE;
+    if (!m_program || m_pipelineLayout == VK_NULL_HANDLE || m_renderPass == VK_NULL_HANDLE)
+        return false;
+
+    auto defaultPipeline = m_program->pipelines.find(m_defaultFeatures);
+    return defaultPipeline != m_program->pipelines.end() &&
+           VulkanRenderer::PipelineRegistry::Get(defaultPipeline->second) != VK_NULL_HANDLE;
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include <initGraph.h>
+
+#include <jobSystem.h>
+#include <log.h>
+#include <profiler.h>
+
+#include <iomanip>
+#include <thread>
+
+using VulkanRenderer::InitGraph;
+using VulkanRenderer::InitStepId;
+
+namespace
+{
+double ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+InitStepId InitGraph::AddStep(const char* name, std::function<int()> function, std::vector<InitStepId> dependencies,
+                              InitThread thread)
+{
+    const InitStepId stepId = static_cast<InitStepId>(m_steps.size());
+
+    Step& step = m_steps.emplace_back();
+    step.name = name;
+    step.function = std::move(function);
+    step.thread = thread;
+
+    for (InitStepId dependency : dependencies)
+    {
+        if (dependency >= stepId)
+        {
+            LOG_WARNING("Init step ", name, " depends on a step not added yet, dependency ignored");
+            continue;
+        }
+
+        m_steps[dependency].dependents.push_back(stepId);
+        ++step.dependencyCount;
+    }
+
+    return stepId;
+}
+
+int InitGraph::Run(JobSystem* jobSystem)
+{
+    m_runStart = std::chrono::steady_clock::now();
+    m_error = 0;
+    m_mainQueue.clear();
+
+    for (Step& step : m_steps)
+    {
+        step.remainingDependencies = step.dependencyCount;
+        step.done = false;
+        step.failed = false;
+    }
+
+    return jobSystem != nullptr ? RunParallel(*jobSystem) : RunSerial();
+}
+
+int InitGraph::RunSerial()
+{
+    // Steps were added after their dependencies, so the order of addition is already valid
+    for (InitStepId stepId = 0; stepId < m_steps.size(); ++stepId)
+    {
+        Execute(stepId);
+        if (m_error != 0)
+            return m_error;
+
+        Complete(stepId);
+    }
+
+    return 0;
+}
+
+int InitGraph::RunParallel(JobSystem& jobSystem)
+{
+    JobCounter counter;
+    size_t mainStepsLeft = 0;
+
+    std::function<void(InitStepId)> schedule = [&](InitStepId stepId)
+    {
+        if (m_steps[stepId].thread == InitThread::Main)
+        {
+            std::lock_guard lock(m_mutex);
+            m_mainQueue.push_back(stepId);
+            return;
+        }
+
+        jobSystem.Run(
+            [&, stepId]()
+            {
+                Execute(stepId);
+                for (InitStepId ready : Complete(stepId))
+                    schedule(ready);
+            },
+            &counter);
+    };
+
+    for (InitStepId stepId = 0; stepId < m_steps.size(); ++stepId)
+    {
+        if (m_steps[stepId].thread == InitThread::Main)
+            ++mainStepsLeft;
+
+        if (m_steps[stepId].dependencyCount == 0)
+            schedule(stepId);
+    }
+
+    // This thread runs its own steps, and only helps the workers once they are all done.
+    // Otherwise a long job could delay a main thread step the others are waiting for.
+    while (mainStepsLeft > 0)
+    {
+        InitStepId stepId = 0;
+        bool hasStep = false;
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_error != 0)
+                break;
+
+            if (!m_mainQueue.empty())
+            {
+                stepId = m_mainQueue.back();
+                m_mainQueue.pop_back();
+                hasStep = true;
+            }
+        }
+
+        if (!hasStep)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        Execute(stepId);
+        --mainStepsLeft;
+
+        for (InitStepId ready : Complete(stepId))
+            schedule(ready);
+    }
+
+    jobSystem.Wait(counter);
+    return m_error;
+}
+
+void InitGraph::Execute(InitStepId stepId)
+{
+    Step& step = m_steps[stepId];
+    PROFILE_SCOPE(step.name);
+
+    auto start = std::chrono::steady_clock::now();
+    int result = step.function();
+    auto end = std::chrono::steady_clock::now();
+
+    step.start = start - m_runStart;
+    step.duration = end - start;
+
+    if (result != 0)
+    {
+        LOG_ERROR("Init step ", step.name, " failed");
+        step.failed = true;
+
+        std::lock_guard lock(m_mutex);
+        if (m_error == 0)
+            m_error = result;
+    }
+}
+
+std::vector<InitStepId> InitGraph::Complete(InitStepId stepId)
+{
+    std::vector<InitStepId> ready;
+
+    std::lock_guard lock(m_mutex);
+
+    // Once a step failed, nothing new starts
+    if (m_error != 0)
+        return ready;
+
+    Step& step = m_steps[stepId];
+    step.done = true;
+
+    for (InitStepId dependent : step.dependents)
+    {
+        if (--m_steps[dependent].remainingDependencies == 0)
+            ready.push_back(dependent);
+    }
+
+    return ready;
+}
+
+void InitGraph::DumpTimings(std::ostream& stream) const
+{
+    // No trailing new line, the caller decides
+    stream << "Init steps (start / duration in ms):";
+
+    for (const Step& step : m_steps)
+    {
+        stream << "\n  " << std::left << std::setw(24) << step.name << std::right << std::fixed << std::setprecision(2);
+
+        if (step.done)
+            stream << std::setw(10) << ToMilliseconds(step.start) << std::setw(10) << ToMilliseconds(step.duration);
+        else if (step.failed)
+            stream << "  failed";
+        else
+            stream << "  not run";
+    }
+}
@@ -0,0 +1,340 @@
+#include <jobSystem.h>
+#include <profiler.h>
+
+#include <utils/workStealingDeque.h>
+
+#include <algorithm>
+#include <utility>
+
+using VulkanRenderer::JobCounter;
+using VulkanRenderer::JobSystem;
+using VulkanRenderer::JobSystemConfig;
+using VulkanRenderer::Task;
+
+namespace
+{
+constexpr uint32_t dequeCapacityLog2 = 12;
+constexpr uint32_t invalidWorkerIndex = ~0u;
+
+// Failed attempts to find a job before going to sleep
+constexpr uint32_t spinCount = 64;
+
+// Set for the threads registered in a job system
+thread_local const JobSystem* t_jobSystem = nullptr;
+thread_local uint32_t t_workerIndex = invalidWorkerIndex;
+} // namespace
+
+struct JobSystem::Job
+{
+    std::function<void()> function;
+    std::coroutine_handle<> coroutine; // Resumed instead of the function when set
+    JobCounter* counter = nullptr;
+};
+
+struct JobSystem::Worker
+{
+    Worker()
+        : deque(dequeCapacityLog2)
+    {
+    }
+
+    VulkanRenderer::Utils::WorkStealingDeque<Job> deque;
+    std::thread thread;
+};
+
+void Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+    // Frame is gone before the counter is released, so nothing waiting on it sees a living coroutine
+    JobSystem* jobSystem = handle.promise().jobSystem;
+    JobCounter* counter = handle.promise().counter;
+    handle.destroy();
+
+    if (counter != nullptr)
+        jobSystem->Decrement(*counter);
+}
+
+Task::Task(std::coroutine_handle<promise_type> handle)
+    : m_handle(handle)
+{
+}
+
+Task::Task(Task&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+{
+}
+
+Task& Task::operator=(Task&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_handle)
+            m_handle.destroy();
+
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+
+    return *this;
+}
+
+Task::~Task()
+{
+    // Never scheduled
+    if (m_handle)
+        m_handle.destroy();
+}
+
+std::coroutine_handle<Task::promise_type> Task::Release()
+{
+    return std::exchange(m_handle, nullptr);
+}
+
+JobSystem::JobSystem(JobSystemConfig& config)
+{
+    uint32_t workerCount = config.workerCount;
+    if (workerCount == 0)
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    // The calling thread is the first worker, it only runs jobs when waiting
+    t_jobSystem = this;
+    t_workerIndex = 0;
+
+    for (uint32_t i = 0; i < workerCount + 1; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+
+    // Only start the threads once all the deques exist, they steal from each other
+    for (uint32_t i = 1; i < m_workers.size(); ++i)
+        m_workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    m_stop = true;
+    m_pendingJobs.fetch_add(1, std::memory_order_release);
+    m_pendingJobs.notify_all();
+
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+
+    // Jobs never run are dropped, along with the frames of the coroutines they would have resumed
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        while (Job* job = worker->deque.Steal())
+            Drop(job);
+    }
+
+    for (Job* job : m_sharedQueue)
+        Drop(job);
+
+    if (t_jobSystem == this)
+    {
+        t_jobSystem = nullptr;
+        t_workerIndex = invalidWorkerIndex;
+    }
+}
+
+uint32_t JobSystem::GetCurrentWorkerIndex() const
+{
+    return t_jobSystem == this ? t_workerIndex : invalidWorkerIndex;
+}
+
+void JobSystem::Run(std::function<void()> job, JobCounter* counter)
+{
+    if (counter != nullptr)
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+    Push(new Job{std::move(job), nullptr, counter});
+}
+
+void JobSystem::Run(Task task, JobCounter* counter)
+{
+    std::coroutine_handle<Task::promise_type> handle = task.Release();
+    if (!handle)
+        return;
+
+    // The counter is released by the task itself, once it reaches its end
+    handle.promise().jobSystem = this;
+    handle.promise().counter = counter;
+
+    if (counter != nullptr)
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+    Resume(handle);
+}
+
+void JobSystem::Resume(std::coroutine_handle<> handle)
+{
+    Push(new Job{nullptr, handle, nullptr});
+}
+
+void JobSystem::Push(Job* job)
+{
+    uint32_t workerIndex = GetCurrentWorkerIndex();
+
+    // Counted before it can be taken, so the count never goes below the jobs visible: a thief decrementing it first
+    // would wrap it, and keep the idle workers spinning
+    m_pendingJobs.fetch_add(1, std::memory_order_relaxed);
+
+    // Full deque or foreign thread: go through the shared queue
+    if (workerIndex == invalidWorkerIndex || !m_workers[workerIndex]->deque.Push(job))
+    {
+        std::lock_guard lock(m_sharedQueueMutex);
+        m_sharedQueue.push_back(job);
+    }
+
+    m_pendingJobs.notify_one();
+}
+
+JobSystem::Job* JobSystem::FindJob(uint32_t workerIndex)
+{
+    Job* job = nullptr;
+
+    // Own jobs first, the most recent is the most likely to be in cache
+    if (workerIndex != invalidWorkerIndex)
+        job = m_workers[workerIndex]->deque.Pop();
+
+    if (job == nullptr)
+    {
+        std::unique_lock lock(m_sharedQueueMutex, std::try_to_lock);
+        if (lock.owns_lock() && !m_sharedQueue.empty())
+        {
+            job = m_sharedQueue.front();
+            m_sharedQueue.pop_front();
+        }
+    }
+
+    // Then steal, starting after our own index so thieves spread over the victims
+    const uint32_t workerCount = static_cast<uint32_t>(m_workers.size());
+    const uint32_t start = workerIndex == invalidWorkerIndex ? 0 : workerIndex + 1;
+    for (uint32_t i = 0; job == nullptr && i < workerCount; ++i)
+    {
+        uint32_t victim = (start + i) % workerCount;
+        if (victim != workerIndex)
+            job = m_workers[victim]->deque.Steal();
+    }
+
+    if (job != nullptr)
+        m_pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+
+    return job;
+}
+
+void JobSystem::Execute(Job* job)
+{
+    if (job->coroutine)
+        job->coroutine.resume();
+    else
+        job->function();
+
+    if (job->counter != nullptr)
+        Decrement(*job->counter);
+
+    delete job;
+}
+
+void JobSystem::Drop(Job* job)
+{
+    if (job->coroutine)
+        job->coroutine.destroy();
+
+    delete job;
+}
+
+void JobSystem::Decrement(JobCounter& counter)
+{
+    // Zero is published under the lock, so the waiters are handed off before Wait can return and the owner destroy
+    // the counter. The counter is not touched once the lock is released.
+    std::vector<std::coroutine_handle<>> waiters;
+    {
+        std::lock_guard lock(counter.m_waitersMutex);
+        if (counter.m_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        // Last job done, wake up the coroutines waiting on it
+        waiters.swap(counter.m_waiters);
+    }
+
+    for (std::coroutine_handle<> waiter : waiters)
+        Resume(waiter);
+}
+
+bool JobSystem::CounterAwaiter::await_suspend(std::coroutine_handle<> handle) const
+{
+    // Checked under the lock, Decrement publishes zero under it
+    std::lock_guard lock(counter->m_waitersMutex);
+    if (counter->IsDone())
+        return false;
+
+    counter->m_waiters.push_back(handle);
+    return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+    t_jobSystem = this;
+    t_workerIndex = workerIndex;
+    PROFILE_THREAD_NAME("Job worker");
+
+    uint32_t failedAttempts = 0;
+    while (!m_stop.load(std::memory_order_relaxed))
+    {
+        if (Job* job = FindJob(workerIndex))
+        {
+            Execute(job);
+            failedAttempts = 0;
+            continue;
+        }
+
+        if (++failedAttempts < spinCount)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Nothing for a while, sleep until a job is pushed
+        m_pendingJobs.wait(0, std::memory_order_acquire);
+        failedAttempts = 0;
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    const uint32_t workerIndex = GetCurrentWorkerIndex();
+
+    while (!counter.IsDone())
+    {
+        if (Job* job = FindJob(workerIndex))
+            Execute(job);
+        else
+            std::this_thread::yield();
+    }
+
+    // The last Decrement may still hold the lock, the counter can only be destroyed once it is released
+    std::lock_guard lock(counter.m_waitersMutex);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t, size_t)>& func)
+{
+    // A few chunks per thread, so stealing can balance uneven chunks
+    const size_t maxChunkCount = static_cast<size_t>(GetThreadCount()) * 4;
+    const size_t chunkCount = std::min(maxChunkCount, count / std::max<size_t>(minChunkSize, 1));
+
+    if (chunkCount <= 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        size_t end = std::min(begin + chunkSize, count);
+        Run([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+
+    Wait(counter);
+}
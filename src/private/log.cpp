@@ -0,0 +1,234 @@
+#include <log.h>
+
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using VulkanRenderer::LogLevel;
+using VulkanRenderer::Log::Detail::Record;
+
+namespace
+{
+// Power of two, a slot is a bit more than 256 bytes
+constexpr uint64_t queueCapacity = 1 << 12;
+
+// Bounded multi producer queue (Vyukov). Producers claim a slot with a CAS on the tail, fill it, then
+// publish it with its sequence. The writer thread is the only consumer.
+struct Slot
+{
+    std::atomic<uint64_t> sequence;
+    Record record;
+};
+
+struct Logger
+{
+    Logger()
+    {
+        for (uint64_t i = 0; i < queueCapacity; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // In case Stop was not called
+    ~Logger() { VulkanRenderer::Log::Stop(); }
+
+    std::array<Slot, queueCapacity> slots;
+    alignas(64) std::atomic<uint64_t> tail = 0;
+    alignas(64) uint64_t head = 0; // Only touched by the writer
+
+    std::atomic<bool> writerSleeping = false;
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> droppedRecords = 0;
+    std::atomic<LogLevel> level = LogLevel::Info;
+    std::thread writer;
+};
+
+Logger& GetLogger()
+{
+    static Logger logger;
+    return logger;
+}
+
+Slot& GetSlot(Logger& logger, uint64_t position)
+{
+    return logger.slots[position & (queueCapacity - 1)];
+}
+
+const char* GetLevelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Verbose:
+        return "Verbose";
+    case LogLevel::Info:
+        return "Info";
+    case LogLevel::Warning:
+        return "Warning";
+    case LogLevel::Error:
+        return "Error";
+    }
+
+    return "";
+}
+
+void Format(std::ostream& stream, Record& record)
+{
+    std::time_t time = std::chrono::system_clock::to_time_t(record.time);
+    auto milliseconds =
+        std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+
+    std::tm localTime{};
+#if defined(_WIN32)
+    localtime_s(&localTime, &time);
+#else
+    localtime_r(&time, &localTime);
+#endif
+
+    stream << "[" << std::put_time(&localTime, "%H:%M:%S") << "." << std::setfill('0') << std::setw(3)
+           << milliseconds << std::setfill(' ') << "] [" << GetLevelName(record.level) << "] ";
+    record.format(stream, record.arguments);
+    stream << "\n";
+}
+
+// Write all the published records, return false if there was none
+bool Drain(Logger& logger)
+{
+    bool wroteRecords = false;
+    bool wroteErrors = false;
+
+    while (true)
+    {
+        Slot& slot = GetSlot(logger, logger.head);
+        if (slot.sequence.load(std::memory_order_acquire) != logger.head + 1)
+            break;
+
+        // Warnings and errors are not buffered with the rest
+        std::ostream& stream = slot.record.level >= LogLevel::Warning ? std::cerr : std::cout;
+        Format(stream, slot.record);
+
+        wroteRecords = true;
+        wroteErrors |= slot.record.level >= LogLevel::Warning;
+
+        // Give the slot back to the producers, for the next lap
+        slot.sequence.store(logger.head + queueCapacity, std::memory_order_release);
+        ++logger.head;
+    }
+
+    uint64_t dropped = logger.droppedRecords.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        std::cerr << "[Warning] " << dropped << " log records dropped, the queue was full\n";
+        wroteErrors = true;
+    }
+
+    // Once per batch instead of once per line
+    if (wroteRecords)
+        std::cout.flush();
+
+    if (wroteErrors)
+        std::cerr.flush();
+
+    return wroteRecords;
+}
+
+void WriterLoop()
+{
+    Logger& logger = GetLogger();
+
+    while (!logger.stop.load(std::memory_order_acquire))
+    {
+        if (Drain(logger))
+            continue;
+
+        // Sleep until a producer wakes us up. Check again after announcing it, a record may have been
+        // published in between, its producer would have seen we were not sleeping yet. Same for Stop.
+        logger.writerSleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!logger.stop.load(std::memory_order_relaxed) && !Drain(logger))
+            logger.writerSleeping.wait(true);
+
+        logger.writerSleeping.store(false);
+    }
+
+    Drain(logger);
+}
+} // namespace
+
+void VulkanRenderer::Log::Start()
+{
+    Logger& logger = GetLogger();
+    if (logger.writer.joinable())
+        return;
+
+    logger.stop.store(false);
+    logger.writer = std::thread(WriterLoop);
+}
+
+void VulkanRenderer::Log::Stop()
+{
+    Logger& logger = GetLogger();
+    if (!logger.writer.joinable())
+        return;
+
+    logger.stop.store(true);
+    if (logger.writerSleeping.exchange(false))
+        logger.writerSleeping.notify_one();
+    logger.writer.join();
+}
+
+void VulkanRenderer::Log::SetLevel(LogLevel level)
+{
+    GetLogger().level.store(level, std::memory_order_relaxed);
+}
+
+bool VulkanRenderer::Log::IsEnabled(LogLevel level)
+{
+    return level >= GetLogger().level.load(std::memory_order_relaxed);
+}
+
+Record* VulkanRenderer::Log::Detail::BeginRecord(uint64_t& outPosition)
+{
+    Logger& logger = GetLogger();
+
+    uint64_t position = logger.tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot& slot = GetSlot(logger, position);
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+        if (sequence == position)
+        {
+            // Free slot, try to claim it
+            if (logger.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                outPosition = position;
+                return &slot.record;
+            }
+        }
+        else if (sequence < position)
+        {
+            // Still holds a record of the previous lap: full. Never wait for the writer.
+            logger.droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            // Claimed by another producer meanwhile
+            position = logger.tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void VulkanRenderer::Log::Detail::CommitRecord(uint64_t position)
+{
+    Logger& logger = GetLogger();
+    GetSlot(logger, position).sequence.store(position + 1, std::memory_order_release);
+
+    // Pairs with the writer announcing it sleeps: either it sees this record, or we see it sleeping.
+    // Only pay for a wake up in the second case.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (logger.writerSleeping.load(std::memory_order_relaxed) && logger.writerSleeping.exchange(false))
+        logger.writerSleeping.notify_one();
+}
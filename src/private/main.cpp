@@ -1,26 +1,36 @@
 #include <app.h>
 #include <config.h>
-
-#include <iostream>
+#include <log.h>
 
 int main(int argc, char* argv[])
 {
     VulkanRenderer::VulkanParameters::Initialize(argc, argv);
 
+    VulkanRenderer::Log::Start();
+
     if (VulkanRenderer::Parameters().verbose())
     {
-        std::cout << "Verbose mode" << std::endl;
+        VulkanRenderer::Log::SetLevel(VulkanRenderer::LogLevel::Verbose);
+        LOG_VERBOSE("Verbose mode");
     }
 
-    VulkanRenderer::Application app(800, 600, "VulkanApplication");
-
-    if (app.Init() != 0)
+    int res = 0;
     {
-        std::cout << "Error while initializing Vulkan" << std::endl;
-        return -1;
+        VulkanRenderer::Application app(800, 600, "VulkanApplication");
+
+        if (app.Init() != 0)
+        {
+            LOG_ERROR("Error while initializing Vulkan");
+            res = -1;
+        }
+        else
+        {
+            app.Run();
+        }
     }
 
-    app.Run();
+    // Write what is left once the application is destroyed, it logs while cleaning up
+    VulkanRenderer::Log::Stop();
 
-    return 0;
-}
\ No newline at end of file
+    return res;
+}
@@ -0,0 +1,182 @@
+#include <memoryBudget.h>
+
+#include <log.h>
+#include <profiler.h>
+#include <utils/memory.h>
+#include <utils/utils.h>
+
+#include <algorithm>
+#include <utility>
+
+using VulkanRenderer::MemoryBudget;
+using VulkanRenderer::MemoryBudgetConfig;
+
+MemoryBudget::MemoryBudget(MemoryBudgetConfig& config)
+    : m_physicalDevice(config.physicalDevice)
+    , m_memoryBudgetSupported(config.memoryBudgetSupported)
+    , m_headroom(config.headroom)
+    , m_fallbackBudget(config.fallbackBudget)
+    , m_framesInFlight(config.framesInFlight)
+{
+    RefreshHeaps();
+
+    for (uint32_t i = 0; i < m_heaps.size(); ++i)
+    {
+        const HeapBudget& heap = m_heaps[i];
+        LOG_VERBOSE("Memory heap ", i, (heap.deviceLocal ? " (device local)" : ""), ": ", heap.budget >> 20, " of ",
+                    heap.size >> 20, " MiB available", (m_memoryBudgetSupported ? "" : " (estimated)"));
+    }
+}
+
+void MemoryBudget::BeginFrame()
+{
+    PROFILE_FUNCTION();
+
+    ++m_frameNumber;
+    RefreshHeaps();
+
+    for (uint32_t i = 0; i < m_heaps.size(); ++i)
+    {
+        if (m_heaps[i].usage > GetTarget(m_heaps[i]))
+            Evict(i);
+
+        // Once per crossing, the heap may stay over for many frames
+        const uint32_t heapBit = 1u << i;
+        const bool overBudget = m_heaps[i].usage > GetTarget(m_heaps[i]);
+        if (overBudget && !(m_overBudgetHeaps & heapBit))
+            LOG_WARNING("Memory heap ", i, " over budget: ", m_heaps[i].usage >> 20, " of ", m_heaps[i].budget >> 20,
+                        " MiB used, nothing left to evict");
+
+        m_overBudgetHeaps = overBudget ? m_overBudgetHeaps | heapBit : m_overBudgetHeaps & ~heapBit;
+    }
+}
+
+MemoryBudget::EvictableId MemoryBudget::AddEvictable(const std::vector<VkDeviceMemory>& memories,
+                                                     std::function<void()> evict)
+{
+    Evictable evictable;
+    evictable.evict = std::move(evict);
+    evictable.lastUsedFrame = m_frameNumber;
+
+    for (VkDeviceMemory memory : memories)
+    {
+        uint32_t heapIndex = 0;
+        VkDeviceSize size = 0;
+        if (memory != VK_NULL_HANDLE && VulkanRenderer::Utils::GetAllocation(memory, heapIndex, size))
+            evictable.heapBytes[heapIndex] += size;
+    }
+
+    const EvictableId id = m_nextId++;
+    m_evictables.emplace(id, std::move(evictable));
+    return id;
+}
+
+void MemoryBudget::Touch(EvictableId id)
+{
+    auto evictable = m_evictables.find(id);
+    if (evictable != m_evictables.end())
+        evictable->second.lastUsedFrame = m_frameNumber;
+}
+
+void MemoryBudget::RemoveEvictable(EvictableId id) { m_evictables.erase(id); }
+
+void MemoryBudget::RefreshHeaps()
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    if (m_memoryBudgetSupported)
+        memoryProperties.pNext = &budgetProperties;
+
+    vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &memoryProperties);
+
+    const VkPhysicalDeviceMemoryProperties& properties = memoryProperties.memoryProperties;
+    m_heaps.resize(properties.memoryHeapCount);
+
+    for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+    {
+        HeapBudget& heap = m_heaps[i];
+        heap.size = properties.memoryHeaps[i].size;
+        heap.deviceLocal = (properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
+        if (m_memoryBudgetSupported)
+        {
+            heap.budget = budgetProperties.heapBudget[i];
+            heap.usage = budgetProperties.heapUsage[i];
+        }
+        else
+        {
+            heap.budget = static_cast<VkDeviceSize>(static_cast<double>(heap.size) * m_fallbackBudget);
+            heap.usage = VulkanRenderer::Utils::GetAllocatedBytes(i);
+        }
+    }
+}
+
+bool MemoryBudget::IsMemoryBudgetSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // Queried through vkGetPhysicalDeviceMemoryProperties2
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+        return false;
+
+    uint32_t extensionsCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionsCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionsCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionsCount, availableExtensions.data());
+
+    const char* extensionName = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+    return VulkanRenderer::Utils::ValidateStrings(
+               &extensionName, 1, availableExtensions.data(), extensionsCount,
+               [](const VkExtensionProperties& properties) -> const char* { return properties.extensionName; }) == 1;
+}
+
+VkDeviceSize MemoryBudget::GetTarget(const HeapBudget& heap) const
+{
+    return static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * (1.0 - m_headroom));
+}
+
+void MemoryBudget::Evict(uint32_t heapIndex)
+{
+    PROFILE_FUNCTION();
+
+    HeapBudget& heap = m_heaps[heapIndex];
+    const VkDeviceSize target = GetTarget(heap);
+
+    // Those the frames in flight may still use are kept
+    std::vector<std::pair<uint64_t, EvictableId>> candidates;
+    for (const auto& [id, evictable] : m_evictables)
+    {
+        if (evictable.heapBytes[heapIndex] > 0 && evictable.lastUsedFrame + m_framesInFlight <= m_frameNumber)
+            candidates.emplace_back(evictable.lastUsedFrame, id);
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    VkDeviceSize evicted = 0;
+    for (const auto& [lastUsedFrame, id] : candidates)
+    {
+        if (heap.usage <= target)
+            break;
+
+        auto evictable = m_evictables.find(id);
+        const std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapBytes = evictable->second.heapBytes;
+        std::function<void()> evict = std::move(evictable->second.evict);
+        m_evictables.erase(evictable);
+        evict();
+
+        // The driver only updates its usage on the next query
+        for (uint32_t i = 0; i < m_heaps.size(); ++i)
+            m_heaps[i].usage -= std::min(m_heaps[i].usage, heapBytes[i]);
+
+        evicted += heapBytes[heapIndex];
+    }
+
+    m_evictedBytes += evicted;
+    if (evicted > 0)
+        LOG_VERBOSE("Evicted ", evicted >> 20, " MiB from memory heap ", heapIndex);
+}
@@ -0,0 +1,171 @@
+#include <metrics.h>
+
+#include <log.h>
+#include <memoryBudget.h>
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+using VulkanRenderer::Counter;
+using VulkanRenderer::Gauge;
+using VulkanRenderer::HeapBudget;
+using VulkanRenderer::Metrics;
+using VulkanRenderer::MetricsConfig;
+
+namespace
+{
+struct CounterInfo
+{
+    const char* name;
+    const char* help;
+};
+
+// Same order as the Counter enum
+constexpr std::array<CounterInfo, static_cast<size_t>(Counter::Count)> counterInfos = {{
+    {"draws", "Draw calls recorded"},
+    {"triangles", "Triangles drawn"},
+    {"pipeline_binds", "Pipelines bound"},
+    {"descriptor_binds", "Descriptor sets bound"},
+    {"uploaded_bytes", "Bytes written to GPU visible memory"},
+    {"descriptor_allocations", "Descriptor sets allocated"},
+    {"swapchain_recreations", "Swap chain recreations"},
+    {"fence_wait_microseconds", "Time spent waiting on the frame fences"},
+    {"evicted_bytes", "Bytes freed to keep the memory heaps under their budget"},
+}};
+
+// Same order as the Gauge enum
+constexpr std::array<CounterInfo, static_cast<size_t>(VulkanRenderer::Gauge::Count)> gaugeInfos = {{
+    {"gpu_frame_microseconds", "GPU time of the last measured frame, with dynamic resolution."},
+    {"render_scale_percent", "Resolution of the viewports, in percent of their size, with dynamic resolution."},
+}};
+
+constexpr const char* metricPrefix = "vulkan_renderer_";
+} // namespace
+
+Metrics::Metrics(MetricsConfig& config)
+    : m_memoryBudget(config.memoryBudget)
+    , m_outputFile(config.outputFile)
+    , m_writeInterval(config.writeInterval)
+    , m_lastWrite(std::chrono::steady_clock::now())
+{
+}
+
+void Metrics::EndFrame()
+{
+    for (uint32_t i = 0; i < counterCount; ++i)
+    {
+        m_lastFrame[i] = m_current[i].exchange(0, std::memory_order_relaxed);
+        m_totals[i] += m_lastFrame[i];
+    }
+
+    ++m_frameCount;
+
+    if (m_outputFile.empty())
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_lastWrite < m_writeInterval)
+        return;
+
+    m_lastWrite = now;
+    WriteFile(m_outputFile.c_str());
+}
+
+const char* Metrics::GetName(Counter counter)
+{
+    if (counter >= Counter::Count)
+        return "unknown";
+
+    return counterInfos[static_cast<uint32_t>(counter)].name;
+}
+
+const char* Metrics::GetName(Gauge gauge)
+{
+    if (gauge >= Gauge::Count)
+        return "unknown";
+
+    return gaugeInfos[static_cast<uint32_t>(gauge)].name;
+}
+
+void Metrics::Write(std::ostream& stream) const
+{
+    // Prometheus text exposition format, so a node exporter textfile collector can scrape it
+    for (uint32_t i = 0; i < counterCount; ++i)
+    {
+        const CounterInfo& info = counterInfos[i];
+
+        stream << "# HELP " << metricPrefix << info.name << "_total " << info.help << " since the start.\n";
+        stream << "# TYPE " << metricPrefix << info.name << "_total counter\n";
+        stream << metricPrefix << info.name << "_total " << m_totals[i] << "\n";
+
+        stream << "# HELP " << metricPrefix << "frame_" << info.name << " " << info.help << " in the last frame.\n";
+        stream << "# TYPE " << metricPrefix << "frame_" << info.name << " gauge\n";
+        stream << metricPrefix << "frame_" << info.name << " " << m_lastFrame[i] << "\n";
+    }
+
+    for (uint32_t i = 0; i < gaugeCount; ++i)
+    {
+        const CounterInfo& info = gaugeInfos[i];
+
+        stream << "# HELP " << metricPrefix << info.name << " " << info.help << "\n";
+        stream << "# TYPE " << metricPrefix << info.name << " gauge\n";
+        stream << metricPrefix << info.name << " " << m_gauges[i].load(std::memory_order_relaxed) << "\n";
+    }
+
+    stream << "# HELP " << metricPrefix << "frames_total Frames rendered since the start.\n";
+    stream << "# TYPE " << metricPrefix << "frames_total counter\n";
+    stream << metricPrefix << "frames_total " << m_frameCount << "\n";
+
+    // Read once per frame by the memory budget, not queried again here
+    const std::vector<HeapBudget>& heaps = m_memoryBudget->GetHeaps();
+    auto writeHeaps = [&](const char* name, const char* help, VkDeviceSize HeapBudget::*field)
+    {
+        stream << "# HELP " << metricPrefix << name << " " << help << "\n";
+        stream << "# TYPE " << metricPrefix << name << " gauge\n";
+
+        for (size_t i = 0; i < heaps.size(); ++i)
+        {
+            stream << metricPrefix << name << "{heap=\"" << i << "\",device_local=\""
+                   << (heaps[i].deviceLocal ? "true" : "false") << "\"} " << heaps[i].*field << "\n";
+        }
+    };
+
+    writeHeaps("memory_heap_size_bytes", "Size of the memory heap.", &HeapBudget::size);
+
+    writeHeaps("memory_heap_usage_bytes", "Memory used by the process in the heap.", &HeapBudget::usage);
+
+    if (m_memoryBudget->IsDriverBudget())
+        writeHeaps("memory_heap_budget_bytes", "Memory the process can use from the heap.", &HeapBudget::budget);
+}
+
+bool Metrics::WriteFile(const char* filePath) const
+{
+    // Written next to the file then renamed, so the scraper never reads half a file
+    std::filesystem::path path(filePath);
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream fileStream(tempPath, std::ios::trunc);
+        if (!fileStream.is_open())
+        {
+            LOG_ERROR("Failed to open metrics file ", tempPath, " for writing");
+            return false;
+        }
+
+        Write(fileStream);
+        if (!fileStream.good())
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        LOG_ERROR("Failed to write metrics file ", filePath, ": ", error.message());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,521 @@
+#include <occlusionCuller.h>
+
+#include <computePipeline.h>
+#include <descriptorAllocator.h>
+#include <log.h>
+#include <profiler.h>
+#include <uniformRing.h>
+#include <utils/memory.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+using VulkanRenderer::OcclusionCuller;
+using VulkanRenderer::OcclusionCullerConfig;
+
+namespace
+{
+// Must match the local sizes of the shaders
+constexpr uint32_t cullGroupSize = 64;
+constexpr uint32_t pyramidGroupSize = 8;
+
+constexpr VkFormat pyramidFormat = VK_FORMAT_R32_SFLOAT;
+
+VkImageMemoryBarrier PyramidBarrier(VkImage image, VkImageLayout oldLayout, VkAccessFlags srcAccess,
+                                    VkAccessFlags dstAccess, uint32_t baseLevel, uint32_t levelCount)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1};
+    return barrier;
+}
+
+VkExtent2D HalfExtent(VkExtent2D extent)
+{
+    return {std::max(1u, (extent.width + 1) / 2), std::max(1u, (extent.height + 1) / 2)};
+}
+} // namespace
+
+OcclusionCuller::OcclusionCuller(OcclusionCullerConfig& config)
+    : m_deviceCache(config.device)
+    , m_physicalDevice(config.physicalDevice)
+    , m_depthSamples(config.depthSamples)
+{
+    m_frames.resize(config.framesInFlight);
+
+    // Only read with texelFetch, the filtering doesn't matter
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(m_deviceCache, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the occlusion culling sampler");
+        m_sampler = VK_NULL_HANDLE;
+        return;
+    }
+
+    // Instances, draws, culled draws, then the pyramid
+    std::vector<VkDescriptorSetLayoutBinding> cullBindings(4);
+    for (uint32_t i = 0; i < cullBindings.size(); ++i)
+    {
+        cullBindings[i].binding = i;
+        cullBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        cullBindings[i].descriptorCount = 1;
+        cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    cullBindings[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    m_cullSetLayout = config.layoutCache->GetLayout(cullBindings);
+    if (m_cullSetLayout == VK_NULL_HANDLE)
+        return;
+
+    // Source level, then the level written
+    std::vector<VkDescriptorSetLayoutBinding> pyramidBindings(2);
+    pyramidBindings[0].binding = 0;
+    pyramidBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pyramidBindings[0].descriptorCount = 1;
+    pyramidBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    pyramidBindings[1].binding = 1;
+    pyramidBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pyramidBindings[1].descriptorCount = 1;
+    pyramidBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    m_pyramidSetLayout = config.layoutCache->GetLayout(pyramidBindings);
+    if (m_pyramidSetLayout == VK_NULL_HANDLE)
+        return;
+
+    VulkanRenderer::ComputePipelineConfig pipelineConfig;
+    pipelineConfig.device = m_deviceCache;
+    pipelineConfig.shaderFile = config.cullShaderFile;
+    pipelineConfig.pipelineName = "main";
+    pipelineConfig.descriptorSetLayouts = {m_cullSetLayout, config.uniformRingLayout};
+    pipelineConfig.defaultFeatures = 0;
+    pipelineConfig.pipelineCache = config.pipelineCache;
+
+    m_cullPipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+
+    VkPushConstantRange reductionRange{};
+    reductionRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    reductionRange.offset = 0;
+    reductionRange.size = sizeof(DepthReductionData);
+
+    pipelineConfig.shaderFile = config.pyramidShaderFile;
+    pipelineConfig.descriptorSetLayouts = {m_pyramidSetLayout};
+    pipelineConfig.pushConstantRanges = {reductionRange};
+
+    m_pyramidPipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+
+    if (m_depthSamples != VK_SAMPLE_COUNT_1_BIT)
+    {
+        pipelineConfig.shaderFile = config.pyramidMultisampleShaderFile;
+        m_pyramidMultisamplePipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+    }
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for (auto& [viewport, target] : m_targets)
+        DestroyTarget(target);
+
+    for (Frame& frame : m_frames)
+    {
+        DestroyBuffer(frame.instances);
+        DestroyBuffer(frame.draws);
+    }
+
+    m_cullPipeline.reset();
+    m_pyramidPipeline.reset();
+    m_pyramidMultisamplePipeline.reset();
+
+    if (m_sampler != VK_NULL_HANDLE)
+        vkDestroySampler(m_deviceCache, m_sampler, nullptr);
+}
+
+bool OcclusionCuller::IsValid() const
+{
+    if (m_depthSamples != VK_SAMPLE_COUNT_1_BIT &&
+        (!m_pyramidMultisamplePipeline || !m_pyramidMultisamplePipeline->IsValid()))
+        return false;
+
+    return m_cullPipeline && m_cullPipeline->IsValid() && m_pyramidPipeline && m_pyramidPipeline->IsValid() &&
+           m_sampler != VK_NULL_HANDLE;
+}
+
+VkDrawIndirectCommand* OcclusionCuller::BeginFrame(uint32_t frameIndex, const std::vector<InstanceData>& instances)
+{
+    m_currentFrame = frameIndex;
+    m_instanceCount = static_cast<uint32_t>(instances.size());
+
+    // Never empty, so the descriptors always have a buffer to point to
+    const VkDeviceSize count = std::max<VkDeviceSize>(m_instanceCount, 1);
+
+    Frame& frame = m_frames[frameIndex];
+    if (!ReserveBuffer(frame.instances, count * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true) ||
+        !ReserveBuffer(frame.draws, count * sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true))
+        return nullptr;
+
+    if (!instances.empty())
+        std::memcpy(frame.instances.mapped, instances.data(), instances.size() * sizeof(InstanceData));
+
+    return static_cast<VkDrawIndirectCommand*>(frame.draws.mapped);
+}
+
+bool OcclusionCuller::PrepareTarget(uint32_t viewport, VkExtent2D depthExtent)
+{
+    Target& target = m_targets[viewport];
+    if (target.pyramid != VK_NULL_HANDLE && target.depthExtent.width == depthExtent.width &&
+        target.depthExtent.height == depthExtent.height)
+        return true;
+
+    DestroyTarget(target);
+    return CreateTarget(target, depthExtent);
+}
+
+bool OcclusionCuller::HasTarget(uint32_t viewport) const
+{
+    auto it = m_targets.find(viewport);
+    return it != m_targets.end() && it->second.pyramidView != VK_NULL_HANDLE;
+}
+
+void OcclusionCuller::ReleaseTarget(uint32_t viewport)
+{
+    auto it = m_targets.find(viewport);
+    if (it == m_targets.end())
+        return;
+
+    DestroyTarget(it->second);
+    m_targets.erase(it);
+}
+
+VkBuffer OcclusionCuller::GetDrawBuffer(uint32_t viewport) const
+{
+    return m_targets.at(viewport).culledDraws[m_currentFrame].buffer;
+}
+
+bool OcclusionCuller::RecordCull(VkCommandBuffer commandBuffer, uint32_t viewport, const glm::mat4& viewProj,
+                                 UniformRing& ring, DescriptorAllocator& allocator)
+{
+    PROFILE_FUNCTION();
+
+    Target& target = m_targets.at(viewport);
+    const Frame& frame = m_frames[m_currentFrame];
+
+    // Replaced while not in use: the fence of this frame was waited on
+    Buffer& culledDraws = target.culledDraws[m_currentFrame];
+    const VkDeviceSize drawsSize = std::max<VkDeviceSize>(m_instanceCount, 1) * sizeof(VkDrawIndirectCommand);
+    if (!ReserveBuffer(culledDraws, drawsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                       false))
+        return false;
+
+    if (m_instanceCount == 0)
+        return true;
+
+    CullData cullData{};
+    cullData.viewProj = viewProj;
+    cullData.pyramidViewProj = target.pyramidViewProj;
+    cullData.depthSize = glm::vec2(target.reducedExtent.width, target.reducedExtent.height);
+    cullData.instanceCount = m_instanceCount;
+    // No occlusion test until a pyramid has been built
+    cullData.pyramidLevels = target.pyramidBuilt ? static_cast<uint32_t>(target.levelViews.size()) : 0;
+
+    VulkanRenderer::RingAllocation cullAllocation = ring.Push(cullData);
+    if (!cullAllocation.IsValid())
+        return false;
+
+    VkDescriptorSet descriptorSet = allocator.Allocate(m_cullSetLayout);
+    if (descriptorSet == VK_NULL_HANDLE)
+        return false;
+
+    std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+    bufferInfos[0] = {frame.instances.buffer, 0, m_instanceCount * sizeof(InstanceData)};
+    bufferInfos[1] = {frame.draws.buffer, 0, drawsSize};
+    bufferInfos[2] = {culledDraws.buffer, 0, drawsSize};
+
+    VkDescriptorImageInfo pyramidInfo{};
+    pyramidInfo.sampler = m_sampler;
+    pyramidInfo.imageView = target.pyramidView;
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::array<VkWriteDescriptorSet, 4> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        if (i < bufferInfos.size())
+            writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    writes[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[3].pImageInfo = &pyramidInfo;
+
+    vkUpdateDescriptorSets(m_deviceCache, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    // Bound even before the first reduction, which needs a defined layout
+    if (!target.pyramidInitialized)
+    {
+        VkImageMemoryBarrier toGeneral = PyramidBarrier(target.pyramid, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                                                        VK_ACCESS_SHADER_READ_BIT, 0, VK_REMAINING_MIP_LEVELS);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &toGeneral);
+        target.pyramidInitialized = true;
+    }
+
+    VkPipelineLayout pipelineLayout = m_cullPipeline->GetPipelineLayout();
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0,
+                            nullptr);
+    ring.Bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 1, cullAllocation.offset);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline->GetPipeline());
+    vkCmdDispatch(commandBuffer, (m_instanceCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+    // Draws ready for the render pass
+    VkBufferMemoryBarrier toIndirect{};
+    toIndirect.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toIndirect.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    toIndirect.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    toIndirect.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toIndirect.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toIndirect.buffer = culledDraws.buffer;
+    toIndirect.offset = 0;
+    toIndirect.size = drawsSize;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0,
+                         nullptr, 1, &toIndirect, 0, nullptr);
+
+    return true;
+}
+
+bool OcclusionCuller::RecordPyramid(VkCommandBuffer commandBuffer, uint32_t viewport, VkImageView depthView,
+                                    VkExtent2D depthExtent, const glm::mat4& viewProj, DescriptorAllocator& allocator)
+{
+    PROFILE_FUNCTION();
+
+    Target& target = m_targets.at(viewport);
+    const uint32_t levelCount = static_cast<uint32_t>(target.levelViews.size());
+
+    // Entirely rewritten, once the culling of this frame is done reading it
+    VkImageMemoryBarrier toWrite = PyramidBarrier(target.pyramid, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                                                  VK_ACCESS_SHADER_WRITE_BIT, 0, levelCount);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toWrite);
+
+    // Only the part rendered, the levels below one texel stay at one texel
+    VkExtent2D sourceExtent = depthExtent;
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        VkDescriptorSet descriptorSet = allocator.Allocate(m_pyramidSetLayout);
+        if (descriptorSet == VK_NULL_HANDLE)
+            return false;
+
+        // The first level reads the depth buffer, the others the level below
+        VkDescriptorImageInfo sourceInfo{};
+        sourceInfo.sampler = m_sampler;
+        sourceInfo.imageView = level == 0 ? depthView : target.levelViews[level - 1];
+        sourceInfo.imageLayout =
+            level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo levelInfo{};
+        levelInfo.imageView = target.levelViews[level];
+        levelInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        for (uint32_t i = 0; i < writes.size(); ++i)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+        }
+
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &sourceInfo;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &levelInfo;
+
+        vkUpdateDescriptorSets(m_deviceCache, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        if (level > 0)
+        {
+            VkImageMemoryBarrier toRead = PyramidBarrier(target.pyramid, VK_IMAGE_LAYOUT_GENERAL,
+                                                         VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                                         level - 1, 1);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toRead);
+        }
+
+        ComputePipeline& pipeline =
+            level == 0 && m_pyramidMultisamplePipeline ? *m_pyramidMultisamplePipeline : *m_pyramidPipeline;
+        const VkExtent2D levelExtent = HalfExtent(sourceExtent);
+        ReduceLevel(commandBuffer, pipeline, descriptorSet, sourceExtent, levelExtent);
+
+        sourceExtent = levelExtent;
+    }
+
+    // Ready for the culling of the next frame
+    VkImageMemoryBarrier toCull = PyramidBarrier(target.pyramid, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT,
+                                                 VK_ACCESS_SHADER_READ_BIT, 0, levelCount);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toCull);
+
+    target.pyramidViewProj = viewProj;
+    target.reducedExtent = depthExtent;
+    target.pyramidBuilt = true;
+    target.pyramidInitialized = true;
+    return true;
+}
+
+bool OcclusionCuller::CreateTarget(Target& target, VkExtent2D depthExtent)
+{
+    target.depthExtent = depthExtent;
+    target.pyramidExtent = HalfExtent(depthExtent);
+
+    // Down to a single texel
+    const uint32_t levelCount =
+        static_cast<uint32_t>(
+            std::floor(std::log2(std::max(target.pyramidExtent.width, target.pyramidExtent.height)))) +
+        1;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = pyramidFormat;
+    imageInfo.extent = {target.pyramidExtent.width, target.pyramidExtent.height, 1};
+    imageInfo.mipLevels = levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (!VulkanRenderer::Utils::CreateImage(m_deviceCache, m_physicalDevice, imageInfo,
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.pyramid, target.pyramidMemory))
+        return false;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = target.pyramid;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = pyramidFormat;
+    viewInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                           VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1};
+
+    if (vkCreateImageView(m_deviceCache, &viewInfo, nullptr, &target.pyramidView) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the depth pyramid view");
+        target.pyramidView = VK_NULL_HANDLE;
+        return false;
+    }
+
+    target.levelViews.resize(levelCount, VK_NULL_HANDLE);
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+        if (vkCreateImageView(m_deviceCache, &viewInfo, nullptr, &target.levelViews[level]) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create the view of depth pyramid level ", level);
+            target.levelViews[level] = VK_NULL_HANDLE;
+            return false;
+        }
+    }
+
+    // Created on first use, sized for the instances
+    target.culledDraws.resize(m_frames.size());
+    return true;
+}
+
+void OcclusionCuller::DestroyTarget(Target& target)
+{
+    for (Buffer& buffer : target.culledDraws)
+        DestroyBuffer(buffer);
+
+    for (VkImageView view : target.levelViews)
+    {
+        if (view != VK_NULL_HANDLE)
+            vkDestroyImageView(m_deviceCache, view, nullptr);
+    }
+
+    if (target.pyramidView != VK_NULL_HANDLE)
+        vkDestroyImageView(m_deviceCache, target.pyramidView, nullptr);
+
+    VulkanRenderer::Utils::DestroyImage(m_deviceCache, target.pyramid, target.pyramidMemory);
+    target = Target{};
+}
+
+bool OcclusionCuller::ReserveBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+{
+    if (buffer.buffer != VK_NULL_HANDLE && buffer.size >= size)
+        return true;
+
+    DestroyBuffer(buffer);
+
+    // Some room to grow, so a scene gaining a few instances doesn't replace it every frame
+    const VkDeviceSize capacity = size + size / 2;
+    const VkMemoryPropertyFlags properties =
+        hostVisible ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                    : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    if (!VulkanRenderer::Utils::CreateBuffer(m_deviceCache, m_physicalDevice, capacity, usage, properties,
+                                             buffer.buffer, buffer.memory))
+    {
+        LOG_ERROR("Failed to create an occlusion culling buffer");
+        return false;
+    }
+
+    buffer.size = capacity;
+
+    // Kept mapped, rewritten every frame
+    if (hostVisible && vkMapMemory(m_deviceCache, buffer.memory, 0, capacity, 0, &buffer.mapped) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to map an occlusion culling buffer");
+        DestroyBuffer(buffer);
+        return false;
+    }
+
+    return true;
+}
+
+void OcclusionCuller::DestroyBuffer(Buffer& buffer)
+{
+    if (buffer.mapped)
+        vkUnmapMemory(m_deviceCache, buffer.memory);
+
+    VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, buffer.buffer, buffer.memory);
+    buffer = Buffer{};
+}
+
+void OcclusionCuller::ReduceLevel(VkCommandBuffer commandBuffer, ComputePipeline& pipeline,
+                                  VkDescriptorSet descriptorSet, VkExtent2D sourceExtent, VkExtent2D levelExtent)
+{
+    DepthReductionData reduction;
+    reduction.sourceSize = glm::ivec2(sourceExtent.width, sourceExtent.height);
+    reduction.levelSize = glm::ivec2(levelExtent.width, levelExtent.height);
+
+    VkPipelineLayout pipelineLayout = pipeline.GetPipelineLayout();
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0,
+                            nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(reduction),
+                       &reduction);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetPipeline());
+    vkCmdDispatch(commandBuffer, (levelExtent.width + pyramidGroupSize - 1) / pyramidGroupSize,
+                  (levelExtent.height + pyramidGroupSize - 1) / pyramidGroupSize, 1);
+}
@@ -0,0 +1,409 @@
+#include <particleSystem.h>
+
+#include <computePipeline.h>
+#include <computeScheduler.h>
+#include <descriptorAllocator.h>
+#include <log.h>
+#include <profiler.h>
+#include <shader.h>
+#include <utils/memory.h>
+#include <utils/pipeline.h>
+
+#include <algorithm>
+#include <array>
+
+using VulkanRenderer::ParticleSystem;
+using VulkanRenderer::ParticleSystemConfig;
+
+namespace
+{
+// Must match PARTICLE_GROUP_SIZE in shaders/particles.glsl
+constexpr uint32_t particleGroupSize = 64;
+
+// Layout of the ParticleState buffer: counters, then the simulation dispatch and the draw
+constexpr VkDeviceSize simulateDispatchOffset = 16;
+constexpr VkDeviceSize drawOffset = 32;
+constexpr VkDeviceSize stateSize = 48;
+
+// Size of a particle in the Particles buffer
+constexpr VkDeviceSize particleSize = 3 * sizeof(glm::vec4);
+
+// Longer frames are simulated as this one, a hitch doesn't emit a burst of particles
+constexpr float maxDeltaTime = 0.1f;
+
+// Most vkCmdUpdateBuffer takes at once
+constexpr VkDeviceSize maxUpdateSize = 65536;
+
+constexpr uint32_t descriptorCount = 5;
+} // namespace
+
+ParticleSystem::ParticleSystem(ParticleSystemConfig& config)
+    : m_deviceCache(config.device)
+    , m_physicalDevice(config.physicalDevice)
+    , m_registry(config.registry)
+    , m_capacity(config.capacity)
+    , m_maxEmitters(config.maxEmitters)
+    , m_gravity(config.gravity, config.drag)
+{
+    if (m_capacity == 0 || m_maxEmitters == 0)
+    {
+        LOG_ERROR("Particle system created without room for any particle or emitter");
+        return;
+    }
+
+    const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (!CreateBuffer(m_emitterBuffer, m_maxEmitters * sizeof(ParticleEmitterData),
+                      storage | VK_BUFFER_USAGE_TRANSFER_DST_BIT) ||
+        !CreateBuffer(m_particleBuffer, m_capacity * particleSize, storage) ||
+        !CreateBuffer(m_deadListBuffer, m_capacity * sizeof(uint32_t), storage) ||
+        !CreateBuffer(m_aliveListBuffer, 2 * m_capacity * sizeof(uint32_t), storage) ||
+        !CreateBuffer(m_stateBuffer, stateSize, storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT))
+        return;
+
+    // Emitters, particles, dead list, alive lists, then the state. The draw reads the particles too.
+    std::vector<VkDescriptorSetLayoutBinding> bindings(descriptorCount);
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    }
+
+    m_setLayout = config.layoutCache->GetLayout(bindings);
+    if (m_setLayout == VK_NULL_HANDLE)
+        return;
+
+    VkPushConstantRange frameRange{};
+    frameRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    frameRange.offset = 0;
+    frameRange.size = sizeof(ParticleFrameData);
+
+    VulkanRenderer::ComputePipelineConfig pipelineConfig;
+    pipelineConfig.device = m_deviceCache;
+    pipelineConfig.pipelineName = "main";
+    pipelineConfig.descriptorSetLayouts = {m_setLayout};
+    pipelineConfig.pushConstantRanges = {frameRange};
+    pipelineConfig.defaultFeatures = 0;
+    pipelineConfig.pipelineCache = config.pipelineCache;
+
+    pipelineConfig.shaderFile = config.emitShaderFile;
+    m_emitPipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+
+    pipelineConfig.shaderFile = config.simulateShaderFile;
+    m_simulatePipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+
+    pipelineConfig.shaderFile = config.controlShaderFile;
+    m_controlPipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+
+    CreateDrawPipeline(config);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    if (m_drawPipeline)
+        m_registry->Release(m_drawPipeline);
+
+    vkDestroyPipelineLayout(m_deviceCache, m_drawLayout, nullptr);
+    m_vertShader.reset();
+    m_fragShader.reset();
+
+    m_emitPipeline.reset();
+    m_simulatePipeline.reset();
+    m_controlPipeline.reset();
+
+    DestroyBuffer(m_emitterBuffer);
+    DestroyBuffer(m_particleBuffer);
+    DestroyBuffer(m_deadListBuffer);
+    DestroyBuffer(m_aliveListBuffer);
+    DestroyBuffer(m_stateBuffer);
+}
+
+bool ParticleSystem::IsValid() const
+{
+    return m_emitPipeline && m_emitPipeline->IsValid() && m_simulatePipeline && m_simulatePipeline->IsValid() &&
+           m_controlPipeline && m_controlPipeline->IsValid() && m_drawPipeline &&
+           VulkanRenderer::PipelineRegistry::Get(m_drawPipeline) != VK_NULL_HANDLE;
+}
+
+bool ParticleSystem::AddEmitter(const ParticleEmitterData& emitter)
+{
+    if (m_emitters.size() >= m_maxEmitters)
+    {
+        LOG_WARNING("No room left for another particle emitter, ", m_maxEmitters, " at most");
+        return false;
+    }
+
+    m_emitters.push_back(emitter);
+    return true;
+}
+
+bool ParticleSystem::RecordUpdate(ComputeScheduler& scheduler, float deltaTime, DescriptorAllocator& allocator)
+{
+    PROFILE_FUNCTION();
+
+    VkCommandBuffer commandBuffer = scheduler.GetCommandBuffer();
+    if (commandBuffer == VK_NULL_HANDLE)
+        return false;
+
+    m_descriptorSet = allocator.Allocate(m_setLayout);
+    if (m_descriptorSet == VK_NULL_HANDLE)
+        return false;
+
+    std::array<VkDescriptorBufferInfo, descriptorCount> bufferInfos{};
+    bufferInfos[0] = {m_emitterBuffer.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[1] = {m_particleBuffer.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[2] = {m_deadListBuffer.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[3] = {m_aliveListBuffer.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[4] = {m_stateBuffer.buffer, 0, VK_WHOLE_SIZE};
+
+    std::array<VkWriteDescriptorSet, descriptorCount> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+
+    vkUpdateDescriptorSets(m_deviceCache, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    // Stages of the update on the compute queue, dispatch arguments included
+    const VkPipelineStageFlags updateStages =
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+
+    // Read by the draws, taken back from graphics when it runs on another queue family
+    const std::array<VkBuffer, 3> drawBuffers = {m_particleBuffer.buffer, m_aliveListBuffer.buffer,
+                                                 m_stateBuffer.buffer};
+    for (VkBuffer buffer : drawBuffers)
+        scheduler.AcquireFromGraphics(buffer, updateStages,
+                                      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                                          VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+    // The last frame simulated and drew the same particles. Draws of another queue are waited on by the submission,
+    // the compute queue doesn't even have their stages.
+    VkPipelineStageFlags lastStages = updateStages;
+    if (!scheduler.IsAsync())
+        lastStages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+
+    ComputeBarrier(commandBuffer, lastStages, VK_ACCESS_SHADER_WRITE_BIT,
+                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                   VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    if (m_uploadedEmitters < m_emitters.size())
+    {
+        UploadEmitters(commandBuffer);
+        ComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+
+    deltaTime = std::clamp(deltaTime, 0.f, maxDeltaTime);
+    m_time += deltaTime;
+
+    ParticleFrameData frame{};
+    frame.gravity = m_gravity;
+    frame.deltaTime = deltaTime;
+    frame.time = m_time;
+    frame.emitterCount = m_uploadedEmitters;
+    frame.capacity = m_capacity;
+    frame.aliveList = m_aliveList;
+
+    const VkAccessFlags readWrite = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    // Every particle free, once
+    if (!m_initialized)
+    {
+        frame.mode = static_cast<uint32_t>(ParticleControlMode::Init);
+        Dispatch(commandBuffer, *m_controlPipeline, frame, (m_capacity + particleGroupSize - 1) / particleGroupSize);
+        ComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readWrite);
+    }
+
+    if (frame.emitterCount > 0)
+    {
+        Dispatch(commandBuffer, *m_emitPipeline, frame, frame.emitterCount);
+        ComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readWrite);
+    }
+
+    // The simulation covers the particles alive now, emitted ones included
+    frame.mode = static_cast<uint32_t>(ParticleControlMode::PrepareSimulation);
+    Dispatch(commandBuffer, *m_controlPipeline, frame, 1);
+    ComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                   readWrite | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+    VkPipelineLayout pipelineLayout = m_simulatePipeline->GetPipelineLayout();
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &m_descriptorSet, 0,
+                            nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(frame), &frame);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_simulatePipeline->GetPipeline());
+    vkCmdDispatchIndirect(commandBuffer, m_stateBuffer.buffer, simulateDispatchOffset);
+
+    ComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readWrite);
+
+    frame.mode = static_cast<uint32_t>(ParticleControlMode::PrepareDraw);
+    Dispatch(commandBuffer, *m_controlPipeline, frame, 1);
+
+    // Draw ready for the render passes. On another queue family, the acquire of graphics makes the writes visible.
+    const VkPipelineStageFlags drawStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+    const VkAccessFlags drawAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    if (!scheduler.IsAsync())
+        ComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, drawStages,
+                       drawAccess);
+
+    for (VkBuffer buffer : drawBuffers)
+        scheduler.ReleaseToGraphics(buffer, VK_ACCESS_SHADER_WRITE_BIT, drawStages, drawAccess);
+
+    // The survivors are emitted to and simulated next frame
+    m_aliveList = 1 - m_aliveList;
+    m_initialized = true;
+    return true;
+}
+
+void ParticleSystem::RecordDraw(VkCommandBuffer commandBuffer, const CameraData& camera) const
+{
+    if (!m_initialized || m_descriptorSet == VK_NULL_HANDLE)
+        return;
+
+    VkPipeline pipeline = VulkanRenderer::PipelineRegistry::Get(m_drawPipeline);
+    if (pipeline == VK_NULL_HANDLE)
+        return;
+
+    ParticleDrawData draw{};
+    draw.viewProj = camera.viewProj;
+    draw.aliveList = m_aliveList;
+    draw.capacity = m_capacity;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_drawLayout, 0, 1, &m_descriptorSet, 0,
+                            nullptr);
+    vkCmdPushConstants(commandBuffer, m_drawLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(draw), &draw);
+    vkCmdDrawIndirect(commandBuffer, m_stateBuffer.buffer, drawOffset, 1, 0);
+}
+
+bool ParticleSystem::CreateBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    if (!VulkanRenderer::Utils::CreateBuffer(m_deviceCache, m_physicalDevice, size, usage,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer.buffer, buffer.memory))
+    {
+        LOG_ERROR("Failed to create a particle buffer of ", size, " bytes");
+        return false;
+    }
+
+    buffer.size = size;
+    return true;
+}
+
+void ParticleSystem::DestroyBuffer(Buffer& buffer)
+{
+    VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, buffer.buffer, buffer.memory);
+    buffer = Buffer{};
+}
+
+bool ParticleSystem::CreateDrawPipeline(ParticleSystemConfig& config)
+{
+    m_vertShader = Shader::CreateFromFile(m_deviceCache, ShaderType::Vertex, config.vertShaderFile);
+    m_fragShader = Shader::CreateFromFile(m_deviceCache, ShaderType::Fragment, config.fragShaderFile);
+    if (!m_vertShader || !m_fragShader)
+        return false;
+
+    VkPushConstantRange drawRange{};
+    drawRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    drawRange.offset = 0;
+    drawRange.size = sizeof(ParticleDrawData);
+
+    m_drawLayout = VulkanRenderer::Utils::CreatePipelineLayout(m_deviceCache, {m_setLayout}, {drawRange});
+    if (m_drawLayout == VK_NULL_HANDLE)
+        return false;
+
+    VulkanRenderer::GraphicPipelineState state;
+    state.stages.push_back(
+        {VK_SHADER_STAGE_VERTEX_BIT, m_vertShader->GetModule(), m_vertShader->GetCodeHash(), "main"});
+    state.stages.push_back(
+        {VK_SHADER_STAGE_FRAGMENT_BIT, m_fragShader->GetModule(), m_fragShader->GetCodeHash(), "main"});
+    state.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    // Quads generated from the vertex index, facing the camera whatever the winding ends up being
+    state.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    state.polygonMode = VK_POLYGON_MODE_FILL;
+    state.cullMode = VK_CULL_MODE_NONE;
+    state.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    state.samples = config.samples;
+
+    // Hidden by the scene, but not by each other
+    state.depthTest = true;
+    state.depthWrite = false;
+    state.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+
+    // Additive, the order of the particles doesn't matter. The alpha of the target is kept.
+    VkPipelineColorBlendAttachmentState blend{};
+    blend.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blend.blendEnable = VK_TRUE;
+    blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.colorBlendOp = VK_BLEND_OP_ADD;
+    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.alphaBlendOp = VK_BLEND_OP_ADD;
+    state.colorBlend.push_back(blend);
+
+    state.layout = m_drawLayout;
+    state.renderPass = config.renderPass;
+    state.subpass = config.subpass;
+
+    m_drawPipeline = m_registry->Acquire(state);
+    if (VulkanRenderer::PipelineRegistry::Get(m_drawPipeline) == VK_NULL_HANDLE)
+    {
+        LOG_ERROR("Failed to create the particle draw pipeline");
+        return false;
+    }
+
+    return true;
+}
+
+void ParticleSystem::UploadEmitters(VkCommandBuffer commandBuffer)
+{
+    // Recorded in the command buffer, no staging buffer for a few bytes written once
+    const auto* data = reinterpret_cast<const uint8_t*>(m_emitters.data() + m_uploadedEmitters);
+    VkDeviceSize offset = m_uploadedEmitters * sizeof(ParticleEmitterData);
+    VkDeviceSize remaining = (m_emitters.size() - m_uploadedEmitters) * sizeof(ParticleEmitterData);
+
+    while (remaining > 0)
+    {
+        const VkDeviceSize size = std::min(remaining, maxUpdateSize);
+        vkCmdUpdateBuffer(commandBuffer, m_emitterBuffer.buffer, offset, size, data);
+
+        data += size;
+        offset += size;
+        remaining -= size;
+    }
+
+    m_uploadedEmitters = static_cast<uint32_t>(m_emitters.size());
+}
+
+void ParticleSystem::Dispatch(VkCommandBuffer commandBuffer, ComputePipeline& pipeline,
+                              ParticleFrameData frame, uint32_t groupCount) const
+{
+    VkPipelineLayout pipelineLayout = pipeline.GetPipelineLayout();
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &m_descriptorSet, 0,
+                            nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(frame), &frame);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetPipeline());
+    vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+}
+
+void ParticleSystem::ComputeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage,
+                                    VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
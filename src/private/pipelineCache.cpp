@@ -0,0 +1,71 @@
+#include <pipelineCache.h>
+
+#include <config.h>
+#include <log.h>
+#include <utils/file.h>
+
+#include <cstring>
+
+using VulkanRenderer::PipelineCache;
+using VulkanRenderer::PipelineCacheConfig;
+
+PipelineCache::PipelineCache(PipelineCacheConfig& config)
+    : m_deviceCache(config.device)
+{
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (config.initialData != nullptr && IsCompatible(*config.initialData, config.physicalDevice))
+    {
+        cacheInfo.initialDataSize = config.initialData->size();
+        cacheInfo.pInitialData = config.initialData->data();
+    }
+    else if (config.initialData != nullptr && !config.initialData->empty())
+    {
+        LOG_VERBOSE("Pipeline cache from another device or driver, starting from an empty one");
+    }
+
+    if (vkCreatePipelineCache(m_deviceCache, &cacheInfo, nullptr, &m_cache) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create pipeline cache");
+        m_cache = VK_NULL_HANDLE;
+    }
+}
+
+PipelineCache::~PipelineCache()
+{
+    if (m_cache != VK_NULL_HANDLE)
+        vkDestroyPipelineCache(m_deviceCache, m_cache, nullptr);
+}
+
+bool PipelineCache::IsCompatible(const std::vector<char>& data, VkPhysicalDevice physicalDevice)
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+        return false;
+
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    return header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+bool PipelineCache::Save(const char* filePath) const
+{
+    if (m_cache == VK_NULL_HANDLE)
+        return false;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(m_deviceCache, m_cache, &size, nullptr) != VK_SUCCESS)
+        return false;
+
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(m_deviceCache, m_cache, &size, data.data()) != VK_SUCCESS)
+        return false;
+
+    return VulkanRenderer::Utils::WriteFile(filePath, data.data(), size);
+}
@@ -0,0 +1,619 @@
+#include <pipelineRegistry.h>
+
+#include <log.h>
+#include <profiler.h>
+#include <utils/utils.h>
+
+#include <algorithm>
+#include <tuple>
+
+using VulkanRenderer::GraphicPipelineState;
+using VulkanRenderer::GraphicPipelineStateHash;
+using VulkanRenderer::PipelineRegistry;
+using VulkanRenderer::PipelineRegistryConfig;
+
+namespace
+{
+// Members compared and hashed, the Vulkan structs have no operators
+auto Tie(const GraphicPipelineState::Stage& stage)
+{
+    // The module is left out, only its code matters
+    return std::tie(stage.stage, stage.codeHash, stage.entryPoint);
+}
+
+auto Tie(const VkSpecializationMapEntry& entry) { return std::tie(entry.constantID, entry.offset, entry.size); }
+
+auto Tie(const VkVertexInputBindingDescription& binding)
+{
+    return std::tie(binding.binding, binding.stride, binding.inputRate);
+}
+
+auto Tie(const VkVertexInputAttributeDescription& attribute)
+{
+    return std::tie(attribute.location, attribute.binding, attribute.format, attribute.offset);
+}
+
+auto Tie(const VkPipelineColorBlendAttachmentState& blend)
+{
+    return std::tie(blend.blendEnable, blend.srcColorBlendFactor, blend.dstColorBlendFactor, blend.colorBlendOp,
+                    blend.srcAlphaBlendFactor, blend.dstAlphaBlendFactor, blend.alphaBlendOp, blend.colorWriteMask);
+}
+
+template <typename T>
+bool Equal(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const T& left, const T& right) { return Tie(left) == Tie(right); });
+}
+
+template <typename... Members>
+void HashTuple(size_t& seed, const std::tuple<Members...>& members)
+{
+    std::apply([&seed](const auto&... member) { (VulkanRenderer::Utils::HashCombine(seed, member), ...); }, members);
+}
+
+template <typename T>
+void HashVector(size_t& seed, const std::vector<T>& values)
+{
+    VulkanRenderer::Utils::HashCombine(seed, values.size());
+    for (const T& value : values)
+    {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            VulkanRenderer::Utils::HashCombine(seed, value);
+        else
+            HashTuple(seed, Tie(value));
+    }
+}
+
+// Create infos of every part of a state, a part only uses its own
+struct CreateInfos
+{
+    explicit CreateInfos(const GraphicPipelineState& state);
+    // They point at each other
+    CreateInfos(const CreateInfos&) = delete;
+    CreateInfos& operator=(const CreateInfos&) = delete;
+
+    VkSpecializationInfo specialization{};
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    VkPipelineViewportStateCreateInfo viewportState{};
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+};
+
+CreateInfos::CreateInfos(const GraphicPipelineState& state)
+{
+    // Step 1: Shader stages, specialized with the same constants
+    // Each stage only reads those it declares.
+    specialization.mapEntryCount = static_cast<uint32_t>(state.specializationEntries.size());
+    specialization.pMapEntries = state.specializationEntries.data();
+    specialization.dataSize = state.specializationData.size();
+    specialization.pData = state.specializationData.data();
+
+    stages.resize(state.stages.size());
+    for (size_t i = 0; i < state.stages.size(); ++i)
+    {
+        stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[i].stage = state.stages[i].stage;
+        stages[i].module = state.stages[i].module;
+        stages[i].pName = state.stages[i].entryPoint.c_str();
+        stages[i].pSpecializationInfo = state.specializationEntries.empty() ? nullptr : &specialization;
+    }
+
+    // Step 2: Dynamic state
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(state.dynamicStates.size());
+    dynamicState.pDynamicStates = state.dynamicStates.data();
+
+    // Step 3: Vertex input
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(state.vertexBindings.size());
+    vertexInput.pVertexBindingDescriptions = state.vertexBindings.data();
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.vertexAttributes.size());
+    vertexInput.pVertexAttributeDescriptions = state.vertexAttributes.data();
+
+    // Step 4: Input assembly
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = state.topology;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Step 5: Viewport and scissors, dynamic
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    // Step 6: Rasterizer
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = state.polygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = state.cullMode;
+    rasterizer.frontFace = state.frontFace;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    // Step 7: Multisampling, no sample shading
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = state.samples;
+    multisampling.minSampleShading = 1.0f;
+
+    // Step 8: Depth and stencil testing
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = state.depthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = state.depthCompareOp;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    // Step 9: Color blending
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.attachmentCount = static_cast<uint32_t>(state.colorBlend.size());
+    colorBlending.pAttachments = state.colorBlend.data();
+}
+} // namespace
+
+bool GraphicPipelineState::operator==(const GraphicPipelineState& other) const
+{
+    return Equal(stages, other.stages) && Equal(specializationEntries, other.specializationEntries) &&
+           specializationData == other.specializationData && Equal(vertexBindings, other.vertexBindings) &&
+           Equal(vertexAttributes, other.vertexAttributes) && topology == other.topology &&
+           polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace &&
+           samples == other.samples && depthTest == other.depthTest && depthWrite == other.depthWrite &&
+           depthCompareOp == other.depthCompareOp && Equal(colorBlend, other.colorBlend) &&
+           dynamicStates == other.dynamicStates && layout == other.layout && renderPass == other.renderPass &&
+           subpass == other.subpass;
+}
+
+size_t GraphicPipelineStateHash::operator()(const GraphicPipelineState& state) const
+{
+    using VulkanRenderer::Utils::HashCombine;
+
+    size_t seed = 0;
+    HashVector(seed, state.stages);
+    HashVector(seed, state.specializationEntries);
+    HashVector(seed, state.specializationData);
+    HashVector(seed, state.vertexBindings);
+    HashVector(seed, state.vertexAttributes);
+    HashCombine(seed, state.topology);
+    HashCombine(seed, state.polygonMode);
+    HashCombine(seed, state.cullMode);
+    HashCombine(seed, state.frontFace);
+    HashCombine(seed, state.samples);
+    HashCombine(seed, state.depthTest);
+    HashCombine(seed, state.depthWrite);
+    HashCombine(seed, state.depthCompareOp);
+    HashVector(seed, state.colorBlend);
+    HashVector(seed, state.dynamicStates);
+    HashCombine(seed, state.layout);
+    HashCombine(seed, state.renderPass);
+    HashCombine(seed, state.subpass);
+    return seed;
+}
+
+PipelineRegistry::PipelineRegistry(PipelineRegistryConfig& config)
+    : m_deviceCache(config.device)
+    , m_pipelineCache(config.pipelineCache)
+    , m_useLibraries(config.useLibraries && config.jobSystem)
+    , m_jobSystem(config.jobSystem)
+    , m_framesInFlight(config.framesInFlight)
+{
+    LOG_VERBOSE("Graphics pipeline libraries: ", m_useLibraries ? "on" : "off");
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+    if (m_jobSystem)
+        m_jobSystem->Wait(m_optimizations);
+
+    for (const Optimized& optimized : m_optimized)
+        vkDestroyPipeline(m_deviceCache, optimized.pipeline, nullptr);
+
+    for (const Retired& retired : m_retired)
+        vkDestroyPipeline(m_deviceCache, retired.pipeline, nullptr);
+
+    // Linked pipelines first, then the libraries they come from
+    auto destroyAll = [this](Shards& shards)
+    {
+        for (Shard& shard : shards)
+        {
+            for (auto& [state, entry] : shard.entries)
+                vkDestroyPipeline(m_deviceCache, entry->pipeline.load(std::memory_order_acquire), nullptr);
+        }
+    };
+
+    destroyAll(m_pipelines);
+    for (Shards& libraries : m_libraries)
+        destroyAll(libraries);
+}
+
+bool PipelineRegistry::IsLibrarySupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    // The feature is queried through vkGetPhysicalDeviceFeatures2
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+        return false;
+
+    uint32_t extensionsCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionsCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionsCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionsCount, availableExtensions.data());
+
+    const std::vector<const char*> extensions = GetLibraryDeviceExtensions();
+    if (VulkanRenderer::Utils::ValidateStrings(extensions, availableExtensions,
+                                               [](const VkExtensionProperties& extension) -> const char*
+                                               { return extension.extensionName; }) !=
+        static_cast<int>(extensions.size()))
+        return false;
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures{};
+    libraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &libraryFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return libraryFeatures.graphicsPipelineLibrary;
+}
+
+std::vector<const char*> PipelineRegistry::GetLibraryDeviceExtensions()
+{
+    return {VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME};
+}
+
+VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT PipelineRegistry::GetLibraryFeatures()
+{
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures{};
+    libraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    libraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+    return libraryFeatures;
+}
+
+template <typename CompileFunc>
+PipelineRegistry::Entry* PipelineRegistry::AcquireEntry(Shards& shards, const GraphicPipelineState& state,
+                                                        CompileFunc&& compile)
+{
+    // The high bits pick the shard, the map of the shard uses the low ones
+    const size_t hash = GraphicPipelineStateHash{}(state);
+    const uint32_t shardIndex = static_cast<uint32_t>((hash >> 32) % shardCount);
+    Shard& shard = shards[shardIndex];
+
+    Entry* entry = nullptr;
+    {
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.entries.find(state);
+        if (it != shard.entries.end())
+        {
+            entry = it->second.get();
+            entry->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!entry)
+    {
+        std::unique_lock lock(shard.mutex);
+
+        // Another thread may have added it since the lookup
+        auto [it, inserted] = shard.entries.try_emplace(state, nullptr);
+        if (inserted)
+        {
+            it->second = std::make_unique<Entry>();
+            it->second->state = &it->first;
+            it->second->shard = shardIndex;
+        }
+
+        entry = it->second.get();
+        entry->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The reference keeps the entry alive out of the lock
+    std::call_once(entry->compiled, [&]() { entry->pipeline.store(compile(entry), std::memory_order_release); });
+    return entry;
+}
+
+void PipelineRegistry::ReleaseEntry(Shards& shards, Entry* entry)
+{
+    Shard& shard = shards[entry->shard];
+    std::unique_lock lock(shard.mutex);
+
+    if (entry->references.fetch_sub(1, std::memory_order_relaxed) != 1)
+        return;
+
+    vkDestroyPipeline(m_deviceCache, entry->pipeline.load(std::memory_order_acquire), nullptr);
+    shard.entries.erase(shard.entries.find(*entry->state));
+}
+
+size_t PipelineRegistry::CountEntries(const Shards& shards) const
+{
+    size_t count = 0;
+    for (const Shard& shard : shards)
+    {
+        std::shared_lock lock(shard.mutex);
+        count += shard.entries.size();
+    }
+
+    return count;
+}
+
+PipelineRegistry::Handle PipelineRegistry::Acquire(const GraphicPipelineState& state)
+{
+    return AcquireEntry(m_pipelines, state,
+                        [this, &state](Entry* entry)
+                        { return m_useLibraries ? CompileFromLibraries(state, entry) : Compile(state); });
+}
+
+void PipelineRegistry::Release(Handle handle)
+{
+    if (handle)
+        ReleaseEntry(m_pipelines, handle);
+}
+
+VkPipeline PipelineRegistry::Get(Handle handle)
+{
+    return handle ? handle->pipeline.load(std::memory_order_acquire) : VK_NULL_HANDLE;
+}
+
+void PipelineRegistry::BeginFrame()
+{
+    for (Retired& retired : m_retired)
+    {
+        if (--retired.framesLeft == 0)
+            vkDestroyPipeline(m_deviceCache, retired.pipeline, nullptr);
+    }
+
+    std::erase_if(m_retired, [](const Retired& retired) { return retired.framesLeft == 0; });
+
+    std::vector<Optimized> optimized;
+    {
+        std::lock_guard lock(m_optimizedMutex);
+        optimized.swap(m_optimized);
+    }
+
+    // Nothing is recorded yet this frame, the frames in flight may have bound the fast links
+    for (const Optimized& link : optimized)
+    {
+        if (link.pipeline != VK_NULL_HANDLE)
+        {
+            VkPipeline fastLink = link.entry->pipeline.exchange(link.pipeline, std::memory_order_acq_rel);
+            m_retired.push_back({fastLink, m_framesInFlight});
+        }
+
+        // Taken when the optimization started
+        ReleaseEntry(m_pipelines, link.entry);
+    }
+}
+
+size_t PipelineRegistry::GetPipelineCount() const
+{
+    size_t count = CountEntries(m_pipelines);
+    for (const Shards& libraries : m_libraries)
+        count += CountEntries(libraries);
+
+    return count;
+}
+
+VkPipeline PipelineRegistry::Compile(const GraphicPipelineState& state)
+{
+    PROFILE_FUNCTION();
+
+    CreateInfos infos(state);
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(infos.stages.size());
+    pipelineInfo.pStages = infos.stages.data();
+    pipelineInfo.pVertexInputState = &infos.vertexInput;
+    pipelineInfo.pInputAssemblyState = &infos.inputAssembly;
+    pipelineInfo.pViewportState = &infos.viewportState;
+    pipelineInfo.pRasterizationState = &infos.rasterizer;
+    pipelineInfo.pMultisampleState = &infos.multisampling;
+    pipelineInfo.pDepthStencilState = &infos.depthStencil;
+    pipelineInfo.pColorBlendState = &infos.colorBlending;
+    pipelineInfo.pDynamicState = &infos.dynamicState;
+    pipelineInfo.layout = state.layout;
+    pipelineInfo.renderPass = state.renderPass;
+    pipelineInfo.subpass = state.subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(m_deviceCache, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create graphics pipeline");
+        return VK_NULL_HANDLE;
+    }
+
+    m_compileCount.fetch_add(1, std::memory_order_relaxed);
+    return pipeline;
+}
+
+VkPipeline PipelineRegistry::CompileFromLibraries(const GraphicPipelineState& state, Entry* entry)
+{
+    PROFILE_FUNCTION();
+
+    // Parts already used by other states are not compiled again
+    LibraryParts parts{};
+    for (uint32_t i = 0; i < libraryPartCount; ++i)
+    {
+        const LibraryPart part = static_cast<LibraryPart>(i);
+        const GraphicPipelineState partState = GetPartState(state, part);
+        Entry* partEntry =
+            AcquireEntry(m_libraries[i], partState, [&](Entry*) { return CompileLibraryPart(partState, part); });
+
+        parts[i] = Get(partEntry);
+        if (parts[i] == VK_NULL_HANDLE)
+            return Compile(state);
+    }
+
+    VkPipeline pipeline = Link(parts, state.layout, false);
+    if (pipeline == VK_NULL_HANDLE)
+        return Compile(state);
+
+    // The optimization holds a reference until its pipeline is swapped in. The caller holds one already, the entry
+    // can't be released meanwhile.
+    entry->references.fetch_add(1, std::memory_order_relaxed);
+    m_jobSystem->Run(
+        [this, entry, parts, layout = state.layout]()
+        {
+            VkPipeline optimized = Link(parts, layout, true);
+
+            std::lock_guard lock(m_optimizedMutex);
+            m_optimized.push_back({entry, optimized});
+        },
+        &m_optimizations);
+
+    return pipeline;
+}
+
+VkPipeline PipelineRegistry::CompileLibraryPart(const GraphicPipelineState& partState, LibraryPart part)
+{
+    PROFILE_FUNCTION();
+
+    CreateInfos infos(partState);
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+
+    // Kept so the optimized links can still optimize across the parts
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    pipelineInfo.flags =
+        VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    pipelineInfo.basePipelineIndex = -1;
+
+    switch (part)
+    {
+    case LibraryPart::VertexInput:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        pipelineInfo.pVertexInputState = &infos.vertexInput;
+        pipelineInfo.pInputAssemblyState = &infos.inputAssembly;
+        break;
+    case LibraryPart::PreRasterization:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        pipelineInfo.stageCount = static_cast<uint32_t>(infos.stages.size());
+        pipelineInfo.pStages = infos.stages.data();
+        pipelineInfo.pViewportState = &infos.viewportState;
+        pipelineInfo.pRasterizationState = &infos.rasterizer;
+        pipelineInfo.pDynamicState = &infos.dynamicState;
+        break;
+    case LibraryPart::FragmentShader:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        pipelineInfo.stageCount = static_cast<uint32_t>(infos.stages.size());
+        pipelineInfo.pStages = infos.stages.data();
+        pipelineInfo.pMultisampleState = &infos.multisampling;
+        pipelineInfo.pDepthStencilState = &infos.depthStencil;
+        break;
+    case LibraryPart::FragmentOutput:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+        pipelineInfo.pMultisampleState = &infos.multisampling;
+        pipelineInfo.pColorBlendState = &infos.colorBlending;
+        break;
+    default:
+        return VK_NULL_HANDLE;
+    }
+
+    pipelineInfo.layout = partState.layout;
+    pipelineInfo.renderPass = partState.renderPass;
+    pipelineInfo.subpass = partState.subpass;
+
+    VkPipeline library = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(m_deviceCache, m_pipelineCache, 1, &pipelineInfo, nullptr, &library) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create graphics pipeline library ", static_cast<uint32_t>(part));
+        return VK_NULL_HANDLE;
+    }
+
+    m_compileCount.fetch_add(1, std::memory_order_relaxed);
+    return library;
+}
+
+VkPipeline PipelineRegistry::Link(const LibraryParts& parts, VkPipelineLayout layout, bool optimize)
+{
+    PROFILE_FUNCTION();
+
+    VkPipelineLibraryCreateInfoKHR libraryInfo{};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    libraryInfo.libraryCount = static_cast<uint32_t>(parts.size());
+    libraryInfo.pLibraries = parts.data();
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    pipelineInfo.layout = layout;
+    pipelineInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(m_deviceCache, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to link graphics pipeline", optimize ? " with link time optimization" : "");
+        return VK_NULL_HANDLE;
+    }
+
+    m_compileCount.fetch_add(1, std::memory_order_relaxed);
+    return pipeline;
+}
+
+GraphicPipelineState PipelineRegistry::GetPartState(const GraphicPipelineState& state, LibraryPart part)
+{
+    GraphicPipelineState partState;
+
+    auto copyStages = [&](VkShaderStageFlagBits stage)
+    {
+        for (const GraphicPipelineState::Stage& shader : state.stages)
+        {
+            if (shader.stage == stage)
+                partState.stages.push_back(shader);
+        }
+
+        partState.specializationEntries = state.specializationEntries;
+        partState.specializationData = state.specializationData;
+    };
+
+    switch (part)
+    {
+    case LibraryPart::VertexInput:
+        partState.vertexBindings = state.vertexBindings;
+        partState.vertexAttributes = state.vertexAttributes;
+        partState.topology = state.topology;
+        return partState;
+    case LibraryPart::PreRasterization:
+        copyStages(VK_SHADER_STAGE_VERTEX_BIT);
+        partState.polygonMode = state.polygonMode;
+        partState.cullMode = state.cullMode;
+        partState.frontFace = state.frontFace;
+        partState.dynamicStates = state.dynamicStates;
+        partState.layout = state.layout;
+        break;
+    case LibraryPart::FragmentShader:
+        // No stage for the depth only pipelines
+        copyStages(VK_SHADER_STAGE_FRAGMENT_BIT);
+        partState.samples = state.samples;
+        partState.depthTest = state.depthTest;
+        partState.depthWrite = state.depthWrite;
+        partState.depthCompareOp = state.depthCompareOp;
+        partState.layout = state.layout;
+        break;
+    case LibraryPart::FragmentOutput:
+        partState.colorBlend = state.colorBlend;
+        partState.samples = state.samples;
+        break;
+    default:
+        break;
+    }
+
+    // All but the vertex input depend on the subpass
+    partState.renderPass = state.renderPass;
+    partState.subpass = state.subpass;
+    return partState;
+}
@@ -0,0 +1,458 @@
+#include <postProcess.h>
+
+#include <computePipeline.h>
+#include <descriptorAllocator.h>
+#include <log.h>
+#include <profiler.h>
+#include <renderTarget.h>
+#include <utils/memory.h>
+
+#include <array>
+#include <sstream>
+#include <utility>
+
+using VulkanRenderer::PostEffect;
+using VulkanRenderer::PostEffectMask;
+using VulkanRenderer::PostProcess;
+using VulkanRenderer::PostProcessConfig;
+
+namespace
+{
+// Must match the local size of the shader
+constexpr uint32_t tileSize = 16;
+
+// Written as is, whatever the format of the viewport, the blit converts it
+constexpr VkFormat outputFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+// Without blits, the output is copied and the shader writes it as the viewport stores it. Must match the shader.
+constexpr uint32_t outputSwapRedBlue = 1u << 0;
+constexpr uint32_t outputSrgb = 1u << 1;
+
+// Flags to write a copy of the output into an image of this format, false when it can't be copied into
+bool GetCopyOutputFlags(VkFormat format, uint32_t& outFlags)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+        outFlags = 0;
+        return true;
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+        outFlags = outputSrgb;
+        return true;
+    case VK_FORMAT_B8G8R8A8_UNORM:
+        outFlags = outputSwapRedBlue;
+        return true;
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        outFlags = outputSwapRedBlue | outputSrgb;
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr std::array<std::pair<const char*, PostEffect>, 5> effectNames = {{
+    {"tonemap", PostEffect::Tonemap},
+    {"grading", PostEffect::ColorGrading},
+    {"sharpen", PostEffect::Sharpen},
+    {"vignette", PostEffect::Vignette},
+    {"grain", PostEffect::FilmGrain},
+}};
+
+// Subtle defaults, the scene is still rendered in the swap chain format
+constexpr float defaultExposure = 1.f;
+constexpr float defaultSaturation = 1.1f;
+constexpr float defaultContrast = 1.05f;
+constexpr float defaultSharpenStrength = 0.25f;
+constexpr float defaultVignetteStrength = 0.5f;
+constexpr float defaultGrainStrength = 0.04f;
+
+VkImageMemoryBarrier ImageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                  VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    return barrier;
+}
+} // namespace
+
+PostProcess::PostProcess(PostProcessConfig& config)
+    : m_deviceCache(config.device)
+    , m_physicalDevice(config.physicalDevice)
+    , m_sceneFormat(config.sceneFormat)
+    , m_samples(config.samples)
+    , m_depthFormat(config.depthFormat)
+    , m_keepDepth(config.keepDepth)
+{
+    m_settings.effects = config.effects;
+    m_settings.exposure = defaultExposure;
+    m_settings.saturation = defaultSaturation;
+    m_settings.contrast = defaultContrast;
+    m_settings.sharpenStrength = defaultSharpenStrength;
+    m_settings.vignetteStrength = defaultVignetteStrength;
+    m_settings.grainStrength = defaultGrainStrength;
+
+    // The viewports are in the scene format. Blits convert and scale, copies can do neither.
+    VkFormatProperties sceneProperties{};
+    VkFormatProperties outputProperties{};
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, m_sceneFormat, &sceneProperties);
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, outputFormat, &outputProperties);
+
+    const VkFormatFeatureFlags sceneFeatures = sceneProperties.optimalTilingFeatures;
+    const VkFormatFeatureFlags outputFeatures = outputProperties.optimalTilingFeatures;
+    // Upscaled with a linear filter
+    const VkFormatFeatureFlags blitSource =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    const bool blitToViewport = (sceneFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) != 0;
+
+    m_blitScene = blitToViewport && (sceneFeatures & blitSource) == blitSource;
+    m_blitOutput = blitToViewport && (outputFeatures & blitSource) == blitSource;
+
+    if (m_settings.effects != 0 && !m_blitOutput && !GetCopyOutputFlags(m_sceneFormat, m_copyOutputFlags))
+    {
+        LOG_ERROR("Post-processed images can't be blitted nor copied into viewports of format ", m_sceneFormat);
+        return;
+    }
+
+    if (!CanUpscale())
+        LOG_WARNING("Viewports of format ", m_sceneFormat, " can't be blitted into, the scene is never upscaled");
+
+    VulkanRenderer::SceneRenderPassDesc sceneDesc;
+    sceneDesc.colorFormat = m_sceneFormat;
+    sceneDesc.depthFormat = m_depthFormat;
+    sceneDesc.samples = m_samples;
+    sceneDesc.depthPrepass = config.depthPrepass;
+
+    m_sceneRenderPass = VulkanRenderer::RenderTarget::CreateRenderPass(
+        m_deviceCache, sceneDesc, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_keepDepth);
+    if (m_sceneRenderPass == VK_NULL_HANDLE)
+        return;
+
+    // Only read with texelFetch, the filtering doesn't matter
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    if (vkCreateSampler(m_deviceCache, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the post-processing sampler");
+        m_sampler = VK_NULL_HANDLE;
+        return;
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    m_setLayout = config.layoutCache->GetLayout(bindings);
+    if (m_setLayout == VK_NULL_HANDLE)
+        return;
+
+    VkPushConstantRange settingsRange{};
+    settingsRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    settingsRange.offset = 0;
+    settingsRange.size = sizeof(PostProcessData);
+
+    VulkanRenderer::ComputePipelineConfig pipelineConfig;
+    pipelineConfig.device = m_deviceCache;
+    pipelineConfig.shaderFile = config.shaderFile;
+    pipelineConfig.pipelineName = "main";
+    pipelineConfig.descriptorSetLayouts = {m_setLayout};
+    pipelineConfig.pushConstantRanges = {settingsRange};
+    pipelineConfig.defaultFeatures = 0;
+    pipelineConfig.pipelineCache = config.pipelineCache;
+
+    m_pipeline = std::make_unique<VulkanRenderer::ComputePipeline>(pipelineConfig);
+}
+
+PostProcess::~PostProcess()
+{
+    for (auto& [viewport, target] : m_targets)
+        DestroyTarget(target);
+
+    m_pipeline.reset();
+
+    if (m_sampler != VK_NULL_HANDLE)
+        vkDestroySampler(m_deviceCache, m_sampler, nullptr);
+
+    if (m_sceneRenderPass != VK_NULL_HANDLE)
+        vkDestroyRenderPass(m_deviceCache, m_sceneRenderPass, nullptr);
+}
+
+bool PostProcess::IsValid() const { return m_pipeline && m_pipeline->IsValid() && m_sampler != VK_NULL_HANDLE; }
+
+bool PostProcess::ParseEffects(const std::string& text, PostEffectMask& outEffects)
+{
+    std::istringstream stream(text);
+    std::string name;
+
+    outEffects = 0;
+    while (std::getline(stream, name, ','))
+    {
+        bool found = false;
+        for (const auto& [effectName, effect] : effectNames)
+        {
+            if (name == effectName)
+            {
+                outEffects |= PostEffectBit(effect);
+                found = true;
+            }
+        }
+
+        if (!found)
+        {
+            LOG_ERROR("Unknown post-processing effect ", name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PostProcess::PrepareTarget(uint32_t viewport, VkExtent2D extent)
+{
+    Target& target = m_targets[viewport];
+    if (target.scene && target.extent.width == extent.width && target.extent.height == extent.height)
+        return true;
+
+    DestroyTarget(target);
+    return CreateTarget(target, extent);
+}
+
+bool PostProcess::HasTarget(uint32_t viewport) const
+{
+    auto it = m_targets.find(viewport);
+    return it != m_targets.end() && it->second.outputView != VK_NULL_HANDLE;
+}
+
+void PostProcess::ReleaseTarget(uint32_t viewport)
+{
+    auto it = m_targets.find(viewport);
+    if (it == m_targets.end())
+        return;
+
+    DestroyTarget(it->second);
+    m_targets.erase(it);
+}
+
+VkFramebuffer PostProcess::GetSceneFramebuffer(uint32_t viewport) const
+{
+    return m_targets.at(viewport).scene->GetFramebuffer();
+}
+
+VkImageView PostProcess::GetSceneDepthView(uint32_t viewport) const
+{
+    return m_targets.at(viewport).scene->GetDepthView();
+}
+
+bool PostProcess::CreateTarget(Target& target, VkExtent2D extent)
+{
+    target.extent = extent;
+
+    VulkanRenderer::RenderTargetConfig sceneConfig;
+    sceneConfig.device = m_deviceCache;
+    sceneConfig.physicalDevice = m_physicalDevice;
+    sceneConfig.renderPass = m_sceneRenderPass;
+    sceneConfig.format = m_sceneFormat;
+    sceneConfig.extent = extent;
+    sceneConfig.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    sceneConfig.samples = m_samples;
+    sceneConfig.depthFormat = m_depthFormat;
+    sceneConfig.keepDepth = m_keepDepth;
+
+    target.scene = std::make_unique<VulkanRenderer::RenderTarget>(sceneConfig);
+    if (!target.scene->IsValid())
+        return false;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = outputFormat;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (!VulkanRenderer::Utils::CreateImage(m_deviceCache, m_physicalDevice, imageInfo,
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.output, target.outputMemory))
+        return false;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = target.output;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = outputFormat;
+    viewInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                           VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    if (vkCreateImageView(m_deviceCache, &viewInfo, nullptr, &target.outputView) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the post-processing output view");
+        target.outputView = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+void PostProcess::DestroyTarget(Target& target)
+{
+    if (target.outputView != VK_NULL_HANDLE)
+        vkDestroyImageView(m_deviceCache, target.outputView, nullptr);
+
+    VulkanRenderer::Utils::DestroyImage(m_deviceCache, target.output, target.outputMemory);
+    target = Target{};
+}
+
+bool PostProcess::Record(VkCommandBuffer commandBuffer, uint32_t viewport, DescriptorAllocator& allocator,
+                         uint32_t frame, VkExtent2D renderExtent, VkImage dstImage, VkImageLayout dstFinalLayout)
+{
+    PROFILE_FUNCTION();
+
+    const Target& target = m_targets.at(viewport);
+
+    const bool blit = m_settings.effects != 0 ? m_blitOutput : m_blitScene;
+    if (!blit && (renderExtent.width != target.extent.width || renderExtent.height != target.extent.height))
+    {
+        LOG_ERROR("The scene can't be upscaled without blits");
+        return false;
+    }
+
+    // Only upscaled, the scene is blitted directly. The render pass already made its writes visible to transfers.
+    VkImage srcImage = target.scene->GetImage();
+    VkImageMemoryBarrier srcToBlit = ImageBarrier(srcImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, VK_ACCESS_TRANSFER_READ_BIT);
+
+    if (m_settings.effects != 0)
+    {
+        VkDescriptorSet descriptorSet = allocator.Allocate(m_setLayout);
+        if (descriptorSet == VK_NULL_HANDLE)
+            return false;
+
+        VkDescriptorImageInfo sceneInfo{};
+        sceneInfo.sampler = m_sampler;
+        sceneInfo.imageView = target.scene->GetImageView();
+        sceneInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkDescriptorImageInfo outputInfo{};
+        outputInfo.imageView = target.outputView;
+        outputInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        for (uint32_t i = 0; i < writes.size(); ++i)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+        }
+
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &sceneInfo;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &outputInfo;
+
+        vkUpdateDescriptorSets(m_deviceCache, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        // The previous blit is done reading the output before it is overwritten. The scene render pass already
+        // made its writes visible to the compute shader.
+        VkImageMemoryBarrier toStorage = ImageBarrier(target.output, VK_IMAGE_LAYOUT_UNDEFINED,
+                                                      VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &toStorage);
+
+        // Every effect in a single dispatch, over the part of the scene rendered
+        PostProcessData settings = m_settings;
+        settings.frame = frame;
+        settings.renderWidth = renderExtent.width;
+        settings.renderHeight = renderExtent.height;
+        settings.outputFlags = blit ? 0 : m_copyOutputFlags;
+
+        VkPipelineLayout pipelineLayout = m_pipeline->GetPipelineLayout();
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+                                0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(settings),
+                           &settings);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline->GetPipeline());
+        vkCmdDispatch(commandBuffer, (renderExtent.width + tileSize - 1) / tileSize,
+                      (renderExtent.height + tileSize - 1) / tileSize, 1);
+
+        srcImage = target.output;
+        srcToBlit = ImageBarrier(target.output, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                 VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    }
+
+    // Source ready to be read, and the viewport image to be written. Its content is discarded, the wait on its
+    // acquisition is chained through the color attachment output stage.
+    std::array<VkImageMemoryBarrier, 2> toBlit = {
+        srcToBlit, ImageBarrier(dstImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                                VK_ACCESS_TRANSFER_WRITE_BIT)};
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(toBlit.size()), toBlit.data());
+
+    // The blit converts to the viewport format, and upscales when rendered at a lower resolution
+    const bool upscaled = renderExtent.width != target.extent.width || renderExtent.height != target.extent.height;
+
+    if (blit)
+    {
+        VkImageBlit region{};
+        region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.srcOffsets[1] = {static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height),
+                                1};
+        region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.dstOffsets[1] = {static_cast<int32_t>(target.extent.width),
+                                static_cast<int32_t>(target.extent.height), 1};
+
+        vkCmdBlitImage(commandBuffer, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstImage,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region,
+                       upscaled ? VK_FILTER_LINEAR : VK_FILTER_NEAREST);
+    }
+    else
+    {
+        // Same size, and already in the viewport encoding
+        VkImageCopy region{};
+        region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.extent = {target.extent.width, target.extent.height, 1};
+
+        vkCmdCopyImage(commandBuffer, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstImage,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    // Left as the render pass would have, for the presentation or the frame capture
+    VkImageMemoryBarrier toFinal = ImageBarrier(dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dstFinalLayout,
+                                                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &toFinal);
+
+    return true;
+}
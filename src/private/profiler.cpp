@@ -0,0 +1,238 @@
+#include <profiler.h>
+
+#if defined(VULKAN_RENDERER_PROFILER)
+
+#include <log.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Per thread, 2^16 events of 16 bytes
+constexpr uint64_t eventCapacity = 1 << 16;
+
+enum class EventType : uint8_t
+{
+    Begin,
+    End,
+};
+
+// Atomics, the dump reads the slots while the thread overwrites the oldest ones
+struct Event
+{
+    std::atomic<const char*> name;
+    // Nanoseconds since the profiler start, shifted by one, with the EventType in the lowest bit
+    std::atomic<uint64_t> timestampAndType;
+};
+
+static_assert(sizeof(Event) == 16, "Keep events small, they are written in hot paths");
+
+// Copied out of the ring by the dump
+struct DumpedEvent
+{
+    const char* name;
+    uint64_t timestamp;
+    EventType type;
+};
+
+// Written by a single thread, read by the one dumping, as a sequence lock over the whole ring.
+// The writer announces the slot it is about to overwrite through started, then publishes it through head. The dump
+// copies the last eventCapacity published events, then drops the ones started meanwhile, as they may be torn.
+struct ThreadBuffer
+{
+    std::array<Event, eventCapacity> events;
+    std::atomic<uint64_t> started = 0;
+    std::atomic<uint64_t> head = 0;
+    uint32_t threadId = 0;
+    std::string threadName;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    // Buffers outlive their thread, so a dump after a thread exited still has its events
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer& GetThreadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        // Only once per thread
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->threadId = static_cast<uint32_t>(registry.buffers.size());
+        buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+        registry.buffers.push_back(buffer);
+    }
+
+    return *buffer;
+}
+
+void PushEvent(const char* name, EventType type)
+{
+    // Registry first, so its start is before the first timestamp
+    static const std::chrono::steady_clock::time_point start = GetRegistry().start;
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                             .count();
+
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+    // A dump reading the slot sees this before the new content, and drops it
+    buffer.started.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event& event = buffer.events[head % eventCapacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.timestampAndType.store(timestamp << 1 | static_cast<uint64_t>(type), std::memory_order_relaxed);
+
+    // Publish the event to the dump
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void WriteEscaped(std::ostream& stream, const char* text)
+{
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            stream << '\\';
+
+        stream << *c;
+    }
+}
+} // namespace
+
+void VulkanRenderer::Profiler::BeginEvent(const char* name)
+{
+    PushEvent(name, EventType::Begin);
+}
+
+void VulkanRenderer::Profiler::EndEvent()
+{
+    PushEvent(nullptr, EventType::End);
+}
+
+void VulkanRenderer::Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    std::lock_guard lock(GetRegistry().mutex);
+    buffer.threadName = name;
+}
+
+bool VulkanRenderer::Profiler::DumpChromeTrace(const char* filePath)
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string> threadNames;
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        buffers = registry.buffers;
+
+        for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+            threadNames.push_back(buffer->threadName);
+    }
+
+    std::ofstream stream(filePath, std::ios::trunc);
+    if (!stream.is_open())
+    {
+        LOG_ERROR("Failed to open ", filePath, " to dump the profiler trace");
+        return false;
+    }
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    auto separator = [&]() -> std::ostream&
+    {
+        if (!first)
+            stream << ",\n";
+
+        first = false;
+        return stream;
+    };
+
+    std::vector<DumpedEvent> events;
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        ThreadBuffer& buffer = *buffers[i];
+
+        separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer.threadId
+                    << ",\"args\":{\"name\":\"";
+        WriteEscaped(stream, threadNames[i].c_str());
+        stream << "\"}}";
+
+        // Copy the events still in the ring, then drop those the thread started overwriting during the copy
+        uint64_t head = buffer.head.load(std::memory_order_acquire);
+        uint64_t begin = head > eventCapacity ? head - eventCapacity : 0;
+
+        events.clear();
+        for (uint64_t index = begin; index < head; ++index)
+        {
+            const Event& event = buffer.events[index % eventCapacity];
+            const uint64_t timestampAndType = event.timestampAndType.load(std::memory_order_relaxed);
+            events.push_back({event.name.load(std::memory_order_relaxed), timestampAndType >> 1,
+                              static_cast<EventType>(timestampAndType & 1)});
+        }
+
+        // Pairs with the fence of the writer: any slot read with new content has its start visible here
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t started = buffer.started.load(std::memory_order_relaxed);
+        uint64_t firstValid = started > eventCapacity ? started - eventCapacity : 0;
+        size_t skipped = firstValid > begin ? static_cast<size_t>(firstValid - begin) : 0;
+
+        // An end without its begin (lost in the ring) would close a zone of the viewer, skip them
+        uint32_t depth = 0;
+        for (size_t e = std::min(skipped, events.size()); e < events.size(); ++e)
+        {
+            const DumpedEvent& event = events[e];
+            bool isBegin = event.type == EventType::Begin;
+
+            if (!isBegin && depth == 0)
+                continue;
+
+            depth = isBegin ? depth + 1 : depth - 1;
+
+            // Microseconds, with the nanoseconds as decimals
+            uint64_t microseconds = event.timestamp / 1000;
+            std::string nanoseconds = std::to_string(1000 + event.timestamp % 1000).substr(1);
+
+            separator() << "{\"ph\":\"" << (isBegin ? 'B' : 'E') << "\",\"pid\":0,\"tid\":" << buffer.threadId
+                        << ",\"ts\":" << microseconds << '.' << nanoseconds;
+
+            if (isBegin)
+            {
+                stream << ",\"name\":\"";
+                WriteEscaped(stream, event.name);
+                stream << '"';
+            }
+
+            stream << '}';
+        }
+    }
+
+    stream << "\n]}\n";
+    return stream.good();
+}
+
+#endif
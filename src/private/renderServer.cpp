@@ -0,0 +1,549 @@
+#include <renderServer.h>
+
+#include <log.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using VulkanRenderer::RenderConnection;
+using VulkanRenderer::RenderJob;
+using VulkanRenderer::RenderRequest;
+using VulkanRenderer::RenderServer;
+using VulkanRenderer::RenderServerConfig;
+
+namespace
+{
+// A request is a single short line, anything longer is not one
+constexpr size_t maxRequestSize = 4096;
+constexpr size_t maxIdSize = 64;
+// How often the I/O thread checks it must stop
+constexpr int pollTimeoutMilliseconds = 100;
+
+// Past those, the jobs of the client wait for it to read what it was sent
+constexpr uint64_t maxReplyBacklog = 16;
+constexpr size_t maxQueuedBytes = 64 << 20;
+// A client that doesn't read anything for that long is dropped
+constexpr std::chrono::seconds stallTimeout{10};
+// Time left to the clients to read their last replies when the server stops
+constexpr std::chrono::seconds stopFlushTimeout{2};
+
+constexpr float defaultFieldOfView = 45.f;
+constexpr float nearPlane = 0.1f;
+constexpr float farPlane = 100.f;
+
+volatile std::sig_atomic_t stopSignal = 0;
+
+void OnStopSignal(int) { stopSignal = 1; }
+
+bool ParseUint(const std::string& text, uint32_t& outValue)
+{
+    const char* end = text.data() + text.size();
+    auto [last, error] = std::from_chars(text.data(), end, outValue);
+    return error == std::errc() && last == end;
+}
+
+bool ParseFloats(const std::string& text, std::vector<float>& outValues)
+{
+    std::istringstream stream(text);
+    std::string value;
+
+    while (std::getline(stream, value, ','))
+    {
+        char* end = nullptr;
+        outValues.push_back(std::strtof(value.c_str(), &end));
+        if (value.empty() || *end != '\0')
+            return false;
+    }
+
+    return true;
+}
+} // namespace
+
+RenderConnection::RenderConnection(int socket)
+    : m_socket(socket)
+{
+}
+
+RenderConnection::~RenderConnection()
+{
+#if !defined(_WIN32)
+    if (m_socket >= 0)
+        close(m_socket);
+#endif
+}
+
+uint64_t RenderConnection::ReserveReplies(uint32_t count)
+{
+    std::lock_guard lock(m_sendMutex);
+
+    const uint64_t first = m_reservedReplies;
+    m_reservedReplies += count;
+    return first;
+}
+
+bool RenderConnection::SendFrame(uint64_t reply, const std::string& id, uint32_t frame, const char* encoding,
+                                 uint32_t width, uint32_t height, const std::vector<uint8_t>& data)
+{
+    char header[160];
+    int headerSize = std::snprintf(header, sizeof(header), "frame %s %u %s %u %u %zu\n", id.c_str(), frame,
+                                   encoding, width, height, data.size());
+
+    std::string message(header, static_cast<size_t>(headerSize));
+    message.append(reinterpret_cast<const char*>(data.data()), data.size());
+
+    std::lock_guard lock(m_sendMutex);
+    return Complete(reply, std::move(message));
+}
+
+bool RenderConnection::SendDone(uint64_t reply, const std::string& id)
+{
+    std::lock_guard lock(m_sendMutex);
+    return Complete(reply, "done " + id + "\n");
+}
+
+bool RenderConnection::SendError(const std::string& id, const std::string& message)
+{
+    std::lock_guard lock(m_sendMutex);
+    return Complete(m_reservedReplies++, "error " + id + " " + message + "\n");
+}
+
+bool RenderConnection::IsBacklogged() const
+{
+    std::lock_guard lock(m_sendMutex);
+    return m_reservedReplies - m_queuedReplies > maxReplyBacklog || m_output.size() - m_outputOffset > maxQueuedBytes;
+}
+
+bool RenderConnection::IsBroken() const
+{
+    std::lock_guard lock(m_sendMutex);
+    return m_broken;
+}
+
+bool RenderConnection::HasOutput() const
+{
+    std::lock_guard lock(m_sendMutex);
+    return m_outputOffset < m_output.size();
+}
+
+bool RenderConnection::Flush()
+{
+    std::lock_guard lock(m_sendMutex);
+    WriteOutput();
+
+    if (m_outputOffset < m_output.size() && std::chrono::steady_clock::now() - m_lastProgress > stallTimeout)
+        Drop("stopped reading");
+
+    return !m_broken;
+}
+
+bool RenderConnection::Complete(uint64_t reply, std::string message)
+{
+    if (m_broken)
+        return false;
+
+    m_completedReplies.emplace(reply, std::move(message));
+
+    // Only once the replies reserved before are in the output
+    for (auto it = m_completedReplies.begin(); it != m_completedReplies.end() && it->first == m_queuedReplies;
+         it = m_completedReplies.erase(it))
+    {
+        if (m_outputOffset == m_output.size())
+            m_lastProgress = std::chrono::steady_clock::now();
+
+        m_output += it->second;
+        ++m_queuedReplies;
+    }
+
+    WriteOutput();
+    return !m_broken;
+}
+
+void RenderConnection::WriteOutput()
+{
+#if !defined(_WIN32)
+    while (!m_broken && m_outputOffset < m_output.size())
+    {
+        ssize_t sent = send(m_socket, m_output.data() + m_outputOffset, m_output.size() - m_outputOffset, 0);
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            break;
+
+        if (sent <= 0)
+        {
+            Drop("disconnected");
+            break;
+        }
+
+        m_outputOffset += static_cast<size_t>(sent);
+        m_lastProgress = std::chrono::steady_clock::now();
+    }
+
+    // The rest is sent later, don't move it on each partial send
+    if (m_outputOffset == m_output.size() || m_outputOffset > m_output.size() / 2)
+    {
+        m_output.erase(0, m_outputOffset);
+        m_outputOffset = 0;
+    }
+#endif
+}
+
+void RenderConnection::Drop(const char* reason)
+{
+    LOG_VERBOSE("Render server client dropped, ", reason);
+
+    m_broken = true;
+    m_output.clear();
+    m_outputOffset = 0;
+    m_completedReplies.clear();
+
+#if !defined(_WIN32)
+    // The client sees the end of the stream now, the socket is closed with the last job holding it
+    shutdown(m_socket, SHUT_RDWR);
+#endif
+}
+
+RenderServer::RenderServer(RenderServerConfig& config)
+    : m_socketPath(config.socketPath)
+    , m_maxImageSize(config.maxImageSize)
+    , m_maxFrameCount(config.maxFrameCount)
+{
+#if defined(_WIN32)
+    LOG_ERROR("The render server needs Unix domain sockets, not available on this platform");
+#else
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.empty() || m_socketPath.size() >= sizeof(address.sun_path))
+    {
+        LOG_ERROR("Invalid render server socket path ", m_socketPath);
+        return;
+    }
+
+    std::copy(m_socketPath.begin(), m_socketPath.end(), address.sun_path);
+
+    m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenSocket < 0)
+    {
+        LOG_ERROR("Failed to create the render server socket");
+        return;
+    }
+
+    // Left behind by a server that didn't exit cleanly
+    unlink(m_socketPath.c_str());
+
+    if (bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(m_listenSocket, SOMAXCONN) != 0)
+    {
+        LOG_ERROR("Failed to listen on ", m_socketPath);
+        close(m_listenSocket);
+        m_listenSocket = -1;
+        return;
+    }
+
+    // Clients going away are seen as failed sends, not as a signal killing the process
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, OnStopSignal);
+    std::signal(SIGTERM, OnStopSignal);
+
+    m_ioThread = std::thread(&RenderServer::IoLoop, this);
+#endif
+}
+
+RenderServer::~RenderServer()
+{
+    m_stop.store(true);
+    if (m_ioThread.joinable())
+        m_ioThread.join();
+
+    // Jobs still hold their connection
+    m_clients.clear();
+
+#if !defined(_WIN32)
+    if (m_listenSocket >= 0)
+    {
+        close(m_listenSocket);
+        unlink(m_socketPath.c_str());
+    }
+#endif
+}
+
+bool RenderServer::IsStopRequested() const { return stopSignal != 0; }
+
+std::vector<RenderJob> RenderServer::WaitForJobs(std::chrono::milliseconds timeout)
+{
+    std::unique_lock lock(m_jobsMutex);
+    m_jobsAvailable.wait_for(lock, timeout, [this]() { return !m_jobs.empty(); });
+
+    std::vector<RenderJob> jobs;
+    jobs.swap(m_jobs);
+    return jobs;
+}
+
+bool RenderServer::ParseRequest(const std::string& line, RenderRequest& outRequest, std::string& outError) const
+{
+    std::istringstream stream(line);
+    std::string token;
+
+    std::vector<float> camera;
+    bool hasWidth = false;
+    bool hasHeight = false;
+
+    while (stream >> token)
+    {
+        size_t separator = token.find('=');
+        if (separator == std::string::npos)
+        {
+            outError = "expected key=value, got " + token;
+            return false;
+        }
+
+        const std::string key = token.substr(0, separator);
+        const std::string value = token.substr(separator + 1);
+
+        bool valid = true;
+        if (key == "id")
+        {
+            valid = !value.empty() && value.size() <= maxIdSize;
+            if (valid)
+                outRequest.id = value;
+        }
+        else if (key == "width")
+            valid = hasWidth = ParseUint(value, outRequest.width);
+        else if (key == "height")
+            valid = hasHeight = ParseUint(value, outRequest.height);
+        else if (key == "frames")
+            valid = ParseUint(value, outRequest.frameCount);
+        else if (key == "scene")
+            outRequest.scene = value;
+        else if (key == "camera")
+            valid = ParseFloats(value, camera) && (camera.size() == 6 || camera.size() == 7);
+        else if (key == "format" && value == "png")
+            outRequest.format = VulkanRenderer::CaptureFormat::Png;
+        else if (key == "format" && value == "raw")
+            outRequest.format = VulkanRenderer::CaptureFormat::Raw;
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            outError = "invalid " + token;
+            return false;
+        }
+    }
+
+    if (!hasWidth || !hasHeight)
+    {
+        outError = "width and height are required";
+        return false;
+    }
+
+    if (outRequest.width == 0 || outRequest.height == 0 || outRequest.width > m_maxImageSize ||
+        outRequest.height > m_maxImageSize)
+    {
+        outError = "size must be between 1 and " + std::to_string(m_maxImageSize);
+        return false;
+    }
+
+    if (outRequest.frameCount == 0 || outRequest.frameCount > m_maxFrameCount)
+    {
+        outError = "frames must be between 1 and " + std::to_string(m_maxFrameCount);
+        return false;
+    }
+
+    // Only the scene built at init for now
+    if (outRequest.scene != "default")
+    {
+        outError = "unknown scene " + outRequest.scene;
+        return false;
+    }
+
+    if (!camera.empty())
+    {
+        const glm::vec3 eye(camera[0], camera[1], camera[2]);
+        const glm::vec3 target(camera[3], camera[4], camera[5]);
+        const float fieldOfView = camera.size() == 7 ? camera[6] : defaultFieldOfView;
+
+        if (eye == target || fieldOfView <= 0.f || fieldOfView >= 180.f)
+        {
+            outError = "invalid camera";
+            return false;
+        }
+
+        const float aspect = static_cast<float>(outRequest.width) / static_cast<float>(outRequest.height);
+        // Reverse-Z like every render pass: planes swapped, so the near plane maps to 1 and the far one to 0
+        glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(fieldOfView), aspect, farPlane, nearPlane);
+        // Vulkan clip space has Y pointing down
+        projection[1][1] *= -1.f;
+
+        outRequest.viewProj = projection * glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f));
+    }
+
+    return true;
+}
+
+void RenderServer::IoLoop()
+{
+#if !defined(_WIN32)
+    std::vector<pollfd> pollFds;
+    bool stopping = false;
+    std::chrono::steady_clock::time_point stopDeadline;
+
+    auto hasOutput = [](const Client& client) { return client.connection->HasOutput(); };
+
+    while (true)
+    {
+        if (!stopping && m_stop.load(std::memory_order_relaxed))
+        {
+            stopping = true;
+            stopDeadline = std::chrono::steady_clock::now() + stopFlushTimeout;
+        }
+
+        if (stopping && (std::chrono::steady_clock::now() >= stopDeadline ||
+                         std::none_of(m_clients.begin(), m_clients.end(), hasOutput)))
+            break;
+
+        // Negative sockets are ignored, a client only waiting for its jobs would be reported closed on each poll
+        pollFds.clear();
+        pollFds.push_back({stopping ? -1 : m_listenSocket, POLLIN, 0});
+        for (const Client& client : m_clients)
+        {
+            short events = 0;
+            if (client.receiving && !stopping)
+                events |= POLLIN;
+            if (client.connection->HasOutput())
+                events |= POLLOUT;
+
+            pollFds.push_back({events != 0 ? client.connection->GetSocket() : -1, events, 0});
+        }
+
+        poll(pollFds.data(), pollFds.size(), pollTimeoutMilliseconds);
+
+        // Clients first, accepting adds to the list
+        for (size_t i = m_clients.size(); i > 0; --i)
+        {
+            Client& client = m_clients[i - 1];
+            const short revents = pollFds[i].revents;
+
+            if (client.receiving && (revents & (POLLIN | POLLHUP | POLLERR)))
+                client.receiving = Receive(client);
+
+            // Replies completed by the workers while the socket was full are only queued, they are sent from here
+            if (client.connection->HasOutput())
+                client.connection->Flush();
+
+            // Once answered, jobs release the connection
+            const bool answered = !client.receiving && !client.connection->HasOutput() &&
+                                  client.connection.use_count() == 1;
+            if (client.connection->IsBroken() || answered)
+                m_clients.erase(m_clients.begin() + (i - 1));
+        }
+
+        if (pollFds[0].revents & POLLIN)
+            Accept();
+    }
+#endif
+}
+
+void RenderServer::Accept()
+{
+#if !defined(_WIN32)
+    int clientSocket = accept(m_listenSocket, nullptr, nullptr);
+    if (clientSocket < 0)
+    {
+        LOG_WARNING("Failed to accept a render server connection");
+        return;
+    }
+
+    // Workers send the replies, they must never wait for a slow client
+    if (fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK) != 0)
+    {
+        LOG_WARNING("Failed to make a render server connection non-blocking");
+        close(clientSocket);
+        return;
+    }
+
+    LOG_VERBOSE("Render server client connected");
+    m_clients.push_back(Client{std::make_shared<RenderConnection>(clientSocket)});
+#endif
+}
+
+bool RenderServer::Receive(Client& client)
+{
+#if defined(_WIN32)
+    return false;
+#else
+    char buffer[1024];
+    ssize_t received = recv(client.connection->GetSocket(), buffer, sizeof(buffer), 0);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return true;
+
+    // Closed by the client. Its pending jobs are still answered, if it only stopped sending.
+    if (received <= 0)
+    {
+        LOG_VERBOSE("Render server client stopped sending");
+        return false;
+    }
+
+    client.pending.append(buffer, static_cast<size_t>(received));
+
+    std::vector<RenderJob> jobs;
+    size_t lineEnd = 0;
+    while ((lineEnd = client.pending.find('\n')) != std::string::npos)
+    {
+        std::string line = client.pending.substr(0, lineEnd);
+        client.pending.erase(0, lineEnd + 1);
+
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (line.empty())
+            continue;
+
+        RenderJob job;
+        job.request.id = std::to_string(client.requestCount++);
+
+        std::string error;
+        if (!ParseRequest(line, job.request, error))
+        {
+            client.connection->SendError(job.request.id, error);
+            continue;
+        }
+
+        job.connection = client.connection;
+        jobs.push_back(std::move(job));
+    }
+
+    if (!jobs.empty())
+    {
+        {
+            std::lock_guard lock(m_jobsMutex);
+            for (RenderJob& job : jobs)
+                m_jobs.push_back(std::move(job));
+        }
+
+        m_jobsAvailable.notify_one();
+    }
+
+    // The requests before it are still answered
+    if (client.pending.size() > maxRequestSize)
+    {
+        client.connection->SendError(std::to_string(client.requestCount), "request too long");
+        return false;
+    }
+
+    return true;
+#endif
+}
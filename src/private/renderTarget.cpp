@@ -0,0 +1,314 @@
+#include <renderTarget.h>
+
+#include <attachment.h>
+#include <log.h>
+#include <utils/memory.h>
+
+#include <array>
+#include <vector>
+
+using VulkanRenderer::RenderTarget;
+using VulkanRenderer::RenderTargetConfig;
+using VulkanRenderer::SceneRenderPassDesc;
+
+namespace
+{
+constexpr VkDeviceSize bytesPerPixel = 4;
+} // namespace
+
+RenderTarget::RenderTarget(RenderTargetConfig& config)
+    : m_deviceCache(config.device)
+    , m_format(config.format)
+    , m_extent(config.extent)
+{
+    if (!CreateImage(config) || (config.readback && !CreateReadback(config)))
+        return;
+
+    VulkanRenderer::AttachmentConfig attachmentConfig;
+    attachmentConfig.device = m_deviceCache;
+    attachmentConfig.physicalDevice = config.physicalDevice;
+    attachmentConfig.extent = m_extent;
+    attachmentConfig.samples = config.samples;
+
+    attachmentConfig.format = config.depthFormat;
+    attachmentConfig.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    attachmentConfig.sampled = config.keepDepth;
+
+    m_depth = std::make_unique<VulkanRenderer::Attachment>(attachmentConfig);
+    if (!m_depth->IsValid())
+        return;
+
+    // Samples first, then the depth and the image they are resolved in, as in CreateRenderPass
+    std::array<VkImageView, 3> attachments = {m_imageView, m_depth->GetImageView(), VK_NULL_HANDLE};
+    uint32_t attachmentCount = 2;
+
+    if (config.samples != VK_SAMPLE_COUNT_1_BIT)
+    {
+        attachmentConfig.format = m_format;
+        attachmentConfig.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        attachmentConfig.sampled = false;
+
+        m_multisample = std::make_unique<VulkanRenderer::Attachment>(attachmentConfig);
+        if (!m_multisample->IsValid())
+            return;
+
+        attachments = {m_multisample->GetImageView(), m_depth->GetImageView(), m_imageView};
+        attachmentCount = 3;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = config.renderPass;
+    framebufferInfo.attachmentCount = attachmentCount;
+    framebufferInfo.pAttachments = attachments.data();
+    framebufferInfo.width = m_extent.width;
+    framebufferInfo.height = m_extent.height;
+    framebufferInfo.layers = 1;
+
+    if (vkCreateFramebuffer(m_deviceCache, &framebufferInfo, nullptr, &m_framebuffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the render target framebuffer");
+        m_framebuffer = VK_NULL_HANDLE;
+    }
+}
+
+RenderTarget::~RenderTarget()
+{
+    if (m_framebuffer != VK_NULL_HANDLE)
+        vkDestroyFramebuffer(m_deviceCache, m_framebuffer, nullptr);
+
+    m_multisample.reset();
+    m_depth.reset();
+
+    if (m_imageView != VK_NULL_HANDLE)
+        vkDestroyImageView(m_deviceCache, m_imageView, nullptr);
+
+    VulkanRenderer::Utils::DestroyImage(m_deviceCache, m_image, m_imageMemory);
+    VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, m_readbackBuffer, m_readbackMemory);
+}
+
+bool RenderTarget::CreateImage(RenderTargetConfig& config)
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = m_format;
+    imageInfo.extent = {m_extent.width, m_extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | config.usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (!VulkanRenderer::Utils::CreateImage(m_deviceCache, config.physicalDevice, imageInfo,
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_image, m_imageMemory))
+        return false;
+
+    VkImageViewCreateInfo imageViewCreateInfo{};
+    imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    imageViewCreateInfo.image = m_image;
+    imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    imageViewCreateInfo.format = m_format;
+    imageViewCreateInfo.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                                      VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    imageViewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    if (vkCreateImageView(m_deviceCache, &imageViewCreateInfo, nullptr, &m_imageView) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the render target image view");
+        m_imageView = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+bool RenderTarget::CreateReadback(RenderTargetConfig& config)
+{
+    const VkDeviceSize size = static_cast<VkDeviceSize>(m_extent.width) * m_extent.height * bytesPerPixel;
+
+    // Read by the CPU, cached memory makes a big difference there
+    if (!VulkanRenderer::Utils::CreateBuffer(
+            m_deviceCache, config.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_readbackBuffer,
+            m_readbackMemory, VK_MEMORY_PROPERTY_HOST_CACHED_BIT))
+    {
+        LOG_ERROR("Failed to create the render target readback buffer");
+        return false;
+    }
+
+    if (vkMapMemory(m_deviceCache, m_readbackMemory, 0, VK_WHOLE_SIZE, 0, &m_readbackMapped) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to map the render target readback buffer");
+        m_readbackMapped = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+VkImageView RenderTarget::GetDepthView() const { return m_depth ? m_depth->GetImageView() : VK_NULL_HANDLE; }
+
+std::vector<VkDeviceMemory> RenderTarget::GetMemories() const
+{
+    std::vector<VkDeviceMemory> memories = {m_imageMemory, m_readbackMemory};
+    if (m_depth)
+        memories.push_back(m_depth->GetMemory());
+
+    if (m_multisample)
+        memories.push_back(m_multisample->GetMemory());
+
+    return memories;
+}
+
+VkRenderPass RenderTarget::CreateRenderPass(VkDevice device, const SceneRenderPassDesc& desc,
+                                            VkImageLayout finalLayout, bool keepDepth)
+{
+    const bool multisampled = desc.samples != VK_SAMPLE_COUNT_1_BIT;
+
+    // The rendered attachment, the depth, then the resolved one when multisampled
+    std::array<VkAttachmentDescription, 3> attachments{};
+    attachments[0].format = desc.colorFormat;
+    attachments[0].samples = desc.samples;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = multisampled ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : finalLayout;
+
+    attachments[1] = attachments[0];
+    attachments[1].format = desc.depthFormat;
+    attachments[1].storeOp = keepDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].finalLayout = keepDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                           : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    attachments[2] = attachments[0];
+    attachments[2].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[2].finalLayout = finalLayout;
+
+    VkAttachmentReference colorAttachmentRef{};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthAttachmentRef{};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // After the prepass, the color subpass only tests the depth
+    VkAttachmentReference depthReadAttachmentRef{};
+    depthReadAttachmentRef.attachment = 1;
+    depthReadAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    VkAttachmentReference resolveAttachmentRef{};
+    resolveAttachmentRef.attachment = 2;
+    resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    std::array<VkSubpassDescription, 2> subpasses{};
+    VkSubpassDescription& depthSubpass = subpasses[0];
+    depthSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    depthSubpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    const uint32_t colorSubpassIndex = desc.depthPrepass ? 1 : 0;
+    VkSubpassDescription& colorSubpass = subpasses[colorSubpassIndex];
+    colorSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    colorSubpass.colorAttachmentCount = 1;
+    colorSubpass.pColorAttachments = &colorAttachmentRef;
+    colorSubpass.pResolveAttachments = multisampled ? &resolveAttachmentRef : nullptr;
+    colorSubpass.pDepthStencilAttachment = desc.depthPrepass ? &depthReadAttachmentRef : &depthAttachmentRef;
+
+    constexpr VkPipelineStageFlags depthStages =
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+    // Previous reads of the images are done before writing them again, and the writes are done before the images
+    // are read, either copied or sampled by a graphic or compute shader.
+    // The depth is the same image from a frame to the next, its previous writes are done too.
+    std::vector<VkSubpassDependency> dependencies;
+    dependencies.reserve(4);
+
+    VkSubpassDependency& begin = dependencies.emplace_back();
+    begin.srcSubpass = VK_SUBPASS_EXTERNAL;
+    begin.dstSubpass = 0;
+    begin.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT |
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | depthStages;
+    begin.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    begin.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | depthStages;
+    begin.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    if (desc.depthPrepass)
+    {
+        // The color is first used by the second subpass
+        VkSubpassDependency& colorBegin = dependencies.emplace_back(begin);
+        colorBegin.dstSubpass = colorSubpassIndex;
+
+        VkSubpassDependency& prepass = dependencies.emplace_back();
+        prepass.srcSubpass = 0;
+        prepass.dstSubpass = colorSubpassIndex;
+        prepass.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        prepass.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        prepass.dstStageMask = depthStages;
+        prepass.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        prepass.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    }
+
+    VkSubpassDependency& end = dependencies.emplace_back();
+    end.srcSubpass = colorSubpassIndex;
+    end.dstSubpass = VK_SUBPASS_EXTERNAL;
+    end.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    end.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    end.dstStageMask =
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    end.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = multisampled ? 3 : 2;
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = desc.depthPrepass ? 2 : 1;
+    renderPassInfo.pSubpasses = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create the render target render pass");
+        return VK_NULL_HANDLE;
+    }
+
+    return renderPass;
+}
+
+void RenderTarget::RecordReadback(VkCommandBuffer commandBuffer) const
+{
+    if (m_readbackBuffer == VK_NULL_HANDLE)
+        return;
+
+    // Rows tightly packed
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {m_extent.width, m_extent.height, 1};
+
+    vkCmdCopyImageToBuffer(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_readbackBuffer, 1,
+                           &region);
+
+    // Visible to the host once the submission fence is signaled
+    VkBufferMemoryBarrier toHost{};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = m_readbackBuffer;
+    toHost.offset = 0;
+    toHost.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr,
+                         1, &toHost, 0, nullptr);
+}
@@ -0,0 +1,178 @@
+#include <scene.h>
+
+#include <jobSystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using VulkanRenderer::EntityId;
+using VulkanRenderer::Scene;
+
+namespace
+{
+// Below this, a level is not worth spreading over threads
+constexpr size_t minNodesPerTask = 1024;
+
+constexpr uint32_t invalidInstance = ~0u;
+} // namespace
+
+Scene::Scene(JobSystem& jobSystem)
+    : m_jobSystem(jobSystem)
+{
+}
+
+void Scene::Reserve(size_t nodeCount)
+{
+    m_parents.reserve(nodeCount);
+    m_levelIndices.reserve(nodeCount);
+    m_localTransforms.reserve(nodeCount);
+    m_worldTransforms.reserve(nodeCount);
+    m_localBounds.reserve(nodeCount);
+    m_dirty.reserve(nodeCount);
+    m_changedAt.reserve(nodeCount);
+    m_instanceIndices.reserve(nodeCount);
+}
+
+EntityId Scene::CreateNode(EntityId parent)
+{
+    const EntityId entity = static_cast<EntityId>(m_parents.size());
+    const uint32_t level = parent == invalidEntity ? 0 : m_levelIndices[parent] + 1;
+
+    m_parents.push_back(parent);
+    m_levelIndices.push_back(level);
+    m_localTransforms.push_back(glm::mat4(1.f));
+    m_worldTransforms.push_back(glm::mat4(1.f));
+    m_localBounds.push_back(Bounds{});
+    m_dirty.push_back(0);
+    m_changedAt.push_back(0);
+    m_instanceIndices.push_back(invalidInstance);
+
+    if (level >= m_levels.size())
+    {
+        m_levels.resize(level + 1);
+        m_dirtyLevels.resize(level + 1, 0);
+    }
+
+    m_levels[level].push_back(entity);
+
+    // The world transform depends on the parent one
+    MarkDirty(entity);
+    return entity;
+}
+
+void Scene::MarkDirty(EntityId entity)
+{
+    m_dirty[entity] = 1;
+    m_dirtyLevels[m_levelIndices[entity]] = 1;
+}
+
+void Scene::SetLocalTransform(EntityId entity, const glm::mat4& transform)
+{
+    m_localTransforms[entity] = transform;
+    MarkDirty(entity);
+}
+
+void Scene::SetBounds(EntityId entity, const Bounds& bounds)
+{
+    m_localBounds[entity] = bounds;
+    MarkDirty(entity);
+}
+
+void Scene::SetRenderComponent(EntityId entity, const RenderComponent& component)
+{
+    uint32_t& instanceIndex = m_instanceIndices[entity];
+    if (instanceIndex == invalidInstance)
+    {
+        instanceIndex = static_cast<uint32_t>(m_instances.size());
+        m_instances.emplace_back();
+        m_renderComponents.emplace_back();
+    }
+
+    m_renderComponents[instanceIndex] = component;
+    MarkDirty(entity);
+}
+
+void Scene::Update()
+{
+    ++m_updateIndex;
+
+    std::atomic<size_t> updatedCount = 0;
+    bool previousLevelChanged = false;
+
+    for (size_t level = 0; level < m_levels.size(); ++level)
+    {
+        // Nothing to do if no node of this level is dirty, and no parent moved
+        if (!m_dirtyLevels[level] && !previousLevelChanged)
+            continue;
+
+        m_dirtyLevels[level] = 0;
+
+        const std::vector<EntityId>& nodes = m_levels[level];
+        std::atomic<bool> levelChanged = false;
+
+        auto updateRange = [&](size_t begin, size_t end)
+        {
+            size_t localCount = 0;
+            for (size_t i = begin; i < end; ++i)
+            {
+                EntityId entity = nodes[i];
+                EntityId parent = m_parents[entity];
+
+                // Parents are in the previous level, already done
+                bool parentChanged = parent != invalidEntity && m_changedAt[parent] == m_updateIndex;
+                if (!m_dirty[entity] && !parentChanged)
+                    continue;
+
+                UpdateNode(entity);
+                ++localCount;
+            }
+
+            if (localCount > 0)
+            {
+                updatedCount += localCount;
+                levelChanged = true;
+            }
+        };
+
+        m_jobSystem.ParallelFor(nodes.size(), minNodesPerTask, updateRange);
+
+        previousLevelChanged = levelChanged;
+    }
+
+    m_lastUpdatedCount = updatedCount;
+}
+
+void Scene::UpdateNode(EntityId entity)
+{
+    EntityId parent = m_parents[entity];
+
+    m_worldTransforms[entity] = parent == invalidEntity
+                                    ? m_localTransforms[entity]
+                                    : m_worldTransforms[parent] * m_localTransforms[entity];
+    m_dirty[entity] = 0;
+    m_changedAt[entity] = m_updateIndex;
+
+    if (m_instanceIndices[entity] != invalidInstance)
+        WriteInstance(entity);
+}
+
+void Scene::WriteInstance(EntityId entity)
+{
+    const uint32_t instanceIndex = m_instanceIndices[entity];
+    const glm::mat4& world = m_worldTransforms[entity];
+    const Bounds& bounds = m_localBounds[entity];
+    const RenderComponent& component = m_renderComponents[instanceIndex];
+
+    // Sphere stays a sphere: scale the radius by the biggest axis scale
+    float maxScale = std::max({glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                               glm::length(glm::vec3(world[2]))});
+
+    InstanceData& instance = m_instances[instanceIndex];
+    instance.model = world;
+    instance.boundingSphere = glm::vec4(glm::vec3(world * glm::vec4(bounds.center, 1.f)), bounds.radius * maxScale);
+    instance.mesh = component.mesh;
+    instance.material = component.material;
+    instance.features = component.features;
+    instance.entity = entity;
+}
@@ -1,12 +1,12 @@
 #include <shader.h>
 
-#include <config.h>
+#include <log.h>
+#include <utils/file.h>
 
 #include <vulkan/vulkan.h>
 
-#include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <functional>
+#include <string_view>
 
 using VulkanRenderer::Shader;
 
@@ -14,6 +14,7 @@ Shader::Shader(VkDevice_T* device, ShaderType type, const std::vector<char>& byt
     : m_deviceCache(device)
     , m_module(VK_NULL_HANDLE)
     , m_type(type)
+    , m_codeHash(std::hash<std::string_view>{}(std::string_view(byteCode.data(), byteCode.size())))
 {
     VkShaderModuleCreateInfo shaderCreateInfo{};
     shaderCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -22,7 +23,7 @@ Shader::Shader(VkDevice_T* device, ShaderType type, const std::vector<char>& byt
 
     if (vkCreateShaderModule(m_deviceCache, &shaderCreateInfo, nullptr, &m_module) != VK_SUCCESS)
     {
-        std::cout << "Failed to create the shader module!" << std::endl;
+        LOG_ERROR("Failed to create the shader module!");
         m_module = VK_NULL_HANDLE;
     }
 }
@@ -33,44 +34,30 @@ bool Shader::IsValid() const { return m_module != VK_NULL_HANDLE; }
 
 std::unique_ptr<Shader> Shader::CreateFromFile(VkDevice_T* device, ShaderType type, const char* filePath)
 {
-    if (!std::filesystem::exists(filePath))
+    std::vector<char> byteCode;
+    if (!VulkanRenderer::Utils::ReadFile(filePath, byteCode))
     {
-        // Try to look next to the executable also
-        std::filesystem::path execPath =
-            std::filesystem::path(VulkanRenderer::VulkanParameters::GetInstance().execPath).parent_path();
-
-        execPath /= filePath;
-
-        if (!std::filesystem::exists(execPath))
-        {
-            std::cout << "File " << filePath << " was not found." << std::endl;
-            return nullptr;
-        }
-    }
-
-    std::ifstream fileStream;
-    fileStream.open(filePath, std::ios::binary | std::ios::ate);
-
-    if (!fileStream.is_open())
-    {
-        std::cout << "Failed to open file " << filePath << std::endl;
+        LOG_ERROR("File ", filePath, " was not found.");
         return nullptr;
     }
 
-    size_t fileSize = (size_t)fileStream.tellg();
-    std::vector<char> byteCode(fileSize);
-    fileStream.seekg(0);
-    fileStream.read(byteCode.data(), fileSize);
-
-    fileStream.close();
-
     std::unique_ptr<Shader> res = std::make_unique<Shader>(device, type, byteCode);
 
     if (!res->IsValid())
     {
-        std::cout << "Error while create shader module from file " << filePath << std::endl;
+        LOG_ERROR("Error while create shader module from file ", filePath);
         return nullptr;
     }
 
     return res;
+}
+
+std::unique_ptr<Shader> Shader::Create(VkDevice_T* device, ShaderType type, const std::vector<char>* byteCode,
+                                       const char* filePath)
+{
+    if (!byteCode)
+        return CreateFromFile(device, type, filePath);
+
+    std::unique_ptr<Shader> res = std::make_unique<Shader>(device, type, *byteCode);
+    return res->IsValid() ? std::move(res) : nullptr;
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include <shaderPermutation.h>
+
+using VulkanRenderer::ShaderFeatureMask;
+using VulkanRenderer::ShaderSpecialization;
+
+ShaderSpecialization::ShaderSpecialization(ShaderFeatureMask features)
+{
+    for (uint32_t i = 0; i < featureCount; ++i)
+    {
+        m_values[i] = (features & (ShaderFeatureMask(1) << i)) ? VK_TRUE : VK_FALSE;
+
+        m_entries[i].constantID = i;
+        m_entries[i].offset = i * sizeof(VkBool32);
+        m_entries[i].size = sizeof(VkBool32);
+    }
+
+    m_info.mapEntryCount = featureCount;
+    m_info.pMapEntries = m_entries.data();
+    m_info.dataSize = sizeof(m_values);
+    m_info.pData = m_values.data();
+}
@@ -0,0 +1,321 @@
+#include <shaderReloader.h>
+
+#include <log.h>
+#include <profiler.h>
+#include <utils/file.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using VulkanRenderer::ShaderReloader;
+using VulkanRenderer::ShaderReloaderConfig;
+
+namespace
+{
+// FNV-1a, stable from one run to the other unlike std::hash
+constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t fnvPrime = 0x100000001b3ull;
+
+uint64_t HashBytes(const std::string& bytes, uint64_t hash)
+{
+    for (char c : bytes)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= fnvPrime;
+    }
+
+    return hash;
+}
+
+// Files included by the shaders, a change may concern any of them
+bool IsIncludeFile(const std::string& fileName) { return std::filesystem::path(fileName).extension() == ".glsl"; }
+
+// Name of the file included by the line, empty if it doesn't include anything
+std::string GetIncludedFile(const std::string& line)
+{
+    const size_t directive = line.find_first_not_of(" \t");
+    if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+        return {};
+
+    const size_t begin = line.find('"', directive);
+    const size_t end = begin == std::string::npos ? begin : line.find('"', begin + 1);
+    if (end == std::string::npos)
+        return {};
+
+    return line.substr(begin + 1, end - begin - 1);
+}
+} // namespace
+
+ShaderReloader::ShaderReloader(ShaderReloaderConfig& config)
+    : m_sourceFolder(config.sourceFolder)
+    , m_cacheFolder(config.cacheFolder)
+    , m_compiler(config.compiler)
+    , m_shaders(config.shaders)
+{
+#if defined(__linux__)
+    std::error_code error;
+    if (!std::filesystem::create_directories(m_cacheFolder, error) && error)
+    {
+        LOG_ERROR("Failed to create shader cache folder ", m_cacheFolder, ": ", error.message());
+        return;
+    }
+
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0)
+    {
+        LOG_ERROR("Failed to create the shader watcher: ", std::strerror(errno));
+        return;
+    }
+
+    // Editors either write the file in place, or write another one and move it over
+    m_watch = inotify_add_watch(m_inotify, m_sourceFolder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (m_watch < 0)
+    {
+        LOG_ERROR("Failed to watch shader folder ", m_sourceFolder, ": ", std::strerror(errno));
+        return;
+    }
+
+    m_compileThread = std::thread(&ShaderReloader::CompileLoop, this);
+    LOG_INFO("Watching the shaders in ", m_sourceFolder);
+#else
+    LOG_ERROR("Shader hot reload needs inotify, not available on this platform");
+#endif
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    {
+        std::lock_guard lock(m_requestsMutex);
+        m_stop = true;
+    }
+
+    m_requestsAvailable.notify_one();
+    if (m_compileThread.joinable())
+        m_compileThread.join();
+
+#if defined(__linux__)
+    if (m_inotify >= 0)
+        close(m_inotify);
+#endif
+}
+
+void ShaderReloader::Poll()
+{
+#if defined(__linux__)
+    if (m_watch < 0)
+        return;
+
+    // Saving a file usually sends a few events, they all end up in a single compilation
+    std::vector<std::string> changedFiles;
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0)
+                changedFiles.emplace_back(event->name);
+
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+
+    if (changedFiles.empty())
+        return;
+
+    const bool includeChanged = std::any_of(changedFiles.begin(), changedFiles.end(), IsIncludeFile);
+    for (const std::string& name : m_shaders)
+    {
+        if (!includeChanged && std::find(changedFiles.begin(), changedFiles.end(), name) == changedFiles.end())
+            continue;
+
+        uint64_t generation = 0;
+        {
+            std::lock_guard lock(m_compiledMutex);
+            generation = ++m_generations[name];
+        }
+
+        // Not compiled yet, the older version would be dropped anyway
+        std::lock_guard lock(m_requestsMutex);
+        auto queued = std::find_if(m_requests.begin(), m_requests.end(),
+                                   [&name](const Request& request) { return request.name == name; });
+        if (queued != m_requests.end())
+            queued->generation = generation;
+        else
+            m_requests.push_back({name, generation});
+    }
+
+    m_requestsAvailable.notify_one();
+#endif
+}
+
+void ShaderReloader::CompileLoop()
+{
+    PROFILE_THREAD_NAME("Shader compiler");
+
+    std::unique_lock lock(m_requestsMutex);
+    while (true)
+    {
+        m_requestsAvailable.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+        if (m_stop)
+            return;
+
+        Request request = std::move(m_requests.front());
+        m_requests.pop_front();
+
+        lock.unlock();
+        Compile(request.name, request.generation);
+        lock.lock();
+    }
+}
+
+std::vector<ShaderReloader::CompiledShader> ShaderReloader::TakeCompiled()
+{
+    std::lock_guard lock(m_compiledMutex);
+    return std::exchange(m_compiled, {});
+}
+
+void ShaderReloader::Compile(const std::string& name, uint64_t generation)
+{
+    PROFILE_FUNCTION();
+
+    // A shader including a file which didn't change gets the same hash, and is found in the cache
+    uint64_t hash = fnvOffsetBasis;
+    std::unordered_set<std::string> visited;
+    if (!HashSource(name, hash, visited))
+        return;
+
+    std::ostringstream cacheName;
+    cacheName << name << '.' << std::hex << hash << ".spv";
+    const std::filesystem::path cachePath = std::filesystem::path(m_cacheFolder) / cacheName.str();
+
+    CompiledShader compiled{name, {}};
+    if (VulkanRenderer::Utils::ReadFile(cachePath.string().c_str(), compiled.code))
+    {
+        LOG_VERBOSE("Shader ", name, " found in the cache");
+    }
+    else
+    {
+        // Unique per compilation, two runs may compile the same source
+        std::filesystem::path tempPath = cachePath;
+        tempPath += "." + std::to_string(generation) + ".tmp";
+
+        const std::filesystem::path sourcePath = std::filesystem::path(m_sourceFolder) / name;
+        if (!RunCompiler(sourcePath.string(), tempPath.string()))
+            return;
+
+        if (!VulkanRenderer::Utils::ReadFile(tempPath.string().c_str(), compiled.code))
+        {
+            LOG_ERROR("Failed to read the compiled shader ", tempPath);
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+            LOG_WARNING("Failed to cache the compiled shader ", cachePath, ": ", error.message());
+
+        LOG_INFO("Compiled shader ", name);
+    }
+
+    std::lock_guard lock(m_compiledMutex);
+
+    // The source changed again meanwhile, the newer compilation gives the result
+    if (m_generations[name] != generation)
+        return;
+
+    auto previous = std::find_if(m_compiled.begin(), m_compiled.end(),
+                                 [&name](const CompiledShader& shader) { return shader.name == name; });
+    if (previous != m_compiled.end())
+        *previous = std::move(compiled);
+    else
+        m_compiled.push_back(std::move(compiled));
+}
+
+bool ShaderReloader::ReadSource(const std::string& fileName, std::string& outSource) const
+{
+    std::ifstream file(std::filesystem::path(m_sourceFolder) / fileName, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    std::ostringstream source;
+    source << file.rdbuf();
+    outSource = source.str();
+    return true;
+}
+
+bool ShaderReloader::HashSource(const std::string& fileName, uint64_t& hash,
+                                std::unordered_set<std::string>& visited) const
+{
+    if (!visited.insert(fileName).second)
+        return true;
+
+    std::string source;
+    if (!ReadSource(fileName, source))
+    {
+        LOG_ERROR("Failed to read shader source ", fileName, " in ", m_sourceFolder);
+        return false;
+    }
+
+    hash = HashBytes(fileName, hash);
+    hash = HashBytes(source, hash);
+
+    // Includes are looked for in the source folder, like the build does
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const std::string included = GetIncludedFile(line);
+        if (!included.empty() && !HashSource(included, hash, visited))
+            return false;
+    }
+
+    return true;
+}
+
+bool ShaderReloader::RunCompiler(const std::string& sourcePath, const std::string& outputPath) const
+{
+#if defined(__linux__)
+    const std::string command = "\"" + m_compiler + "\" \"" + sourcePath + "\" -o \"" + outputPath + "\" 2>&1";
+
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe)
+    {
+        LOG_ERROR("Failed to run the shader compiler ", m_compiler);
+        return false;
+    }
+
+    std::string output;
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), pipe))
+        output += buffer;
+
+    if (pclose(pipe) != 0)
+    {
+        LOG_ERROR("Failed to compile shader ", sourcePath, ":\n", output);
+        return false;
+    }
+
+    if (!output.empty())
+        LOG_WARNING(output);
+
+    return true;
+#else
+    return false;
+#endif
+}
@@ -1,23 +1,26 @@
 #include <swapChain.h>
 
+#include <log.h>
 #include <utils/queueFamily.h>
 
 #include <GLFW/glfw3.h>
 
 #include <algorithm>
 #include <cstdint>
-#include <iostream>
 #include <limits>
 
+using VulkanRenderer::QueueFamilyIndices;
 using VulkanRenderer::SwapChain;
 using VulkanRenderer::SwapChainSupportDetails;
 
 SwapChain::SwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, GLFWwindow* window,
+                     const QueueFamilyIndices& queueFamilies, const SwapChainSupportDetails& supportDetails,
                      SwapChain* oldSwapChain)
     : m_deviceCache(device)
 {
-    SwapChainSupportDetails swapChainSupport;
-    FillSwapChainSupportDetails(physicalDevice, surface, swapChainSupport);
+    // Extent changes with the window size, so the capabilities can't be cached
+    SwapChainSupportDetails swapChainSupport = supportDetails;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &swapChainSupport.capabilities);
 
     // Add some logic to select some settings on the swap chain
     SelectSwapSurfaceFormat(swapChainSupport);
@@ -41,10 +44,19 @@ SwapChain::SwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurface
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    VulkanRenderer::QueueFamilyIndices indices = VulkanRenderer::FindQueueFamilies(physicalDevice, surface);
-    uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    // Lets the frame capture copy the images, when the surface allows it
+    if (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
-    if (indices.graphicsFamily != indices.presentFamily)
+    // And the post-processing blit its result into them
+    if (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    m_imageUsage = createInfo.imageUsage;
+
+    uint32_t queueFamilyIndices[] = {queueFamilies.graphicsFamily.value(), queueFamilies.presentFamily.value()};
+
+    if (queueFamilies.graphicsFamily != queueFamilies.presentFamily)
     {
         createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
         createInfo.queueFamilyIndexCount = 2;
@@ -67,7 +79,7 @@ SwapChain::SwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurface
 
     if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &m_swapChain) != VK_SUCCESS)
     {
-        std::cout << "Failed to create swap chain!" << std::endl;
+        LOG_ERROR("Failed to create swap chain!");
         m_swapChain = VK_NULL_HANDLE;
         return;
     }
@@ -114,7 +126,7 @@ void SwapChain::InitImages(uint32_t imageCount)
 
         if (vkCreateImageView(m_deviceCache, &imageViewCreateInfo, nullptr, &m_imageViews[i]) != VK_SUCCESS)
         {
-            std::cout << "Failed to create image view number " << i << std::endl;
+            LOG_ERROR("Failed to create image view number ", i);
             m_imageViews.resize(0);
             return;
         }
@@ -0,0 +1,160 @@
+#include <uniformRing.h>
+
+#include <descriptorAllocator.h>
+#include <log.h>
+#include <utils/memory.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using VulkanRenderer::RingAllocation;
+using VulkanRenderer::UniformRing;
+using VulkanRenderer::UniformRingConfig;
+
+UniformRing::UniformRing(UniformRingConfig& config)
+    : m_deviceCache(config.device)
+    , m_descriptorAllocator(config.descriptorAllocator)
+    , m_framesInFlight(std::max(config.framesInFlight, 1u))
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(config.physicalDevice, &properties);
+
+    // Every offset needs to be valid both as a dynamic uniform and storage offset
+    m_alignment = std::max(properties.limits.minUniformBufferOffsetAlignment,
+                           properties.limits.minStorageBufferOffsetAlignment);
+    m_alignment = std::max<VkDeviceSize>(m_alignment, 1);
+
+    m_bindingRange = std::min<VkDeviceSize>(config.bindingRange, properties.limits.maxUniformBufferRange);
+    m_sizePerFrame = VulkanRenderer::Utils::AlignUp(config.sizePerFrame, m_alignment);
+
+    // The binding range is added at the end, so the last allocation of the last frame
+    // can still expose a full range to the shaders.
+    VkDeviceSize totalSize = m_sizePerFrame * m_framesInFlight + m_bindingRange;
+
+    // Host visible and coherent so writes are a simple memcpy, device local if the device
+    // exposes such memory (resizable BAR, integrated GPUs).
+    if (!VulkanRenderer::Utils::CreateBuffer(
+            m_deviceCache, config.physicalDevice, totalSize,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffer, m_memory,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+    {
+        LOG_ERROR("Failed to create the uniform ring buffer");
+        return;
+    }
+
+    // Mapped once, for the lifetime of the ring
+    void* mapped = nullptr;
+    if (vkMapMemory(m_deviceCache, m_memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to map the uniform ring buffer");
+        return;
+    }
+
+    m_mapped = static_cast<uint8_t*>(mapped);
+
+    CreateLayout(*config.layoutCache);
+    BeginFrame(0);
+}
+
+UniformRing::~UniformRing()
+{
+    if (m_mapped != nullptr)
+        vkUnmapMemory(m_deviceCache, m_memory);
+
+    VulkanRenderer::Utils::DestroyBuffer(m_deviceCache, m_buffer, m_memory);
+}
+
+void UniformRing::CreateLayout(DescriptorLayoutCache& layoutCache)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    m_layout = layoutCache.GetLayout(bindings);
+    if (m_layout == VK_NULL_HANDLE)
+        LOG_ERROR("Failed to create the uniform ring descriptor set layout");
+}
+
+void UniformRing::AllocateDescriptorSet()
+{
+    // Same buffer and range every frame, only the dynamic offsets change
+    m_descriptorSet = m_layout != VK_NULL_HANDLE ? m_descriptorAllocator->Allocate(m_layout) : VK_NULL_HANDLE;
+    if (m_descriptorSet == VK_NULL_HANDLE)
+    {
+        LOG_ERROR("Failed to allocate the uniform ring descriptor set");
+        return;
+    }
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = m_buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = m_bindingRange;
+
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = m_descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType =
+            i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        writes[i].pBufferInfo = &bufferInfo;
+    }
+
+    vkUpdateDescriptorSets(m_deviceCache, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+bool UniformRing::IsValid() const
+{
+    return m_mapped != nullptr && m_descriptorSet != VK_NULL_HANDLE;
+}
+
+void UniformRing::BeginFrame(uint32_t frameIndex)
+{
+    m_frameBegin = m_sizePerFrame * (frameIndex % m_framesInFlight);
+    m_frameEnd = m_frameBegin + m_sizePerFrame;
+    m_head = m_frameBegin;
+
+    AllocateDescriptorSet();
+}
+
+RingAllocation UniformRing::Allocate(VkDeviceSize size)
+{
+    RingAllocation allocation;
+    if (m_descriptorSet == VK_NULL_HANDLE)
+        return allocation;
+
+    VkDeviceSize offset = VulkanRenderer::Utils::AlignUp(m_head, m_alignment);
+    if (offset + size > m_frameEnd)
+    {
+        LOG_ERROR("Uniform ring is full for this frame");
+        return allocation;
+    }
+
+    m_head = offset + size;
+
+    allocation.data = m_mapped + offset;
+    allocation.offset = static_cast<uint32_t>(offset);
+    allocation.size = size;
+    return allocation;
+}
+
+void UniformRing::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+                       uint32_t setIndex, uint32_t uniformOffset, uint32_t storageOffset) const
+{
+    // One dynamic offset per dynamic binding, in binding order
+    std::array<uint32_t, 2> dynamicOffsets = {uniformOffset, storageOffset};
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setIndex, 1, &m_descriptorSet,
+                            static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <swapChain.h>
+#include <utils/queueFamily.h>
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+
+namespace VulkanRenderer
+{
+// Everything we need to know about a physical device, queried once when probing the devices.
+// Surface capabilities are the exception: the current extent changes with the window, so the swap chain
+// queries them again when it is created.
+struct PhysicalDeviceInfo
+{
+    VkPhysicalDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties{};
+    VkPhysicalDeviceFeatures features{};
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    // Same for the same device across runs, unlike the enumeration order
+    std::array<uint8_t, VK_UUID_SIZE> uuid{};
+    QueueFamilyIndices queueFamilies;
+    SwapChainSupportDetails swapChainSupport{};
+    bool extensionsSupported = false;
+    bool bindlessSupported = false;
+    bool memoryBudgetSupported = false;
+    bool pipelineLibrarySupported = false;
+
+    bool IsSuitable() const
+    {
+        return queueFamilies.IsComplete() && extensionsSupported && !swapChainSupport.formats.empty() &&
+               !swapChainSupport.presentModes.empty();
+    }
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,112 @@
+#include <utils/deviceScore.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// The type outweighs everything else: any discrete GPU beats any integrated one, which beats a CPU implementation
+float GetTypeScore(VkPhysicalDeviceType deviceType)
+{
+    switch (deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return 10000.0f;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return 5000.0f;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return 2000.0f;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return 0.0f;
+    default:
+        return 1000.0f;
+    }
+}
+
+// Integrated GPUs report a share of the system memory, only the memory of discrete ones says much
+float GetMemoryScore(const VulkanRenderer::PhysicalDeviceInfo& info)
+{
+    constexpr float bytesPerGiB = 1024.0f * 1024.0f * 1024.0f;
+    const float gibibytes =
+        static_cast<float>(VulkanRenderer::Utils::GetDeviceLocalMemorySize(info.memoryProperties)) / bytesPerGiB;
+
+    // Doubling the memory counts the same at every size, up to 64 GiB
+    const float score = 400.0f * std::log2(1.0f + std::min(gibibytes, 64.0f));
+    return info.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? score : score * 0.25f;
+}
+
+float GetQueueScore(const VulkanRenderer::QueueFamilyIndices& queueFamilies)
+{
+    float score = 0.0f;
+
+    // The particle update runs alongside the graphics work
+    if (queueFamilies.asyncComputeFamily.has_value())
+        score += 300.0f;
+
+    // Presenting from another family needs the swap chain images shared between the queues
+    if (queueFamilies.graphicsFamily == queueFamilies.presentFamily)
+        score += 100.0f;
+
+    return score;
+}
+
+float GetFeatureScore(const VulkanRenderer::PhysicalDeviceInfo& info)
+{
+    float score = 0.0f;
+
+    // What the renderer takes a faster path with when available
+    if (info.bindlessSupported)
+        score += 200.0f;
+    if (info.pipelineLibrarySupported)
+        score += 100.0f;
+    if (info.memoryBudgetSupported)
+        score += 50.0f;
+    if (info.features.multiDrawIndirect)
+        score += 100.0f;
+    if (info.features.drawIndirectFirstInstance)
+        score += 50.0f;
+    if (info.features.samplerAnisotropy)
+        score += 25.0f;
+    if (info.features.textureCompressionBC || info.features.textureCompressionASTC_LDR)
+        score += 25.0f;
+
+    return score;
+}
+
+// Limits grow with the hardware generation, a rough tie breaker between devices of the same type
+float GetLimitScore(const VkPhysicalDeviceLimits& limits)
+{
+    float score = 0.0f;
+
+    score += static_cast<float>(std::min(limits.maxImageDimension2D, 32768u)) / 32768.0f * 100.0f;
+    score += static_cast<float>(std::min(limits.maxComputeWorkGroupInvocations, 2048u)) / 2048.0f * 100.0f;
+    score += static_cast<float>(std::min(limits.maxComputeSharedMemorySize, 65536u)) / 65536.0f * 100.0f;
+
+    if (limits.framebufferColorSampleCounts & VK_SAMPLE_COUNT_8_BIT)
+        score += 50.0f;
+
+    // Frame times are measured with timestamps on the graphics queue
+    if (limits.timestampComputeAndGraphics)
+        score += 50.0f;
+
+    return score;
+}
+} // namespace
+
+VkDeviceSize VulkanRenderer::Utils::GetDeviceLocalMemorySize(const VkPhysicalDeviceMemoryProperties& memoryProperties)
+{
+    VkDeviceSize size = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            size = std::max(size, memoryProperties.memoryHeaps[i].size);
+    }
+
+    return size;
+}
+
+float VulkanRenderer::Utils::ScorePhysicalDevice(const PhysicalDeviceInfo& info)
+{
+    return GetTypeScore(info.properties.deviceType) + GetMemoryScore(info) + GetQueueScore(info.queueFamilies) +
+           GetFeatureScore(info) + GetLimitScore(info.properties.limits);
+}
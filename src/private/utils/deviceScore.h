@@ -0,0 +1,18 @@
+#pragma once
+
+#include <utils/deviceInfo.h>
+
+#include <vulkan/vulkan.h>
+
+namespace VulkanRenderer
+{
+namespace Utils
+{
+// Size of the largest device local heap, the video memory of a discrete GPU
+VkDeviceSize GetDeviceLocalMemorySize(const VkPhysicalDeviceMemoryProperties& memoryProperties);
+
+// Estimate of how fast the device runs the renderer, from what it reports: its type first, then its video memory,
+// queues, optional features and limits. Only meaningful to compare devices with each other.
+float ScorePhysicalDevice(const PhysicalDeviceInfo& info);
+} // namespace Utils
+} // namespace VulkanRenderer
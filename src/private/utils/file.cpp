@@ -0,0 +1,49 @@
+#include <utils/file.h>
+
+#include <config.h>
+#include <log.h>
+
+#include <filesystem>
+#include <fstream>
+
+bool VulkanRenderer::Utils::ReadFile(const char* filePath, std::vector<char>& outData)
+{
+    std::filesystem::path path(filePath);
+
+    if (!std::filesystem::exists(path))
+    {
+        // Try to look next to the executable also
+        path = std::filesystem::path(VulkanRenderer::VulkanParameters::GetInstance().execPath).parent_path();
+        path /= filePath;
+
+        if (!std::filesystem::exists(path))
+            return false;
+    }
+
+    std::ifstream fileStream(path, std::ios::binary | std::ios::ate);
+    if (!fileStream.is_open())
+    {
+        LOG_ERROR("Failed to open file ", filePath);
+        return false;
+    }
+
+    size_t fileSize = (size_t)fileStream.tellg();
+    outData.resize(fileSize);
+    fileStream.seekg(0);
+    fileStream.read(outData.data(), fileSize);
+
+    return fileStream.good();
+}
+
+bool VulkanRenderer::Utils::WriteFile(const char* filePath, const void* data, size_t size)
+{
+    std::ofstream fileStream(filePath, std::ios::binary | std::ios::trunc);
+    if (!fileStream.is_open())
+    {
+        LOG_ERROR("Failed to open file ", filePath, " for writing");
+        return false;
+    }
+
+    fileStream.write(static_cast<const char*>(data), size);
+    return fileStream.good();
+}
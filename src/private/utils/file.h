@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace VulkanRenderer
+{
+namespace Utils
+{
+// Read a whole binary file. Relative paths not found from the working directory are also looked for
+// next to the executable. Return false if the file can't be read.
+bool ReadFile(const char* filePath, std::vector<char>& outData);
+
+bool WriteFile(const char* filePath, const void* data, size_t size);
+} // namespace Utils
+} // namespace VulkanRenderer
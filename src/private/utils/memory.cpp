@@ -0,0 +1,209 @@
+#include <utils/memory.h>
+
+#include <log.h>
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+struct Allocation
+{
+    uint32_t heapIndex;
+    VkDeviceSize size;
+};
+
+// Every allocation made by the helpers, to know the usage of each heap without VK_EXT_memory_budget
+struct AllocationTracker
+{
+    std::mutex mutex;
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapBytes{};
+};
+
+AllocationTracker& GetTracker()
+{
+    static AllocationTracker tracker;
+    return tracker;
+}
+
+// Allocate from the first memory type with the preferred properties, else with the required ones, and track it
+bool AllocateMemory(VkDevice device, VkPhysicalDevice physicalDevice, const VkMemoryRequirements& requirements,
+                    VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties,
+                    VkDeviceMemory& outMemory)
+{
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = VulkanRenderer::Utils::FindMemoryType(physicalDevice, requirements.memoryTypeBits,
+                                                                      properties | preferredProperties);
+
+    if (allocInfo.memoryTypeIndex == VulkanRenderer::Utils::invalidMemoryType)
+        allocInfo.memoryTypeIndex =
+            VulkanRenderer::Utils::FindMemoryType(physicalDevice, requirements.memoryTypeBits, properties);
+
+    if (allocInfo.memoryTypeIndex == VulkanRenderer::Utils::invalidMemoryType)
+    {
+        LOG_ERROR("Found no memory type suitable for the resource");
+        return false;
+    }
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &outMemory) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to allocate memory");
+        outMemory = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    const VkMemoryType& memoryType = memoryProperties.memoryTypes[allocInfo.memoryTypeIndex];
+    // Committed by the driver only when a tile needs it, which usually never happens
+    if (memoryType.propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+        return true;
+
+    AllocationTracker& tracker = GetTracker();
+    std::lock_guard lock(tracker.mutex);
+    tracker.allocations[outMemory] = {memoryType.heapIndex, requirements.size};
+    tracker.heapBytes[memoryType.heapIndex] += requirements.size;
+    return true;
+}
+
+void FreeMemory(VkDevice device, VkDeviceMemory memory)
+{
+    if (memory == VK_NULL_HANDLE)
+        return;
+
+    {
+        AllocationTracker& tracker = GetTracker();
+        std::lock_guard lock(tracker.mutex);
+        auto allocation = tracker.allocations.find(memory);
+        if (allocation != tracker.allocations.end())
+        {
+            tracker.heapBytes[allocation->second.heapIndex] -= allocation->second.size;
+            tracker.allocations.erase(allocation);
+        }
+    }
+
+    vkFreeMemory(device, memory, nullptr);
+}
+} // namespace
+
+uint32_t VulkanRenderer::Utils::FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeBits,
+                                               VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            return i;
+    }
+
+    return invalidMemoryType;
+}
+
+bool VulkanRenderer::Utils::CreateBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size,
+                                         VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                                         VkBuffer& outBuffer, VkDeviceMemory& outMemory,
+                                         VkMemoryPropertyFlags preferredProperties)
+{
+    outBuffer = VK_NULL_HANDLE;
+    outMemory = VK_NULL_HANDLE;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &outBuffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create buffer");
+        outBuffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, outBuffer, &requirements);
+
+    if (!AllocateMemory(device, physicalDevice, requirements, properties, preferredProperties, outMemory))
+    {
+        DestroyBuffer(device, outBuffer, VK_NULL_HANDLE);
+        outBuffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    vkBindBufferMemory(device, outBuffer, outMemory, 0);
+    return true;
+}
+
+void VulkanRenderer::Utils::DestroyBuffer(VkDevice device, VkBuffer buffer, VkDeviceMemory memory)
+{
+    if (buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, buffer, nullptr);
+
+    FreeMemory(device, memory);
+}
+
+bool VulkanRenderer::Utils::CreateImage(VkDevice device, VkPhysicalDevice physicalDevice,
+                                        const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties,
+                                        VkImage& outImage, VkDeviceMemory& outMemory,
+                                        VkMemoryPropertyFlags preferredProperties)
+{
+    outImage = VK_NULL_HANDLE;
+    outMemory = VK_NULL_HANDLE;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &outImage) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create image");
+        outImage = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, outImage, &requirements);
+
+    if (!AllocateMemory(device, physicalDevice, requirements, properties, preferredProperties, outMemory))
+    {
+        DestroyImage(device, outImage, VK_NULL_HANDLE);
+        outImage = VK_NULL_HANDLE;
+        return false;
+    }
+
+    vkBindImageMemory(device, outImage, outMemory, 0);
+    return true;
+}
+
+void VulkanRenderer::Utils::DestroyImage(VkDevice device, VkImage image, VkDeviceMemory memory)
+{
+    if (image != VK_NULL_HANDLE)
+        vkDestroyImage(device, image, nullptr);
+
+    FreeMemory(device, memory);
+}
+
+VkDeviceSize VulkanRenderer::Utils::GetAllocatedBytes(uint32_t heapIndex)
+{
+    if (heapIndex >= VK_MAX_MEMORY_HEAPS)
+        return 0;
+
+    AllocationTracker& tracker = GetTracker();
+    std::lock_guard lock(tracker.mutex);
+    return tracker.heapBytes[heapIndex];
+}
+
+bool VulkanRenderer::Utils::GetAllocation(VkDeviceMemory memory, uint32_t& outHeapIndex, VkDeviceSize& outSize)
+{
+    AllocationTracker& tracker = GetTracker();
+    std::lock_guard lock(tracker.mutex);
+    auto allocation = tracker.allocations.find(memory);
+    if (allocation == tracker.allocations.end())
+        return false;
+
+    outHeapIndex = allocation->second.heapIndex;
+    outSize = allocation->second.size;
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace VulkanRenderer
+{
+namespace Utils
+{
+constexpr uint32_t invalidMemoryType = ~0u;
+
+// Return the first memory type allowed by typeBits that has all the wanted properties,
+// or invalidMemoryType if none.
+uint32_t FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeBits, VkMemoryPropertyFlags properties);
+
+// Create a buffer and bind it to its own allocation. Return false on failure, with both handles left null.
+// preferredProperties are added to the required properties if such a memory type exists.
+bool CreateBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage,
+                  VkMemoryPropertyFlags properties, VkBuffer& outBuffer, VkDeviceMemory& outMemory,
+                  VkMemoryPropertyFlags preferredProperties = 0);
+
+void DestroyBuffer(VkDevice device, VkBuffer buffer, VkDeviceMemory memory);
+
+// Same for an image, created from imageInfo
+bool CreateImage(VkDevice device, VkPhysicalDevice physicalDevice, const VkImageCreateInfo& imageInfo,
+                 VkMemoryPropertyFlags properties, VkImage& outImage, VkDeviceMemory& outMemory,
+                 VkMemoryPropertyFlags preferredProperties = 0);
+
+void DestroyImage(VkDevice device, VkImage image, VkDeviceMemory memory);
+
+// Bytes allocated by the helpers above in a memory heap, lazily allocated memory left out. Thread safe.
+VkDeviceSize GetAllocatedBytes(uint32_t heapIndex);
+// Heap and size of an allocation made by the helpers above, false if unknown. Thread safe.
+bool GetAllocation(VkDeviceMemory memory, uint32_t& outHeapIndex, VkDeviceSize& outSize);
+
+inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+}
+} // namespace Utils
+} // namespace VulkanRenderer
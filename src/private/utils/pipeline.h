@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace VulkanRenderer
+{
+namespace Utils
+{
+// Layout shared by all the variants of a pipeline, graphic or compute. VK_NULL_HANDLE on failure.
+VkPipelineLayout CreatePipelineLayout(VkDevice device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                      const std::vector<VkPushConstantRange>& pushConstantRanges);
+} // namespace Utils
+} // namespace VulkanRenderer
@@ -0,0 +1,150 @@
+#include <utils/png.h>
+
+#include <log.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+// Deflate stored blocks are limited to 65535 bytes
+constexpr uint32_t maxStoredBlockSize = 0xFFFF;
+
+std::array<uint32_t, 256> MakeCrcTable()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const std::array<uint32_t, 256> crcTable = MakeCrcTable();
+
+    for (size_t i = 0; i < size; ++i)
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return crc;
+}
+
+void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void AppendChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data)
+{
+    AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+
+    size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    // Covers the type and the data
+    uint32_t crc = UpdateCrc(0xFFFFFFFFu, out.data() + typeOffset, out.size() - typeOffset) ^ 0xFFFFFFFFu;
+    AppendBigEndian(out, crc);
+}
+} // namespace
+
+std::vector<uint8_t> VulkanRenderer::Utils::EncodePng(const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+    // Each row starts with its filter type, 0 for none
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> scanlines;
+    scanlines.reserve((rowSize + 1) * height);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        scanlines.push_back(0);
+        scanlines.insert(scanlines.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+    }
+
+    // Zlib stream made of stored deflate blocks
+    std::vector<uint8_t> imageData;
+    imageData.reserve(scanlines.size() + scanlines.size() / maxStoredBlockSize * 5 + 16);
+    imageData.push_back(0x78);
+    imageData.push_back(0x01);
+
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    size_t offset = 0;
+
+    do
+    {
+        uint32_t blockSize = static_cast<uint32_t>(std::min<size_t>(scanlines.size() - offset, maxStoredBlockSize));
+        bool lastBlock = offset + blockSize == scanlines.size();
+
+        imageData.push_back(lastBlock ? 1 : 0);
+        imageData.push_back(static_cast<uint8_t>(blockSize));
+        imageData.push_back(static_cast<uint8_t>(blockSize >> 8));
+        imageData.push_back(static_cast<uint8_t>(~blockSize));
+        imageData.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        imageData.insert(imageData.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+        for (uint32_t i = 0; i < blockSize; ++i)
+        {
+            adlerA = (adlerA + scanlines[offset + i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+
+        offset += blockSize;
+    } while (offset < scanlines.size());
+
+    AppendBigEndian(imageData, (adlerB << 16) | adlerA);
+
+    // 8 bits per channel, RGBA, no interlacing
+    std::vector<uint8_t> header;
+    AppendBigEndian(header, width);
+    AppendBigEndian(header, height);
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+
+    std::vector<uint8_t> file = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.reserve(imageData.size() + 64);
+    AppendChunk(file, "IHDR", header);
+    AppendChunk(file, "IDAT", imageData);
+    AppendChunk(file, "IEND", {});
+
+    return file;
+}
+
+bool VulkanRenderer::Utils::WritePng(const char* filePath, const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> file = EncodePng(rgba, width, height);
+
+    std::ofstream fileStream(filePath, std::ios::binary | std::ios::trunc);
+    if (!fileStream.is_open())
+    {
+        LOG_ERROR("Failed to open file ", filePath, " for writing");
+        return false;
+    }
+
+    fileStream.write(reinterpret_cast<const char*>(file.data()), file.size());
+    return fileStream.good();
+}
+
+void VulkanRenderer::Utils::ConvertToOpaqueRgba(const uint8_t* pixels, size_t pixelCount, bool bgra,
+                                                uint8_t* outRgba)
+{
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const uint8_t* source = pixels + i * 4;
+        uint8_t* destination = outRgba + i * 4;
+        destination[0] = source[bgra ? 2 : 0];
+        destination[1] = source[1];
+        destination[2] = source[bgra ? 0 : 2];
+        destination[3] = 255;
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VulkanRenderer
+{
+namespace Utils
+{
+// Encode 8 bits RGBA pixels, rows tightly packed, as a PNG file in memory.
+// The image data is stored without compression: fast to write, as big as the raw pixels.
+std::vector<uint8_t> EncodePng(const uint8_t* rgba, uint32_t width, uint32_t height);
+
+// Same, written to a file
+bool WritePng(const char* filePath, const uint8_t* rgba, uint32_t width, uint32_t height);
+
+// Swizzle 4 bytes per pixel images read back from the GPU to RGBA, alpha forced opaque
+void ConvertToOpaqueRgba(const uint8_t* pixels, size_t pixelCount, bool bgra, uint8_t* outRgba);
+} // namespace Utils
+} // namespace VulkanRenderer
@@ -12,6 +12,9 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // A family with compute but no graphics, if the device has one. Work submitted there runs alongside the
+    // graphics queue instead of between its submissions.
+    std::optional<uint32_t> asyncComputeFamily;
 
     bool IsComplete() const { return graphicsFamily.has_value() && presentFamily.has_value(); }
 };
@@ -47,8 +50,16 @@ inline QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device, VkSurfaceKH
         ++i;
     }
 
-    // Then check if it supports
-    i = 0;
+    // Dedicated compute families are usually backed by separate hardware queues
+    for (uint32_t family = 0; family < queueFamilyCount; ++family)
+    {
+        VkQueueFlags flags = queueFamilies[family].queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            indices.asyncComputeFamily = family;
+            break;
+        }
+    }
 
     return indices;
 }
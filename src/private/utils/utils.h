@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <utility>
 #include <vector>
 
 namespace VulkanRenderer
@@ -48,5 +50,31 @@ int ValidateStrings(const FirstConstainer& inNames, const SecondContainer& other
     return ValidateStrings(inNames.data(), static_cast<uint32_t>(inNames.size()), otherNames.data(),
                            static_cast<uint32_t>(otherNames.size()), std::forward<Func>(getStringCallback));
 }
+
+// Mix the hash of value into seed (same as boost::hash_combine)
+template <typename T>
+void HashCombine(size_t& seed, const T& value)
+{
+    seed ^= std::hash<T>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+// Call a function when leaving the scope, whatever the path out of it
+template <typename Func>
+class ScopeExit
+{
+public:
+    explicit ScopeExit(Func function)
+        : m_function(std::move(function))
+    {
+    }
+
+    ~ScopeExit() { m_function(); }
+
+    ScopeExit(const ScopeExit&) = delete;
+    ScopeExit& operator=(const ScopeExit&) = delete;
+
+private:
+    Func m_function;
+};
 } // namespace Utils
 } // namespace VulkanRenderer
\ No newline at end of file
@@ -46,6 +46,71 @@ std::string GetDriverVerson(const VkPhysicalDeviceProperties& properties)
     }
     return stream.str();
 }
+
+struct FeatureName
+{
+    const char* name;
+    VkBool32 VkPhysicalDeviceFeatures::*member;
+};
+
+// All the members of VkPhysicalDeviceFeatures, in declaration order
+constexpr FeatureName featureNames[] = {
+    {"robustBufferAccess", &VkPhysicalDeviceFeatures::robustBufferAccess},
+    {"fullDrawIndexUint32", &VkPhysicalDeviceFeatures::fullDrawIndexUint32},
+    {"imageCubeArray", &VkPhysicalDeviceFeatures::imageCubeArray},
+    {"independentBlend", &VkPhysicalDeviceFeatures::independentBlend},
+    {"geometryShader", &VkPhysicalDeviceFeatures::geometryShader},
+    {"tessellationShader", &VkPhysicalDeviceFeatures::tessellationShader},
+    {"sampleRateShading", &VkPhysicalDeviceFeatures::sampleRateShading},
+    {"dualSrcBlend", &VkPhysicalDeviceFeatures::dualSrcBlend},
+    {"logicOp", &VkPhysicalDeviceFeatures::logicOp},
+    {"multiDrawIndirect", &VkPhysicalDeviceFeatures::multiDrawIndirect},
+    {"drawIndirectFirstInstance", &VkPhysicalDeviceFeatures::drawIndirectFirstInstance},
+    {"depthClamp", &VkPhysicalDeviceFeatures::depthClamp},
+    {"depthBiasClamp", &VkPhysicalDeviceFeatures::depthBiasClamp},
+    {"fillModeNonSolid", &VkPhysicalDeviceFeatures::fillModeNonSolid},
+    {"depthBounds", &VkPhysicalDeviceFeatures::depthBounds},
+    {"wideLines", &VkPhysicalDeviceFeatures::wideLines},
+    {"largePoints", &VkPhysicalDeviceFeatures::largePoints},
+    {"alphaToOne", &VkPhysicalDeviceFeatures::alphaToOne},
+    {"multiViewport", &VkPhysicalDeviceFeatures::multiViewport},
+    {"samplerAnisotropy", &VkPhysicalDeviceFeatures::samplerAnisotropy},
+    {"textureCompressionETC2", &VkPhysicalDeviceFeatures::textureCompressionETC2},
+    {"textureCompressionASTC_LDR", &VkPhysicalDeviceFeatures::textureCompressionASTC_LDR},
+    {"textureCompressionBC", &VkPhysicalDeviceFeatures::textureCompressionBC},
+    {"occlusionQueryPrecise", &VkPhysicalDeviceFeatures::occlusionQueryPrecise},
+    {"pipelineStatisticsQuery", &VkPhysicalDeviceFeatures::pipelineStatisticsQuery},
+    {"vertexPipelineStoresAndAtomics", &VkPhysicalDeviceFeatures::vertexPipelineStoresAndAtomics},
+    {"fragmentStoresAndAtomics", &VkPhysicalDeviceFeatures::fragmentStoresAndAtomics},
+    {"shaderTessellationAndGeometryPointSize", &VkPhysicalDeviceFeatures::shaderTessellationAndGeometryPointSize},
+    {"shaderImageGatherExtended", &VkPhysicalDeviceFeatures::shaderImageGatherExtended},
+    {"shaderStorageImageExtendedFormats", &VkPhysicalDeviceFeatures::shaderStorageImageExtendedFormats},
+    {"shaderStorageImageMultisample", &VkPhysicalDeviceFeatures::shaderStorageImageMultisample},
+    {"shaderStorageImageReadWithoutFormat", &VkPhysicalDeviceFeatures::shaderStorageImageReadWithoutFormat},
+    {"shaderStorageImageWriteWithoutFormat", &VkPhysicalDeviceFeatures::shaderStorageImageWriteWithoutFormat},
+    {"shaderUniformBufferArrayDynamicIndexing", &VkPhysicalDeviceFeatures::shaderUniformBufferArrayDynamicIndexing},
+    {"shaderSampledImageArrayDynamicIndexing", &VkPhysicalDeviceFeatures::shaderSampledImageArrayDynamicIndexing},
+    {"shaderStorageBufferArrayDynamicIndexing", &VkPhysicalDeviceFeatures::shaderStorageBufferArrayDynamicIndexing},
+    {"shaderStorageImageArrayDynamicIndexing", &VkPhysicalDeviceFeatures::shaderStorageImageArrayDynamicIndexing},
+    {"shaderClipDistance", &VkPhysicalDeviceFeatures::shaderClipDistance},
+    {"shaderCullDistance", &VkPhysicalDeviceFeatures::shaderCullDistance},
+    {"shaderFloat64", &VkPhysicalDeviceFeatures::shaderFloat64},
+    {"shaderInt64", &VkPhysicalDeviceFeatures::shaderInt64},
+    {"shaderInt16", &VkPhysicalDeviceFeatures::shaderInt16},
+    {"shaderResourceResidency", &VkPhysicalDeviceFeatures::shaderResourceResidency},
+    {"shaderResourceMinLod", &VkPhysicalDeviceFeatures::shaderResourceMinLod},
+    {"sparseBinding", &VkPhysicalDeviceFeatures::sparseBinding},
+    {"sparseResidencyBuffer", &VkPhysicalDeviceFeatures::sparseResidencyBuffer},
+    {"sparseResidencyImage2D", &VkPhysicalDeviceFeatures::sparseResidencyImage2D},
+    {"sparseResidencyImage3D", &VkPhysicalDeviceFeatures::sparseResidencyImage3D},
+    {"sparseResidency2Samples", &VkPhysicalDeviceFeatures::sparseResidency2Samples},
+    {"sparseResidency4Samples", &VkPhysicalDeviceFeatures::sparseResidency4Samples},
+    {"sparseResidency8Samples", &VkPhysicalDeviceFeatures::sparseResidency8Samples},
+    {"sparseResidency16Samples", &VkPhysicalDeviceFeatures::sparseResidency16Samples},
+    {"sparseResidencyAliased", &VkPhysicalDeviceFeatures::sparseResidencyAliased},
+    {"variableMultisampleRate", &VkPhysicalDeviceFeatures::variableMultisampleRate},
+    {"inheritedQueries", &VkPhysicalDeviceFeatures::inheritedQueries},
+};
 } // namespace
 
 std::string VulkanRenderer::Utils::PhysicalDevicePropertiesDump(const VkPhysicalDeviceProperties& properties)
@@ -70,5 +135,16 @@ std::string VulkanRenderer::Utils::PhysicalDevicePropertiesDump(const VkPhysical
 std::string VulkanRenderer::Utils::PhysicalDeviceFeaturesDump(const VkPhysicalDeviceFeatures& features)
 {
     std::stringstream stream;
+
+    const char* tab = "  ";
+
+    // Only the supported ones, the list is long
+    stream << "Device features:" << std::endl;
+    for (const FeatureName& feature : featureNames)
+    {
+        if (features.*feature.member)
+            stream << tab << "- " << feature.name << std::endl;
+    }
+
     return stream.str();
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace VulkanRenderer
+{
+namespace Utils
+{
+// Chase-Lev deque of pointers, with a fixed capacity.
+// The owner thread pushes and pops at the bottom (LIFO, cache friendly), any other thread steals
+// from the top (FIFO). Lock free, memory orders from "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (Le et al. 2013).
+template <typename T>
+class WorkStealingDeque
+{
+public:
+    // Capacity is 2^capacityLog2
+    explicit WorkStealingDeque(uint32_t capacityLog2)
+        : m_capacity(int64_t(1) << capacityLog2)
+        , m_mask(m_capacity - 1)
+        , m_buffer(std::make_unique<std::atomic<T*>[]>(static_cast<size_t>(m_capacity)))
+    {
+    }
+
+    // Owner only. Return false when full.
+    bool Push(T* item)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= m_capacity)
+            return false;
+
+        m_buffer[bottom & m_mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only. Return nullptr when empty.
+    T* Pop()
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty, restore
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = m_buffer[bottom & m_mask].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            // Last item, race with the thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    // Any thread. Return nullptr when empty, or when another thread won the race.
+    T* Steal()
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return nullptr;
+
+        T* item = m_buffer[top & m_mask].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return item;
+    }
+
+private:
+    const int64_t m_capacity;
+    const int64_t m_mask;
+    std::unique_ptr<std::atomic<T*>[]> m_buffer;
+
+    // On their own cache lines, the owner and the thieves hammer different ends
+    alignas(64) std::atomic<int64_t> m_top = 0;
+    alignas(64) std::atomic<int64_t> m_bottom = 0;
+};
+} // namespace Utils
+} // namespace VulkanRenderer
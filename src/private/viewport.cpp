@@ -0,0 +1,291 @@
+#include <viewport.h>
+
+#include <attachment.h>
+#include <log.h>
+#include <renderTarget.h>
+#include <swapChain.h>
+#include <utils/queueFamily.h>
+
+#include <GLFW/glfw3.h>
+
+#include <array>
+
+using VulkanRenderer::Viewport;
+using VulkanRenderer::ViewportConfig;
+
+Viewport::Viewport(ViewportConfig& config)
+    : m_instanceCache(config.instance)
+    , m_deviceCache(config.device)
+    , m_physicalDevice(config.physicalDevice)
+    , m_queueFamilies(config.queueFamilies)
+    , m_id(config.id)
+    , m_window(config.window)
+    , m_surface(config.surface)
+    , m_samples(config.samples)
+    , m_depthFormat(config.depthFormat)
+    , m_keepDepth(config.keepDepth)
+{
+    if (IsOffscreen())
+    {
+        VulkanRenderer::RenderTargetConfig targetConfig;
+        targetConfig.device = m_deviceCache;
+        targetConfig.physicalDevice = m_physicalDevice;
+        targetConfig.renderPass = config.offscreenRenderPass;
+        targetConfig.format = config.format;
+        targetConfig.extent = config.extent;
+        // Written by a blit when post-processed
+        targetConfig.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        targetConfig.samples = m_samples;
+        targetConfig.depthFormat = m_depthFormat;
+        targetConfig.keepDepth = m_keepDepth;
+
+        m_renderPass = config.offscreenRenderPass;
+        m_renderTarget = std::make_unique<VulkanRenderer::RenderTarget>(targetConfig);
+        return;
+    }
+
+    // The device was picked for another surface, this one may not be presentable from the same queue
+    VkBool32 presentSupport = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(m_physicalDevice, m_queueFamilies->presentFamily.value(), m_surface,
+                                         &presentSupport);
+    if (!presentSupport)
+    {
+        LOG_ERROR("The window surface can't be presented by the selected device");
+        return;
+    }
+
+    m_swapChainSupport = std::make_unique<VulkanRenderer::SwapChainSupportDetails>();
+    if (config.swapChainSupport != nullptr)
+        *m_swapChainSupport = *config.swapChainSupport;
+    else
+        VulkanRenderer::SwapChain::FillSwapChainSupportDetails(m_physicalDevice, m_surface, *m_swapChainSupport);
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    m_imageAvailable.resize(config.framesInFlight, VK_NULL_HANDLE);
+    m_renderFinished.resize(config.framesInFlight, VK_NULL_HANDLE);
+
+    for (uint32_t i = 0; i < config.framesInFlight; ++i)
+    {
+        if (vkCreateSemaphore(m_deviceCache, &semaphoreInfo, nullptr, &m_imageAvailable[i]) != VK_SUCCESS ||
+            vkCreateSemaphore(m_deviceCache, &semaphoreInfo, nullptr, &m_renderFinished[i]) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to initialize sync objects");
+            return;
+        }
+    }
+
+    CreateSwapChain();
+}
+
+Viewport::~Viewport()
+{
+    DestroyFramebuffers();
+
+    for (VkSemaphore semaphore : m_imageAvailable)
+    {
+        if (semaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_deviceCache, semaphore, nullptr);
+    }
+
+    for (VkSemaphore semaphore : m_renderFinished)
+    {
+        if (semaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_deviceCache, semaphore, nullptr);
+    }
+
+    m_renderTarget.reset();
+    m_swapChain.reset();
+
+    if (m_surface != VK_NULL_HANDLE)
+        vkDestroySurfaceKHR(m_instanceCache, m_surface, nullptr);
+
+    if (m_window != nullptr)
+        glfwDestroyWindow(m_window);
+}
+
+bool Viewport::IsValid() const
+{
+    if (IsOffscreen())
+        return m_renderTarget && m_renderTarget->IsValid();
+
+    return m_swapChain && m_swapChain->IsValid() && !m_renderFinished.empty() &&
+           m_renderFinished.back() != VK_NULL_HANDLE;
+}
+
+bool Viewport::CreateSwapChain()
+{
+    // To allow re-use of the swap chain, we will pass the old swap chain
+    // So it will create a new one (using the previous one) and destroy the previous one.
+    m_swapChain = std::make_unique<VulkanRenderer::SwapChain>(m_deviceCache, m_physicalDevice, m_surface, m_window,
+                                                              *m_queueFamilies, *m_swapChainSupport,
+                                                              m_swapChain.get());
+    return m_swapChain->IsValid();
+}
+
+bool Viewport::CreateFramebuffers(VkRenderPass renderPass)
+{
+    if (IsOffscreen())
+        return IsValid();
+
+    if (!m_swapChain || !m_swapChain->IsValid())
+        return false;
+
+    m_renderPass = renderPass;
+
+    std::vector<VkImageView>& imageViews = m_swapChain->GetImageViews();
+
+    m_framebuffers.resize(imageViews.size(), VK_NULL_HANDLE);
+
+    // Shared by all the images, like the samples
+    VulkanRenderer::AttachmentConfig attachmentConfig;
+    attachmentConfig.device = m_deviceCache;
+    attachmentConfig.physicalDevice = m_physicalDevice;
+    attachmentConfig.extent = m_swapChain->GetExtent();
+    attachmentConfig.samples = m_samples;
+
+    attachmentConfig.format = m_depthFormat;
+    attachmentConfig.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    attachmentConfig.sampled = m_keepDepth;
+
+    m_depth = std::make_unique<VulkanRenderer::Attachment>(attachmentConfig);
+    if (!m_depth->IsValid())
+        return false;
+
+    // The color, the depth, then the image the samples are resolved in when multisampled
+    std::array<VkImageView, 3> attachments = {VK_NULL_HANDLE, m_depth->GetImageView(), VK_NULL_HANDLE};
+    uint32_t attachmentCount = 2;
+    uint32_t imageAttachment = 0;
+
+    if (m_samples != VK_SAMPLE_COUNT_1_BIT)
+    {
+        attachmentConfig.format = m_swapChain->GetFormat();
+        attachmentConfig.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        attachmentConfig.sampled = false;
+
+        m_multisample = std::make_unique<VulkanRenderer::Attachment>(attachmentConfig);
+        if (!m_multisample->IsValid())
+            return false;
+
+        attachments[0] = m_multisample->GetImageView();
+        attachmentCount = 3;
+        imageAttachment = 2;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = m_renderPass;
+    framebufferInfo.attachmentCount = attachmentCount;
+    framebufferInfo.pAttachments = attachments.data();
+    framebufferInfo.width = m_swapChain->GetExtent().width;
+    framebufferInfo.height = m_swapChain->GetExtent().height;
+    framebufferInfo.layers = 1;
+
+    for (size_t i = 0; i < m_framebuffers.size(); ++i)
+    {
+        attachments[imageAttachment] = imageViews[i];
+
+        if (vkCreateFramebuffer(m_deviceCache, &framebufferInfo, nullptr, &m_framebuffers[i]) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create framebuffers");
+            m_framebuffers[i] = VK_NULL_HANDLE;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Viewport::DestroyFramebuffers()
+{
+    for (VkFramebuffer& framebuffer : m_framebuffers)
+    {
+        if (framebuffer != VK_NULL_HANDLE)
+            vkDestroyFramebuffer(m_deviceCache, framebuffer, nullptr);
+    }
+
+    m_framebuffers.clear();
+    m_multisample.reset();
+    m_depth.reset();
+}
+
+VkResult Viewport::AcquireImage(uint32_t frameIndex)
+{
+    if (IsOffscreen())
+        return VK_SUCCESS;
+
+    if (m_outOfDate)
+        return VK_ERROR_OUT_OF_DATE_KHR;
+
+    VkResult result = vkAcquireNextImageKHR(m_deviceCache, m_swapChain->GetSwapChain(), UINT64_MAX,
+                                            m_imageAvailable[frameIndex], VK_NULL_HANDLE, &m_imageIndex);
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        m_outOfDate = true;
+
+    return result;
+}
+
+bool Viewport::IsMinimized() const
+{
+    if (IsOffscreen())
+        return false;
+
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    return width == 0 || height == 0;
+}
+
+bool Viewport::Recreate()
+{
+    if (IsOffscreen())
+        return true;
+
+    DestroyFramebuffers();
+    m_outOfDate = false;
+
+    return CreateSwapChain() && CreateFramebuffers(m_renderPass);
+}
+
+VkFramebuffer Viewport::GetFramebuffer() const
+{
+    return IsOffscreen() ? m_renderTarget->GetFramebuffer() : m_framebuffers[m_imageIndex];
+}
+
+VkImage Viewport::GetImage() const
+{
+    return IsOffscreen() ? m_renderTarget->GetImage() : m_swapChain->GetImages()[m_imageIndex];
+}
+
+VkFormat Viewport::GetFormat() const
+{
+    return IsOffscreen() ? m_renderTarget->GetFormat() : m_swapChain->GetFormat();
+}
+
+VkExtent2D Viewport::GetExtent() const
+{
+    return IsOffscreen() ? m_renderTarget->GetExtent() : m_swapChain->GetExtent();
+}
+
+VkImageUsageFlags Viewport::GetImageUsage() const
+{
+    return IsOffscreen() ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                               VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                         : m_swapChain->GetImageUsage();
+}
+
+VkImageLayout Viewport::GetFinalLayout() const
+{
+    return IsOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+}
+
+VkImageView Viewport::GetDepthView() const
+{
+    if (IsOffscreen())
+        return m_renderTarget->GetDepthView();
+
+    return m_depth ? m_depth->GetImageView() : VK_NULL_HANDLE;
+}
+
+VkSwapchainKHR Viewport::GetSwapChain() const { return m_swapChain ? m_swapChain->GetSwapChain() : VK_NULL_HANDLE; }
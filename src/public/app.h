@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -8,21 +9,49 @@
 
 struct GLFWwindow;
 struct SwapChainSupportDetails;
+struct VkBuffer_T;
 struct VkCommandBuffer_T;
 struct VkCommandPool_T;
+struct VkDebugUtilsMessengerEXT_T;
 struct VkDevice_T;
+struct VkExtent2D;
 struct VkFence_T;
 struct VkFramebuffer_T;
 struct VkInstance_T;
 struct VkPhysicalDevice_T;
 struct VkQueue_T;
-struct VkSemaphore_T;
+struct VkRenderPass_T;
 struct VkSurfaceKHR_T;
 
 namespace VulkanRenderer
 {
+class BindlessHeap;
+struct CameraData;
+class ComputeScheduler;
+class DescriptorAllocator;
+class DescriptorLayoutCache;
+class DrawList;
+class DynamicResolution;
+class FrameCapture;
 class GraphicPipeline;
-class SwapChain;
+struct GraphicProgram;
+class JobCounter;
+class JobSystem;
+class MemoryBudget;
+class Metrics;
+class OcclusionCuller;
+class ParticleSystem;
+class PipelineCache;
+class PipelineRegistry;
+class PostProcess;
+struct PhysicalDeviceInfo;
+struct RenderJob;
+class RenderServer;
+class RenderTarget;
+class Scene;
+class ShaderReloader;
+class UniformRing;
+class Viewport;
 
 constexpr int maxFramesInFlight = 2; // Allow the CPU to prepare next frame while GPU is rendering the other.
 
@@ -36,6 +65,7 @@ public:
     int Init();
 
     // Simple run, will wait for the window to be closed.
+    // In server mode, renders jobs until SIGINT or SIGTERM instead.
     int Run();
 
 private:
@@ -43,30 +73,65 @@ private:
     int InitWindow();
     int InitVulkan();
     int DrawFrame();
+    // Swap in the shaders rebuilt since the last frame, and start rebuilding those which changed
+    void ReloadShaders();
+    // Read the memory budgets, and evict the resources the heaps past their budget can do without
+    void BeginMemoryBudgetFrame();
+    int RunServer();
+    int RenderServerBatch();
 
     static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
+    static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    void DumpTrace() const;
 
     // Init vulkan subfuctions
     int CreateInstance();
     int CreateLogicalDevice();
     int CreateSurface();
     int PickPhysicalDevice();
-    int CreateSwapChain();
+    int LoadShaderFiles();
+    int LoadPipelineCacheFile();
+    int CreatePipelineCache();
+    int CreatePipelineRegistry();
+    int CreateMainViewport();
+    int CreateViewports();
+    int CreateOffscreenRenderPass();
+    int CreateBindlessHeap();
+    int CreateMetrics();
+    int CreateMemoryBudget();
+    int CreateFrameCapture();
+    int CreateRenderServer();
+    int CreateDescriptorAllocator();
+    int CreateUniformRing();
     int CreateGraphicPipeline();
+    int CreatePostProcess();
+    int CreateOcclusionCuller();
+    int CreateParticleSystem();
+    int CreateDynamicResolution();
+    int CreateShaderReloader();
+    int CreateScene();
     int CreateFramebuffers();
     int CreateCommandPool();
     int CreateCommandBuffer();
+    int CreateComputeScheduler();
     int CreateSyncObjects();
 
     // Swap chain specific
-    int RecreateSwapChain();
+    int RecreateSwapChain(Viewport& viewport);
     int CleanupSwapChain();
 
     // Command buffer
-    int RecordCommandBuffer(VkCommandBuffer_T* commandBuffer, uint32_t imageIndex);
+    // Draw the scene in all the viewports rendered this frame
+    int RecordCommandBuffer(VkCommandBuffer_T* commandBuffer);
+    // Only the ownership transfers of the buffers the compute work handed over, for a dropped frame
+    int RecordGraphicsHandback(VkCommandBuffer_T* commandBuffer);
+    // Render pass drawing the scene, shared by the viewports and the render server targets.
+    // With a draw buffer, the instances are drawn with the arguments the culling wrote in it.
+    int RecordScene(VkCommandBuffer_T* commandBuffer, VkRenderPass_T* renderPass, VkFramebuffer_T* framebuffer,
+                    const VkExtent2D& extent, const CameraData& camera, VkBuffer_T* drawBuffer = nullptr);
 
     // Vulkan queue family specific
-    bool IsSuitableDevice(VkPhysicalDevice_T* device) const;
+    void ProbePhysicalDevice(VkPhysicalDevice_T* device, PhysicalDeviceInfo& outInfo) const;
     bool CheckDeviceExtensionSupport(VkPhysicalDevice_T* device) const;
 
     // Window specific
@@ -74,29 +139,101 @@ private:
     int m_width;
     int m_height;
     const char* m_windowName = "";
+    // Main window, owned by the main viewport once created
     GLFWwindow* m_window = nullptr;
 
-    std::unique_ptr<SwapChain> m_swapChain;
+    // The first one is the main window, closing it ends the application
+    std::vector<std::unique_ptr<Viewport>> m_viewports;
+    uint32_t m_nextViewportId = 0;
+    // Indices of those which got an image this frame
+    std::vector<uint32_t> m_frameViewports;
+    // Compatible with the pipelines, for the offscreen viewports and the render server targets
+    VkRenderPass_T* m_offscreenRenderPass = nullptr;
     std::unique_ptr<GraphicPipeline> m_graphicPipeline;
+    // Only when effects are enabled
+    std::unique_ptr<PostProcess> m_postProcess;
+    // Only when occlusion culling is enabled and supported
+    std::unique_ptr<OcclusionCuller> m_occlusionCuller;
+    // Only when particles are asked for
+    std::unique_ptr<ParticleSystem> m_particleSystem;
+    // Only when a GPU frame time target is given, the post-processing then upscales the viewports
+    std::unique_ptr<DynamicResolution> m_dynamicResolution;
+    std::unique_ptr<PipelineCache> m_pipelineCache;
+    // Graphics pipelines shared by state, they all go through it
+    std::unique_ptr<PipelineRegistry> m_pipelineRegistry;
+    // Only with hot reload. The reloaded shaders are built into a program on a worker, swapped in between frames.
+    std::unique_ptr<ShaderReloader> m_shaderReloader;
+    std::unique_ptr<GraphicProgram> m_reloadedProgram;
+    std::unique_ptr<JobCounter> m_programBuild;
+    bool m_shaderCodeChanged = false;
+    // Shared by all the subsystems, created first and destroyed last
+    std::unique_ptr<JobSystem> m_jobSystem;
+
+    std::unique_ptr<BindlessHeap> m_bindlessHeap;
+    std::unique_ptr<DescriptorLayoutCache> m_descriptorLayoutCache;
+    std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+    std::unique_ptr<UniformRing> m_uniformRing;
+    std::unique_ptr<DrawList> m_drawList;
+    std::unique_ptr<Scene> m_scene;
+    std::unique_ptr<Metrics> m_metrics;
+    // Usage of the memory heaps, and the resources evicted when they go past their budget
+    std::unique_ptr<MemoryBudget> m_memoryBudget;
+    std::unique_ptr<FrameCapture> m_frameCapture;
+    std::unique_ptr<ComputeScheduler> m_computeScheduler;
+
+    // Server mode only
+    std::unique_ptr<RenderServer> m_renderServer;
+    std::vector<RenderJob> m_pendingJobs;
+    // Null once evicted, each registered to the memory budget
+    std::vector<std::unique_ptr<RenderTarget>> m_serverTargets;
+    std::vector<uint64_t> m_serverTargetEvictables;
+    // Encodings of the last batch, the next one waits for them to keep the frames of a job in order
+    std::unique_ptr<JobCounter> m_serverEncodings;
 
     // Vulkan handles
     VkInstance_T* m_instance = nullptr;
+    VkDebugUtilsMessengerEXT_T* m_debugMessenger = nullptr;
     VkPhysicalDevice_T* m_physicalDevice = nullptr;
     VkDevice_T* m_device = nullptr;
     VkQueue_T* m_graphicsQueue = nullptr;
     VkQueue_T* m_presentQueue = nullptr;
+    // Dedicated compute queue, or the graphics one
+    VkQueue_T* m_computeQueue = nullptr;
+    // Main window surface, until the main viewport takes it
     VkSurfaceKHR_T* m_surface = nullptr;
-    std::vector<VkFramebuffer_T*> m_framebuffers{};
     VkCommandPool_T* m_commandPool = nullptr;
     std::array<VkCommandBuffer_T*, maxFramesInFlight> m_commandBuffers{};
 
-    // Sync objects
-    std::array<VkSemaphore_T*, maxFramesInFlight> m_imageAvailableSemaphores{};
-    std::array<VkSemaphore_T*, maxFramesInFlight> m_renderFinishedSemaphores{};
+    // Sync objects, semaphores are per viewport
     std::array<VkFence_T*, maxFramesInFlight> m_inFlightFences{};
 
+    // Device capabilities
+    std::unique_ptr<PhysicalDeviceInfo> m_deviceInfo;
+    bool m_bindlessSupported = false;
+    // Graphics pipelines fast linked from libraries, then optimized in the background
+    bool m_pipelineLibraries = false;
+    // MSAA samples of all the render passes, a VkSampleCountFlagBits supported by the device
+    uint32_t m_sampleCount = 1;
+    // VkFormat of the depth buffers, reverse-Z: cleared to 0, nearer is greater
+    uint32_t m_depthFormat = 0;
+    // Depth buffers kept for the culling of the next frame
+    bool m_occlusionCulling = false;
+
+    // Loaded while the device is created, replaced by the reloaded shaders
+    std::vector<char> m_vertShaderCode;
+    std::vector<char> m_fragShaderCode;
+    std::vector<char> m_pipelineCacheData;
+
+    // Time to first frame
+    std::chrono::steady_clock::time_point m_initStart;
+    bool m_firstFramePresented = false;
+    // Time step of the particles
+    std::chrono::steady_clock::time_point m_lastUpdateTime;
+
     // Utility
-    bool m_framebufferResized = false;
+    bool m_traceDumpRequested = false;
+    bool m_captureRequested = false;
+    uint64_t m_frameNumber = 0;
     int m_currentFrame = 0;
 };
 } // namespace VulkanRenderer
\ No newline at end of file
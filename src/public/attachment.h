@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+namespace VulkanRenderer
+{
+struct AttachmentConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    VkFormat format;
+    VkExtent2D extent;
+    VkSampleCountFlagBits samples;
+    // VK_IMAGE_ASPECT_COLOR_BIT or VK_IMAGE_ASPECT_DEPTH_BIT
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    // Read by shaders once the render pass is done, so stored instead of transient
+    bool sampled = false;
+};
+
+// Image only used as an attachment of the scene render passes: the multisampled color resolved at the end of the
+// pass, or the depth buffer.
+// Unless sampled, it is transient: never loaded nor stored, and bound to lazily allocated memory when the device
+// has some, so tile-based GPUs keep it in tile memory and may never back it at all.
+class Attachment
+{
+public:
+    Attachment(AttachmentConfig& config);
+    // The GPU must be done with the attachment
+    ~Attachment();
+
+    bool IsValid() const { return m_imageView != VK_NULL_HANDLE; }
+
+    VkImage GetImage() const { return m_image; }
+    VkImageView GetImageView() const { return m_imageView; }
+    VkDeviceMemory GetMemory() const { return m_memory; }
+    bool IsLazilyAllocated() const { return m_lazilyAllocated; }
+
+private:
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkImage m_image = VK_NULL_HANDLE;
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    VkImageView m_imageView = VK_NULL_HANDLE;
+    bool m_lazilyAllocated = false;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace VulkanRenderer
+{
+// Index of a resource in the global bindless arrays. Shaders use it directly to fetch the resource.
+using BindlessIndex = uint32_t;
+constexpr BindlessIndex invalidBindlessIndex = ~0u;
+
+// Each resource type lives in its own binding of the bindless set, the value is the binding. Shaders declare them as
+// runtime sized arrays (GL_EXT_nonuniform_qualifier), and index them with nonuniformEXT.
+enum class BindlessResourceType : uint8_t
+{
+    Texture = 0,       // Combined image samplers
+    StorageBuffer = 1, // Storage buffers
+
+    Count
+};
+
+struct BindlessHeapConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    uint32_t maxTextures;
+    uint32_t maxStorageBuffers;
+    uint32_t framesInFlight;
+};
+
+// Global descriptor set holding large, partially bound arrays of resources.
+// It is bound once per frame, and resources are referenced by their index instead of
+// updating descriptors for each draw.
+class BindlessHeap
+{
+public:
+    BindlessHeap(BindlessHeapConfig& config);
+    ~BindlessHeap();
+
+    bool IsValid() const;
+
+    VkDescriptorSetLayout GetLayout() const { return m_layout; }
+    VkDescriptorSet GetDescriptorSet() const { return m_descriptorSet; }
+    uint32_t GetCapacity(BindlessResourceType type) const { return m_slots[static_cast<size_t>(type)].capacity; }
+
+    // Return invalidBindlessIndex if the heap is full.
+    BindlessIndex RegisterTexture(VkImageView imageView, VkSampler sampler,
+                                  VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    BindlessIndex RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // The index is only recycled once the frames that could still reference it are done.
+    void Release(BindlessResourceType type, BindlessIndex index);
+
+    // To be called once the fence of this frame has been waited on.
+    void BeginFrame(uint32_t frameIndex);
+
+    void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+              uint32_t setIndex) const;
+
+    // Check that the device exposes descriptor indexing (core 1.2 or VK_EXT_descriptor_indexing)
+    // with all the features we need.
+    static bool IsSupported(VkPhysicalDevice physicalDevice);
+
+    // Extensions to enable on the logical device, if any (empty when using core 1.2).
+    static std::vector<const char*> GetRequiredDeviceExtensions(VkPhysicalDevice physicalDevice);
+
+    // Feature struct to chain in VkDeviceCreateInfo::pNext.
+    static VkPhysicalDeviceDescriptorIndexingFeatures GetRequiredFeatures();
+
+private:
+    struct Slots
+    {
+        uint32_t capacity = 0;
+        uint32_t highWaterMark = 0;
+        std::vector<BindlessIndex> freeList;
+        std::vector<std::vector<BindlessIndex>> pendingReleases;
+    };
+
+    void CreateLayout();
+    void CreatePoolAndSet();
+    BindlessIndex AllocateIndex(BindlessResourceType type);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+    std::mutex m_mutex;
+    std::array<Slots, static_cast<size_t>(BindlessResourceType::Count)> m_slots;
+    uint32_t m_currentFrame = 0;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <shaderPermutation.h>
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class Shader;
+
+struct ComputePipelineConfig
+{
+    VkDevice device;
+    const char* shaderFile;
+    // Already loaded SPIR-V, used instead of the file when set
+    const std::vector<char>* shaderCode = nullptr;
+    const char* pipelineName;
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    // Variant created with the pipeline, others are created on first use.
+    ShaderFeatureMask defaultFeatures;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+};
+
+// Single compute stage. Same shader loading, layout and feature variants as the graphic pipeline,
+// usable on any queue with compute support.
+class ComputePipeline
+{
+public:
+    ComputePipeline(ComputePipelineConfig& config);
+    ~ComputePipeline();
+
+    VkPipeline GetPipeline() { return GetPipeline(m_defaultFeatures); }
+    // Return the variant specialized for these features, creating it if needed. VK_NULL_HANDLE on failure.
+    VkPipeline GetPipeline(ShaderFeatureMask features);
+    ShaderFeatureMask GetDefaultFeatures() const { return m_defaultFeatures; }
+    VkPipelineLayout GetPipelineLayout() const { return m_pipelineLayout; }
+
+    // Bind the variant and dispatch enough groups to cover the invocations, groupSize being the local size
+    // declared by the shader
+    void Dispatch(VkCommandBuffer commandBuffer, ShaderFeatureMask features, uint32_t invocationCount,
+                  uint32_t groupSize);
+
+    bool IsValid() const;
+
+private:
+    VkPipeline CreatePipelineVariant(ShaderFeatureMask features);
+
+    VkDevice m_deviceCache;
+    std::unique_ptr<Shader> m_shader;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+
+    std::string m_entryPoint;
+    VkPipelineCache m_pipelineCache;
+    ShaderFeatureMask m_defaultFeatures;
+    std::unordered_map<ShaderFeatureMask, VkPipeline> m_pipelines;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanRenderer
+{
+struct ComputeSchedulerConfig
+{
+    VkDevice device;
+    // Queue the compute work is submitted to. The graphics queue itself when the device has no other.
+    VkQueue queue;
+    uint32_t queueFamily;
+    uint32_t graphicsFamily;
+    uint32_t framesInFlight;
+};
+
+// Compute work of a frame, recorded on its own command buffer and submitted before the graphics work of the
+// same frame. The graphics submission waits on a semaphore only at the stages reading the results, so on a
+// dedicated compute queue the work overlaps the graphics work recorded before those stages.
+// The frame fence covers both submissions: once waited on, the compute work of that frame is done too.
+class ComputeScheduler
+{
+public:
+    // Graphics stages waiting on the compute work
+    static constexpr VkPipelineStageFlags consumerStages =
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    ComputeScheduler(ComputeSchedulerConfig& config);
+    // The GPU must be done with the compute work
+    ~ComputeScheduler();
+
+    bool IsValid() const;
+
+    // Submitted to another queue family than the graphics one, resources change owner between both
+    bool IsAsync() const { return m_queueFamily != m_graphicsFamily; }
+    uint32_t GetQueueFamily() const { return m_queueFamily; }
+
+    // To be called once the fence of this frame has been waited on
+    void BeginFrame(uint32_t frameIndex);
+
+    // Command buffer of the frame, begun on first use. Nothing is submitted if no one asked for it.
+    VkCommandBuffer GetCommandBuffer();
+
+    // Buffers written by the compute work, read by the graphics work of the frame, and kept for the next frames.
+    // With exclusive sharing on another queue family their ownership goes back and forth: the compute work takes
+    // back those graphics gave back before touching them, and hands them over once written (graphicsStages and
+    // graphicsAccess are how graphics reads them). The graphics command buffer of the frame acquires them before
+    // reading them and gives them back once done, even when the frame is dropped. Its submission then signals
+    // GetGraphicsReleaseSemaphore, for the next compute submission to wait on.
+    // Nothing to do on a single queue family, submission order and the barriers of the caller are enough.
+    void AcquireFromGraphics(VkBuffer buffer, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess);
+    void ReleaseToGraphics(VkBuffer buffer, VkAccessFlags srcAccess, VkPipelineStageFlags graphicsStages,
+                           VkAccessFlags graphicsAccess);
+    // Buffers handed to graphics this frame
+    bool HasGraphicsHandoff() const { return !m_handoff.empty(); }
+    void RecordGraphicsAcquire(VkCommandBuffer graphicsCommandBuffer) const;
+    void RecordGraphicsRelease(VkCommandBuffer graphicsCommandBuffer) const;
+
+    // Submit the work recorded this frame. finished is the semaphore the graphics submission of the frame must wait
+    // on, at consumerStages, or VK_NULL_HANDLE if nothing was recorded. On failure nothing was handed to graphics:
+    // a graphics command buffer which already recorded RecordGraphicsAcquire must be dropped.
+    bool Submit(VkSemaphore& finished);
+
+    // Once the graphics command buffer of the frame recorded RecordGraphicsRelease, the semaphore its submission
+    // must signal, after Submit. VK_NULL_HANDLE when nothing was handed to graphics, or on a single queue family.
+    VkSemaphore GetGraphicsReleaseSemaphore();
+
+private:
+    struct Handoff
+    {
+        VkBuffer buffer;
+        VkPipelineStageFlags graphicsStages;
+        VkAccessFlags graphicsAccess;
+    };
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkQueue m_queue = VK_NULL_HANDLE;
+    uint32_t m_queueFamily = 0;
+    uint32_t m_graphicsFamily = 0;
+
+    VkCommandPool m_commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> m_commandBuffers;
+    // Signaled by the compute submission, waited on by the graphics one
+    std::vector<VkSemaphore> m_finished;
+    // The other way around, once graphics gave buffers back
+    std::vector<VkSemaphore> m_graphicsReleased;
+
+    // Handed to graphics this frame
+    std::vector<Handoff> m_handoff;
+    // Given back by graphics, not taken back by the compute work yet
+    std::vector<Handoff> m_returned;
+    // Taken back by the compute work of this frame, returned again if it is never submitted
+    std::vector<Handoff> m_taken;
+    // Signaled by graphics, the next compute submission waits on it
+    VkSemaphore m_returnedSemaphore = VK_NULL_HANDLE;
+
+    uint32_t m_frameIndex = 0;
+    bool m_recording = false;
+    // The releases of the handoff were submitted
+    bool m_submitted = false;
+};
+} // namespace VulkanRenderer
@@ -2,6 +2,8 @@
 
 #include <parser/parameters/CommandLineParameters.h>
 
+#include <string>
+
 namespace VulkanRenderer
 {
 struct VulkanParameters : bsc::CommandLineParameters
@@ -11,6 +13,66 @@ struct VulkanParameters : bsc::CommandLineParameters
         {.longKey = "device",
          .argumentName = "DEVICE",
          .doc = "Force given physical device. Use verbose to know order of devices."}};
+    bsc::Flag benchmarkDevices = {
+        {.longKey = "benchmark-devices",
+         .doc = "Measure the devices not measured yet, and pick the fastest. Results are cached per device."}};
+    bsc::Flag serialInit = {{.longKey = "serial-init", .doc = "Run the init steps one after the other."}};
+    bsc::Parameter<int> shaderFeatures = {
+        {.longKey = "features",
+         .argumentName = "MASK",
+         .doc = "Shader feature mask used by the pipeline, one bit per ShaderFeature."}};
+    bsc::Parameter<std::string> traceFile = {
+        {.longKey = "trace",
+         .argumentName = "FILE",
+         .doc = "Write the profiler trace to FILE on exit. F12 writes it at any time."}};
+    bsc::Parameter<std::string> metricsFile = {
+        {.longKey = "metrics",
+         .argumentName = "FILE",
+         .doc = "Periodically write the renderer counters to FILE, in the Prometheus text format."}};
+    bsc::Parameter<std::string> captureFolder = {
+        {.longKey = "capture",
+         .argumentName = "FOLDER",
+         .doc = "Write every frame to FOLDER. F11 writes a single frame at any time."}};
+    bsc::Flag captureRaw = {{.longKey = "capture-raw", .doc = "Write captures as raw pixels instead of PNG."}};
+    bsc::Parameter<int> windowCount = {
+        {.longKey = "windows",
+         .argumentName = "COUNT",
+         .doc = "Open COUNT windows, all rendered with the same device and submission. Default 1."}};
+    bsc::Parameter<int> offscreenViewports = {
+        {.longKey = "offscreen-viewports",
+         .argumentName = "COUNT",
+         .doc = "Also render COUNT offscreen viewports each frame, captured along with the windows."}};
+    bsc::Parameter<int> msaaSamples = {
+        {.longKey = "msaa",
+         .argumentName = "SAMPLES",
+         .doc = "Samples per pixel, resolved in the render pass. Lowered to what the device supports. Default 1."}};
+    bsc::Parameter<std::string> postProcess = {
+        {.longKey = "post-process",
+         .argumentName = "EFFECTS",
+         .doc = "Post-process the viewports with EFFECTS, comma separated: tonemap,grading,sharpen,vignette,grain."}};
+    bsc::Parameter<float> dynamicResolution = {
+        {.longKey = "dynamic-resolution",
+         .argumentName = "MS",
+         .doc = "Lower the resolution of the viewports when the GPU takes more than MS milliseconds per frame."}};
+    bsc::Flag depthPrepass = {
+        {.longKey = "depth-prepass", .doc = "Render the depth first, then shade each pixel once in a second pass."}};
+    bsc::Flag occlusionCulling = {
+        {.longKey = "occlusion-culling",
+         .doc = "Cull on the GPU the instances hidden behind the depth of the previous frame."}};
+    bsc::Parameter<int> particles = {
+        {.longKey = "particles",
+         .argumentName = "COUNT",
+         .doc = "Simulate and draw up to COUNT particles, entirely on the GPU."}};
+    bsc::Flag monolithicPipelines = {
+        {.longKey = "monolithic-pipelines",
+         .doc = "Compile each pipeline as a whole, even when the device supports graphics pipeline libraries."}};
+    bsc::Flag hotReload = {
+        {.longKey = "hot-reload",
+         .doc = "Watch the shader sources, and rebuild the pipelines when they change. Needs glslc in the PATH."}};
+    bsc::Parameter<std::string> serverSocket = {
+        {.longKey = "server",
+         .argumentName = "SOCKET",
+         .doc = "Run as a render server, taking offscreen render jobs on the Unix domain socket SOCKET."}};
 
     const char* execPath = "";
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanRenderer
+{
+// Own all the descriptor set layouts, and return the same layout for the same set of bindings.
+// Immutable samplers are not supported, nor the descriptor types DescriptorAllocator pools have no room for.
+class DescriptorLayoutCache
+{
+public:
+    DescriptorLayoutCache(VkDevice device);
+    ~DescriptorLayoutCache();
+
+    // Return VK_NULL_HANDLE on failure. Bindings order doesn't matter.
+    VkDescriptorSetLayout GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+private:
+    struct LayoutKey
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+        bool operator==(const LayoutKey& other) const;
+    };
+
+    struct LayoutKeyHash
+    {
+        size_t operator()(const LayoutKey& key) const;
+    };
+
+    VkDevice m_deviceCache;
+    std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> m_layouts;
+};
+
+struct DescriptorAllocatorConfig
+{
+    VkDevice device;
+    uint32_t framesInFlight;
+    // Number of sets in the first pool. Each new pool doubles it, up to maxSetsPerPool.
+    uint32_t initialSetsPerPool;
+    uint32_t maxSetsPerPool;
+};
+
+// Allocate descriptor sets that live for a single frame in flight.
+// Pools are grown on demand, and all the pools used by a frame are reset at once when
+// that frame comes back, instead of freeing sets one by one.
+// Not thread safe, use one allocator per recording thread.
+class DescriptorAllocator
+{
+public:
+    DescriptorAllocator(DescriptorAllocatorConfig& config);
+    ~DescriptorAllocator();
+
+    // The set is valid until BeginFrame is called again for the current frame index.
+    // Return VK_NULL_HANDLE on failure.
+    VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+
+    // To be called once the fence of this frame has been waited on.
+    void BeginFrame(uint32_t frameIndex);
+
+    uint32_t GetPoolCount() const { return m_poolCount; }
+    // Sets allocated since the last BeginFrame
+    uint32_t GetFrameAllocationCount() const { return m_frameAllocationCount; }
+
+private:
+    struct FramePools
+    {
+        VkDescriptorPool current = VK_NULL_HANDLE;
+        std::vector<VkDescriptorPool> full;
+    };
+
+    VkDescriptorPool GrabPool();
+    VkDescriptorPool CreatePool(uint32_t setCount);
+
+    VkDevice m_deviceCache;
+    std::vector<FramePools> m_frames;
+    std::vector<VkDescriptorPool> m_freePools;
+
+    uint32_t m_currentFrame = 0;
+    uint32_t m_nextSetsPerPool;
+    uint32_t m_maxSetsPerPool;
+    uint32_t m_poolCount = 0;
+    uint32_t m_frameAllocationCount = 0;
+};
+} // namespace VulkanRenderer
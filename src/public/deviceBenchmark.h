@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace VulkanRenderer
+{
+struct PhysicalDeviceInfo;
+
+struct DeviceBenchmarkConfig
+{
+    // Results of the previous runs, one line per device. Created if missing.
+    std::string cacheFile;
+    // SPIR-V of the compute probe
+    const char* computeShaderFile;
+};
+
+struct DeviceBenchmarkResult
+{
+    // Bytes written per second by buffer fills, in GB/s
+    float fillRate = 0.0f;
+    // Floating point operations per second of the compute probe, in GFLOPS
+    float computeRate = 0.0f;
+
+    // Single figure to rank the devices, the geometric mean of both rates
+    float GetScore() const;
+};
+
+// Measure the devices instead of trusting what they report: a fill rate and a compute probe, timed with timestamps
+// on a device created for the probe only. Results are cached per device UUID, and run again when the driver changes.
+class DeviceBenchmark
+{
+public:
+    DeviceBenchmark(DeviceBenchmarkConfig& config);
+
+    // CPU implementations are never probed, they would take long and are never the fastest. Neither are the devices
+    // without timestamps on their graphics queue.
+    static bool IsMeasurable(const PhysicalDeviceInfo& info);
+
+    // Result of a previous run on this device and driver. False if there is none.
+    bool FindResult(const PhysicalDeviceInfo& info, DeviceBenchmarkResult& outResult) const;
+
+    // Run the probes and cache the result, a fraction of a second on a GPU. False if the device isn't measurable.
+    bool Run(const PhysicalDeviceInfo& info, DeviceBenchmarkResult& outResult);
+
+    // Write the cache file, if a probe ran
+    bool Save() const;
+
+private:
+    struct CachedResult
+    {
+        uint32_t driverVersion;
+        DeviceBenchmarkResult result;
+    };
+
+    static std::string GetKey(const PhysicalDeviceInfo& info);
+    void Load();
+
+    std::string m_cacheFile;
+    std::string m_computeShaderFile;
+    std::unordered_map<std::string, CachedResult> m_results;
+    bool m_changed = false;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class UniformRing;
+
+// Packed key, draws are recorded in increasing key order.
+// From the most significant bits: pass (4) | pipeline (12) | material (16) | mesh (12) | depth (20)
+// So state changes follow the cost of the state: pass first, then pipeline, material and mesh.
+using SortKey = uint64_t;
+
+struct SortKeyBits
+{
+    static constexpr uint32_t depth = 20;
+    static constexpr uint32_t mesh = 12;
+    static constexpr uint32_t material = 16;
+    static constexpr uint32_t pipeline = 12;
+    static constexpr uint32_t pass = 4;
+
+    static constexpr uint32_t total = depth + mesh + material + pipeline + pass;
+};
+
+static_assert(SortKeyBits::total == sizeof(SortKey) * 8, "Sort key fields must fill the key");
+
+// Ids are truncated to their field size, depth is expected in [0, 1] and clamped.
+// Use 1 - depth for passes that need back to front ordering (transparency).
+SortKey MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+uint32_t GetSortKeyPass(SortKey key);
+
+// Record passes them all
+constexpr uint32_t allPasses = ~0u;
+
+struct DrawCommand
+{
+    SortKey key = 0;
+
+    // State, only bound when different from the previous draw
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    uint32_t objectOffset = 0; // Dynamic offset in the uniform ring
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize vertexBufferOffset = 0;
+
+    uint32_t vertexCount = 0;
+    uint32_t instanceCount = 1;
+    uint32_t firstVertex = 0;
+    uint32_t firstInstance = 0;
+
+    // When set, the draw arguments are read from this buffer instead (a VkDrawIndirectCommand), like the ones
+    // written by the GPU culling. The counts above are then only an upper bound, for the stats.
+    VkBuffer indirectBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indirectOffset = 0;
+};
+
+struct DrawListStats
+{
+    uint32_t draws = 0;
+    uint32_t triangles = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+
+    DrawListStats& operator+=(const DrawListStats& other);
+};
+
+// Draws for a frame. Fill it, sort it, then record it in a command buffer already inside the render pass.
+// Sets bound outside of the list (like the bindless one) stay bound as long as the layouts are compatible.
+class DrawList
+{
+public:
+    void Clear();
+    void Add(const DrawCommand& command);
+
+    // Stable radix sort on the keys
+    void Sort();
+
+    // Record all the draws of a pass (the pass field of their key), skipping binds of state that did not change.
+    // objectSetIndex is the set index of the ring in the pipeline layouts.
+    // The object set and its offset stay bound from one pass to the next in the same command buffer, until Clear:
+    // nothing may bind that set index in between. Pipelines and vertex buffers are bound again in each pass.
+    DrawListStats Record(VkCommandBuffer commandBuffer, const UniformRing& objectRing, uint32_t objectSetIndex,
+                         uint32_t pass = allPasses);
+
+    size_t GetSize() const { return m_commands.size(); }
+
+private:
+    std::vector<DrawCommand> m_commands;
+
+    // Sorted order, indices in m_commands. Commands themselves are not moved.
+    std::vector<uint32_t> m_order;
+
+    // Scratch memory for the sort, kept between frames to avoid allocations
+    std::vector<SortKey> m_keys;
+    std::vector<SortKey> m_keysTemp;
+    std::vector<uint32_t> m_orderTemp;
+
+    // Object set left bound by the last Record
+    VkCommandBuffer m_boundCommandBuffer = VK_NULL_HANDLE;
+    VkPipelineLayout m_boundLayout = VK_NULL_HANDLE;
+    uint32_t m_boundObjectOffset = 0;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanRenderer
+{
+struct DynamicResolutionConfig
+{
+    VkDevice device;
+    // Nanoseconds per timestamp tick, and the bits the graphics queue writes
+    float timestampPeriod;
+    uint32_t timestampValidBits;
+    uint32_t framesInFlight;
+    // GPU time of a frame to stay under, in milliseconds
+    float targetFrameTime;
+    // Bounds of the scale applied to both sides of the viewports
+    float minScale;
+    float maxScale;
+};
+
+// Resolution of the scene driven by the GPU frame time.
+// Each command buffer is wrapped in two timestamps. Once its fence is waited on, the time between them updates a
+// smoothed frame time, and the scale follows it: quickly down when over the target, to absorb load spikes instead
+// of missing frames, slowly back up when there is room again.
+// The scene is then rendered in the top left corner of its target, and upscaled to the viewport.
+class DynamicResolution
+{
+public:
+    DynamicResolution(DynamicResolutionConfig& config);
+    ~DynamicResolution();
+
+    bool IsValid() const { return m_queryPool != VK_NULL_HANDLE; }
+
+    // To be called once the fence of this frame has been waited on, before recording it again
+    void BeginFrame(uint32_t frameIndex);
+
+    // First and last commands of the frame command buffer, outside of any render pass
+    void RecordStart(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    void RecordEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+    float GetScale() const { return m_scale; }
+    // Extent to render for a viewport of the given extent, at least a pixel
+    VkExtent2D GetRenderExtent(VkExtent2D extent) const;
+    // Smoothed, in milliseconds. 0 until the first frame is measured.
+    float GetFrameTime() const { return m_frameTime; }
+    // Last frame measured, in microseconds
+    uint64_t GetLastFrameMicroseconds() const { return m_lastFrameMicroseconds; }
+
+private:
+    void UpdateScale(float frameTime);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;
+    float m_timestampPeriod = 1.f;
+    uint64_t m_timestampMask = ~0ull;
+
+    // Frames whose timestamps were recorded, and not read yet
+    std::vector<bool> m_pending;
+
+    float m_targetFrameTime = 0.f;
+    float m_minScale = 1.f;
+    float m_maxScale = 1.f;
+    float m_scale = 1.f;
+    float m_frameTime = 0.f;
+    uint64_t m_lastFrameMicroseconds = 0;
+};
+} // namespace VulkanRenderer
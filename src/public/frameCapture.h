@@ -0,0 +1,101 @@
+#pragma once
+
+#include <jobSystem.h>
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VulkanRenderer
+{
+enum class CaptureFormat
+{
+    Png,
+    // Pixels as copied, in the format of the image. Size and format are in the file name.
+    Raw,
+};
+
+struct FrameCaptureConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    JobSystem* jobSystem;
+    // Readback buffers, shared by the copies waiting for the GPU and the encodings waiting for a worker
+    uint32_t bufferCount;
+    std::string outputFolder;
+    CaptureFormat format;
+};
+
+// Copy images to host visible buffers at the end of a frame, and write them to files from the workers.
+// Nothing waits: the copy is read once the frame fence has been waited on anyway, and when all the buffers
+// are busy the capture is skipped.
+class FrameCapture
+{
+public:
+    FrameCapture(FrameCaptureConfig& config);
+    // Wait for the encodings still running. The GPU must be idle.
+    ~FrameCapture();
+
+    // Only 4 bytes per pixel formats can be written
+    static bool IsFormatSupported(VkFormat format);
+    // Blue first, to be swizzled for formats expecting red first
+    static bool IsBgra(VkFormat format);
+
+    // Record the copy outside of a render pass. The image is given back in the same layout.
+    // Views other than 0 get their index in the file name. Return false if the capture is skipped.
+    bool RecordCopy(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber, uint32_t view,
+                    VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout);
+
+    // To be called once the fence of this frame has been waited on: its copies are done, encode them.
+    void BeginFrame(uint32_t frameIndex);
+    // The copies recorded for this frame will never run, its command buffer was not submitted. Counted as skipped.
+    void DiscardFrame(uint32_t frameIndex);
+
+    uint64_t GetWrittenCount() const { return m_writtenCount.load(std::memory_order_relaxed); }
+    uint64_t GetSkippedCount() const { return m_skippedCount; }
+
+private:
+    enum class ReadbackState : uint32_t
+    {
+        Free,
+        Copying,
+        Encoding,
+    };
+
+    struct Readback
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+
+        // Only Encoding to Free happens on a worker
+        std::atomic<ReadbackState> state = ReadbackState::Free;
+        uint32_t frameIndex = 0;
+        uint64_t frameNumber = 0;
+        uint32_t view = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+    };
+
+    bool Reserve(Readback& readback, VkDeviceSize size);
+    void Release(Readback& readback);
+    void Encode(Readback& readback);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    JobSystem* m_jobSystem = nullptr;
+    std::string m_outputFolder;
+    CaptureFormat m_format = CaptureFormat::Png;
+
+    std::vector<std::unique_ptr<Readback>> m_readbacks;
+    JobCounter m_encodings;
+
+    std::atomic<uint64_t> m_writtenCount = 0;
+    uint64_t m_skippedCount = 0;
+};
+} // namespace VulkanRenderer
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <pipelineRegistry.h>
+#include <shaderPermutation.h>
 #include <vulkan/vulkan.h>
 
 #include <array>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace VulkanRenderer
 {
@@ -16,10 +21,43 @@ struct GraphicPipelineConfig
     uint32_t viewportHeight;
     const char* vertShaderFile;
     const char* fragShaderFile;
+    // Already loaded SPIR-V, used instead of the files when set
+    const std::vector<char>* vertShaderCode = nullptr;
+    const std::vector<char>* fragShaderCode = nullptr;
     const char* pipelineName;
     VkFormat swapChainFormat;
+    // More than one sample renders to a transient multisampled attachment, resolved in the swap chain image
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    // Reverse-Z, see SceneRenderPassDesc
+    VkFormat depthFormat;
+    bool depthPrepass = false;
+    // Depth left readable by compute shaders once rendered
+    bool keepDepth = false;
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    // Variant created with the pipeline, others are created on first use.
+    ShaderFeatureMask defaultFeatures;
+    // The variants are shared with the other pipelines of the same state
+    PipelineRegistry* registry;
+    // Frames the command buffers may still use the pipelines after they are replaced
+    uint32_t framesInFlight = 1;
 };
 
+// Shader modules and the variants created from them, replaced as a whole when the shaders are reloaded
+struct GraphicProgram
+{
+    GraphicProgram(PipelineRegistry* registry);
+    // Release the variants to the registry
+    ~GraphicProgram();
+
+    PipelineRegistry* registry;
+    std::unique_ptr<Shader> vertShader;
+    std::unique_ptr<Shader> fragShader;
+    std::unordered_map<ShaderFeatureMask, PipelineRegistry::Handle> pipelines;
+    std::unordered_map<ShaderFeatureMask, PipelineRegistry::Handle> depthPipelines;
+};
+
+// The render pass and the layout are created once, the program can be rebuilt from new SPIR-V while running.
 class GraphicPipeline
 {
 public:
@@ -28,24 +66,62 @@ public:
 
     VkViewport& GetViewport() { return m_viewport; }
     VkRenderPass& GetRenderPass() { return m_renderPass; }
-    VkPipeline& GetPipeline() { return m_pipeline; }
+    VkSampleCountFlagBits GetSamples() const { return m_samples; }
+    VkPipeline GetPipeline() { return GetPipeline(m_defaultFeatures); }
+    // Return the variant specialized for these features, creating it if needed. VK_NULL_HANDLE on failure.
+    // Drawn in the color subpass, the last one.
+    VkPipeline GetPipeline(ShaderFeatureMask features);
+    // Same for the depth only variant, drawn in the prepass subpass. VK_NULL_HANDLE without prepass.
+    VkPipeline GetDepthPipeline(ShaderFeatureMask features);
+    bool HasDepthPrepass() const { return m_depthPrepass; }
+    ShaderFeatureMask GetDefaultFeatures() const { return m_defaultFeatures; }
+    VkPipelineLayout& GetPipelineLayout() { return m_pipelineLayout; }
     VkRect2D& GetScissors() { return m_scissors; }
+    // Variants created so far, to create them again when the shaders change
+    std::vector<ShaderFeatureMask> GetFeatureVariants() const;
 
     bool IsValid() const;
 
+    // Create the shaders and the given variants from new SPIR-V, with the same render pass and layout.
+    // Can run on any thread while the current program is in use. Null on failure.
+    std::unique_ptr<GraphicProgram> CreateProgram(const std::vector<char>& vertCode, const std::vector<char>& fragCode,
+                                                  const std::vector<ShaderFeatureMask>& features) const;
+    // Use this program for the next recordings, between two frames. The previous one is destroyed once the frames in
+    // flight are done with it, no need to wait for the device.
+    void SwapProgram(std::unique_ptr<GraphicProgram> program);
+    // To be called once the fence of a frame has been waited on, destroy the programs no frame uses anymore
+    void BeginFrame();
+
 private:
+    struct RetiredProgram
+    {
+        std::unique_ptr<GraphicProgram> program;
+        uint32_t framesLeft;
+    };
+
     void CreatePipelineLayoutAndPipeline(GraphicPipelineConfig& config);
     void CreateRenderPass(GraphicPipelineConfig& config);
+    std::unique_ptr<GraphicProgram> CreateProgram(std::unique_ptr<Shader> vertShader,
+                                                  std::unique_ptr<Shader> fragShader,
+                                                  const std::vector<ShaderFeatureMask>& features) const;
+    PipelineRegistry::Handle CreatePipelineVariant(const GraphicProgram& program, ShaderFeatureMask features,
+                                                   bool depthOnly) const;
 
     VkDevice m_deviceCache;
-    std::unique_ptr<Shader> m_vertShader;
-    std::unique_ptr<Shader> m_fragShader;
+    std::unique_ptr<GraphicProgram> m_program;
+    std::vector<RetiredProgram> m_retiredPrograms;
+    uint32_t m_framesInFlight;
 
     VkViewport m_viewport;
     VkRect2D m_scissors;
 
     VkRenderPass m_renderPass;
     VkPipelineLayout m_pipelineLayout;
-    VkPipeline m_pipeline;
+    VkSampleCountFlagBits m_samples;
+    bool m_depthPrepass;
+
+    std::string m_entryPoint;
+    PipelineRegistry* m_registry;
+    ShaderFeatureMask m_defaultFeatures;
 };
 } // namespace VulkanRenderer
\ No newline at end of file
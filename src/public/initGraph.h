@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class JobSystem;
+
+using InitStepId = uint32_t;
+
+enum class InitThread : uint8_t
+{
+    Any,  // Run on a job system worker
+    Main, // Run on the thread calling Run (window system calls for example)
+};
+
+// Init steps and their dependencies. Steps run as soon as all their dependencies are done,
+// so independent steps overlap. A step returns 0 on success, the first error stops the init.
+class InitGraph
+{
+public:
+    // Dependencies must be already added steps, which keeps the graph acyclic.
+    InitStepId AddStep(const char* name, std::function<int()> function, std::vector<InitStepId> dependencies = {},
+                       InitThread thread = InitThread::Any);
+
+    // Return 0, or the error of the first failed step.
+    // Without a job system, steps run one after the other in the order they were added.
+    int Run(JobSystem* jobSystem);
+
+    // Start and duration of each step, relative to the start of Run
+    void DumpTimings(std::ostream& stream) const;
+
+private:
+    struct Step
+    {
+        const char* name = nullptr;
+        std::function<int()> function;
+        InitThread thread;
+        std::vector<InitStepId> dependents;
+        uint32_t dependencyCount = 0;
+
+        // Filled by Run
+        uint32_t remainingDependencies = 0;
+        std::chrono::steady_clock::duration start{};
+        std::chrono::steady_clock::duration duration{};
+        bool done = false;
+        bool failed = false;
+    };
+
+    int RunSerial();
+    int RunParallel(JobSystem& jobSystem);
+    void Execute(InitStepId stepId);
+    // Called when a step succeeded. Return the dependents that are now ready.
+    std::vector<InitStepId> Complete(InitStepId stepId);
+
+    std::vector<Step> m_steps;
+    std::chrono::steady_clock::time_point m_runStart;
+
+    // Protects the dependency counts, the main thread queue and the error
+    std::mutex m_mutex;
+    std::vector<InitStepId> m_mainQueue;
+    int m_error = 0;
+};
+} // namespace VulkanRenderer
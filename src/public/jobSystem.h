@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class JobSystem;
+
+// Number of jobs still running. Jobs increment it when scheduled and decrement it when done.
+// Wait on it with JobSystem::Wait, or co_await JobSystem::WaitFor from a Task.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> m_count = 0;
+
+    // Coroutines suspended until the count reaches zero
+    std::mutex m_waitersMutex;
+    std::vector<std::coroutine_handle<>> m_waiters;
+};
+
+// Coroutine run by the JobSystem. Starts suspended, and only runs once given to JobSystem::Run.
+// Inside, co_await jobSystem.Schedule() to hop to a worker, or jobSystem.WaitFor(counter)
+// to suspend until other jobs are done, without blocking the thread.
+class Task
+{
+public:
+    struct promise_type
+    {
+        JobSystem* jobSystem = nullptr;
+        JobCounter* counter = nullptr;
+
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const {}
+        void unhandled_exception() const { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept;
+    Task& operator=(Task&& other) noexcept;
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task();
+
+private:
+    friend class JobSystem;
+
+    explicit Task(std::coroutine_handle<promise_type> handle);
+    std::coroutine_handle<promise_type> Release();
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+struct JobSystemConfig
+{
+    // 0 to use one worker per hardware thread, minus the calling one
+    uint32_t workerCount;
+};
+
+// Work stealing scheduler shared by all the subsystems.
+// Each worker owns a lock free deque: it pushes and pops its own jobs at one end, idle workers steal at the other.
+// Threads that are not workers push in a shared queue.
+// The thread creating the JobSystem is registered too, and runs jobs while it waits on a counter.
+class JobSystem
+{
+public:
+    JobSystem(JobSystemConfig& config);
+    ~JobSystem();
+
+    void Run(std::function<void()> job, JobCounter* counter = nullptr);
+    void Run(Task task, JobCounter* counter = nullptr);
+
+    // Run other jobs until the counter reaches zero
+    void Wait(JobCounter& counter);
+
+    // Call func(begin, end) on chunks of [0, count), and wait for all of them
+    void ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t, size_t)>& func);
+
+    // Worker threads, plus the thread owning the job system
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    struct ScheduleAwaiter
+    {
+        JobSystem* jobSystem;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const { jobSystem->Resume(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    struct CounterAwaiter
+    {
+        JobCounter* counter;
+
+        // Always checked under the lock of the counter, in await_suspend
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
+    };
+
+    // Continue the coroutine on a worker
+    ScheduleAwaiter Schedule() { return ScheduleAwaiter{this}; }
+    // Suspend the coroutine until the counter reaches zero, then continue on a worker
+    CounterAwaiter WaitFor(JobCounter& counter) { return CounterAwaiter{&counter}; }
+
+private:
+    friend class Task;
+
+    struct Job;
+    struct Worker;
+
+    void Push(Job* job);
+    Job* FindJob(uint32_t workerIndex);
+    void Execute(Job* job);
+    // Delete a job that never ran
+    void Drop(Job* job);
+    void WorkerLoop(uint32_t workerIndex);
+    void Resume(std::coroutine_handle<> handle);
+    void Decrement(JobCounter& counter);
+    uint32_t GetCurrentWorkerIndex() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers; // Index 0 is the owning thread, it has no std::thread
+
+    // Jobs pushed from threads that are not workers
+    std::mutex m_sharedQueueMutex;
+    std::deque<Job*> m_sharedQueue;
+
+    // Jobs pushed but not taken yet, workers sleep on it
+    std::atomic<uint32_t> m_pendingJobs = 0;
+    std::atomic<bool> m_stop = false;
+};
+} // namespace VulkanRenderer
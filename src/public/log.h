@@ -0,0 +1,146 @@
+#pragma once
+
+// Asynchronous logger. LOG_XXX(...) captures its arguments by value in a record pushed to a lock free queue,
+// a background thread formats them with operator<< and writes them. The calling thread never formats,
+// never flushes and never waits: when the queue is full, the record is dropped and counted.
+//
+// Levels under VULKAN_RENDERER_LOG_LEVEL are compiled out. At runtime, Verbose is only written with --verbose.
+//
+// Char arrays, string literals included, are copied in the record itself. Other strings are copied to a std::string,
+// which allocates past its small buffer: wrap a string with static storage in Log::Literal to only capture its pointer.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifndef VULKAN_RENDERER_LOG_LEVEL
+#define VULKAN_RENDERER_LOG_LEVEL 0
+#endif
+
+namespace VulkanRenderer
+{
+enum class LogLevel : uint8_t
+{
+    Verbose = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3,
+};
+
+namespace Log
+{
+// Start the writer thread. Records pushed before are kept in the queue until then.
+void Start();
+// Write what is left in the queue and stop the writer thread.
+void Stop();
+
+// Runtime filter, on top of the compile time one
+void SetLevel(LogLevel level);
+bool IsEnabled(LogLevel level);
+
+// A string living as long as the program, captured as a pointer
+struct Literal
+{
+    const char* text;
+
+    friend std::ostream& operator<<(std::ostream& stream, Literal literal) { return stream << literal.text; }
+};
+
+namespace Detail
+{
+constexpr size_t maxArgumentsSize = 224;
+
+struct Record
+{
+    // Format the arguments in the stream, then destroy them
+    using FormatFunction = void (*)(std::ostream& stream, void* arguments);
+
+    std::chrono::system_clock::time_point time;
+    FormatFunction format = nullptr;
+    LogLevel level = LogLevel::Info;
+    alignas(std::max_align_t) std::byte arguments[maxArgumentsSize];
+};
+
+// Return nullptr when the queue is full. The position is given back to commit the record.
+Record* BeginRecord(uint64_t& outPosition);
+void CommitRecord(uint64_t position);
+
+// A literal can't be told from an array on the stack, both are copied, without allocating
+template <size_t N>
+struct CharArray
+{
+    char text[N];
+
+    CharArray(const char (&source)[N]) { std::memcpy(text, source, N); }
+
+    friend std::ostream& operator<<(std::ostream& stream, const CharArray& array)
+    {
+        return stream.write(array.text, static_cast<std::streamsize>(strnlen(array.text, N)));
+    }
+};
+
+template <typename T>
+struct Capture
+{
+    using Unreferenced = std::remove_cvref_t<T>;
+    using Decayed = std::decay_t<T>;
+
+    static constexpr bool isCharArray =
+        std::is_array_v<Unreferenced> && std::is_same_v<std::remove_extent_t<Unreferenced>, char>;
+    static constexpr bool isString = std::is_same_v<Decayed, const char*> || std::is_same_v<Decayed, char*> ||
+                                     std::is_same_v<Decayed, std::string_view>;
+
+    using Type = std::conditional_t<isCharArray, CharArray<std::extent_v<Unreferenced>>,
+                                    std::conditional_t<isString, std::string, Decayed>>;
+};
+} // namespace Detail
+
+template <typename... Args>
+void Write(LogLevel level, Args&&... args)
+{
+    using Arguments = std::tuple<typename Detail::Capture<Args>::Type...>;
+    static_assert(sizeof(Arguments) <= Detail::maxArgumentsSize, "Too many arguments for a single log record");
+    static_assert(alignof(Arguments) <= alignof(std::max_align_t), "Over aligned log argument");
+
+    if (!IsEnabled(level))
+        return;
+
+    uint64_t position = 0;
+    Detail::Record* record = Detail::BeginRecord(position);
+    if (record == nullptr)
+        return;
+
+    record->time = std::chrono::system_clock::now();
+    record->level = level;
+    new (record->arguments) Arguments(std::forward<Args>(args)...);
+    record->format = [](std::ostream& stream, void* arguments)
+    {
+        Arguments* values = std::launder(static_cast<Arguments*>(arguments));
+        std::apply([&stream](const auto&... value) { (stream << ... << value); }, *values);
+        values->~Arguments();
+    };
+
+    Detail::CommitRecord(position);
+}
+} // namespace Log
+} // namespace VulkanRenderer
+
+#define VULKAN_RENDERER_LOG(level, ...)                                                                         \
+    do                                                                                                         \
+    {                                                                                                          \
+        if constexpr (static_cast<int>(level) >= VULKAN_RENDERER_LOG_LEVEL)                                    \
+            VulkanRenderer::Log::Write(level, __VA_ARGS__);                                                    \
+    } while (false)
+
+#define LOG_VERBOSE(...) VULKAN_RENDERER_LOG(VulkanRenderer::LogLevel::Verbose, __VA_ARGS__)
+#define LOG_INFO(...) VULKAN_RENDERER_LOG(VulkanRenderer::LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) VULKAN_RENDERER_LOG(VulkanRenderer::LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) VULKAN_RENDERER_LOG(VulkanRenderer::LogLevel::Error, __VA_ARGS__)
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanRenderer
+{
+struct MemoryBudgetConfig
+{
+    VkPhysicalDevice physicalDevice;
+    // VK_EXT_memory_budget is enabled on the device
+    bool memoryBudgetSupported;
+    // Fraction of the budget of each heap kept free, resources are evicted past the rest
+    float headroom;
+    // Without VK_EXT_memory_budget, fraction of the heap size taken as the budget: the other processes use some too
+    float fallbackBudget;
+    // A resource used by one of the last framesInFlight frames is never evicted
+    uint32_t framesInFlight;
+};
+
+struct HeapBudget
+{
+    VkDeviceSize size = 0;
+    // What the driver lets this process use before paging, or the fallback fraction of the size
+    VkDeviceSize budget = 0;
+    // Of this process, from the driver, or the sum of the allocations made through Utils::CreateBuffer/CreateImage
+    VkDeviceSize usage = 0;
+    bool deviceLocal = false;
+};
+
+// Keep the memory usage of each heap under the budget the driver gives, before it starts paging.
+// The budgets are read once per frame, from VK_EXT_memory_budget when supported. Resources which can be dropped and
+// created again later are registered as evictable: when a heap goes past its target, the ones used the longest ago
+// are evicted until it is back under.
+class MemoryBudget
+{
+public:
+    using EvictableId = uint64_t;
+    static constexpr EvictableId invalidEvictable = 0;
+
+    MemoryBudget(MemoryBudgetConfig& config);
+
+    // To be called once per frame, once its fence has been waited on, from the thread recording the frames.
+    // Read the budgets, and evict what is needed to get every heap back under its target.
+    void BeginFrame();
+
+    // As read by the last BeginFrame, less what it evicted
+    const std::vector<HeapBudget>& GetHeaps() const { return m_heaps; }
+    // The budgets come from the driver, they are estimated otherwise
+    bool IsDriverBudget() const { return m_memoryBudgetSupported; }
+
+    // A resource made of these allocations, all made through Utils::CreateBuffer/CreateImage. evict must free them,
+    // it is called from BeginFrame, once the frames in flight are done with it. Counts as used this frame.
+    EvictableId AddEvictable(const std::vector<VkDeviceMemory>& memories, std::function<void()> evict);
+    // The resource is used by the frame being recorded
+    void Touch(EvictableId id);
+    // The owner freed the resource itself
+    void RemoveEvictable(EvictableId id);
+
+    // Bytes evicted since the start
+    VkDeviceSize GetEvictedBytes() const { return m_evictedBytes; }
+
+    // VK_EXT_memory_budget gives the usage per heap, to enable on the device when supported
+    static bool IsMemoryBudgetSupported(VkPhysicalDevice physicalDevice);
+
+private:
+    struct Evictable
+    {
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapBytes{};
+        std::function<void()> evict;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    void RefreshHeaps();
+    VkDeviceSize GetTarget(const HeapBudget& heap) const;
+    // Least recently used first, until the heap is under its target
+    void Evict(uint32_t heapIndex);
+
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    bool m_memoryBudgetSupported = false;
+    float m_headroom = 0.0f;
+    float m_fallbackBudget = 1.0f;
+    uint32_t m_framesInFlight = 1;
+
+    std::vector<HeapBudget> m_heaps;
+    // One bit per heap, to warn when it goes over
+    uint32_t m_overBudgetHeaps = 0;
+
+    std::unordered_map<EvictableId, Evictable> m_evictables;
+    EvictableId m_nextId = invalidEvictable + 1;
+    uint64_t m_frameNumber = 0;
+    VkDeviceSize m_evictedBytes = 0;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class MemoryBudget;
+
+enum class Counter : uint32_t
+{
+    Draws = 0,
+    Triangles,
+    PipelineBinds,
+    DescriptorBinds,
+    BytesUploaded,
+    DescriptorAllocations,
+    SwapChainRecreations,
+    FenceWaitMicroseconds,
+    EvictedBytes,
+    Count
+};
+
+// Values that are set, not summed: only the last one matters
+enum class Gauge : uint32_t
+{
+    GpuFrameMicroseconds = 0,
+    RenderScalePercent,
+    Count
+};
+
+struct MetricsConfig
+{
+    // The memory heaps are exported as last read by the budget
+    const MemoryBudget* memoryBudget;
+    // Written every writeInterval, in the Prometheus text format. No file if empty.
+    std::string outputFile;
+    std::chrono::milliseconds writeInterval;
+};
+
+// Per frame counters of the renderer. Counters are added during the frame from any thread, and
+// EndFrame makes them visible through the getters and adds them to the totals since the start.
+// Gauges are only set, and exported with their last value.
+class Metrics
+{
+public:
+    Metrics(MetricsConfig& config);
+
+    // Thread safe
+    void Add(Counter counter, uint64_t value = 1)
+    {
+        m_current[static_cast<uint32_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // Thread safe
+    void Set(Gauge gauge, uint64_t value)
+    {
+        m_gauges[static_cast<uint32_t>(gauge)].store(value, std::memory_order_relaxed);
+    }
+
+    // To be called once per frame, from the thread running the frame loop.
+    void EndFrame();
+
+    uint64_t GetLastFrame(Counter counter) const { return m_lastFrame[static_cast<uint32_t>(counter)]; }
+    uint64_t GetTotal(Counter counter) const { return m_totals[static_cast<uint32_t>(counter)]; }
+    uint64_t GetFrameCount() const { return m_frameCount; }
+    uint64_t GetGauge(Gauge gauge) const
+    {
+        return m_gauges[static_cast<uint32_t>(gauge)].load(std::memory_order_relaxed);
+    }
+
+    static const char* GetName(Counter counter);
+    static const char* GetName(Gauge gauge);
+
+    void Write(std::ostream& stream) const;
+    bool WriteFile(const char* filePath) const;
+
+private:
+    static constexpr uint32_t counterCount = static_cast<uint32_t>(Counter::Count);
+    static constexpr uint32_t gaugeCount = static_cast<uint32_t>(Gauge::Count);
+
+    const MemoryBudget* m_memoryBudget = nullptr;
+    std::string m_outputFile;
+    std::chrono::milliseconds m_writeInterval;
+    std::chrono::steady_clock::time_point m_lastWrite;
+
+    std::array<std::atomic<uint64_t>, counterCount> m_current{};
+    std::array<uint64_t, counterCount> m_lastFrame{};
+    std::array<uint64_t, counterCount> m_totals{};
+    uint64_t m_frameCount = 0;
+
+    std::array<std::atomic<uint64_t>, gaugeCount> m_gauges{};
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <shaderInterface.h>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class ComputePipeline;
+class DescriptorAllocator;
+class DescriptorLayoutCache;
+class UniformRing;
+
+struct OcclusionCullerConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    VkPipelineCache pipelineCache;
+    DescriptorLayoutCache* layoutCache;
+    // The culling parameters are pushed in it, bound as set 1 of the culling pipeline
+    VkDescriptorSetLayout uniformRingLayout;
+    const char* cullShaderFile;
+    const char* pyramidShaderFile;
+    const char* pyramidMultisampleShaderFile;
+    // Samples of the depth buffers the pyramids are built from
+    VkSampleCountFlagBits depthSamples;
+    uint32_t framesInFlight;
+};
+
+// GPU occlusion culling, per viewport.
+// Once a viewport is rendered, its depth is reduced into a hierarchical-Z pyramid: each level keeps the farthest
+// depth of the texels it covers. On the next frame, before the render pass, a compute pass tests the bounding
+// sphere of every instance against the frustum, then against the pyramid, and writes the indirect draws with no
+// instance for the hidden ones. The draws recorded by the CPU read their arguments from there.
+// The pyramid is one frame late: something hidden last frame shows up a frame after it gets visible.
+class OcclusionCuller
+{
+public:
+    OcclusionCuller(OcclusionCullerConfig& config);
+    // The GPU must be done with the culling and the pyramids
+    ~OcclusionCuller();
+
+    bool IsValid() const;
+
+    // To be called once the fence of this frame has been waited on. Upload the instances culled this frame, and
+    // return their draws for the caller to fill, in the same order, with every instance visible. Null on failure.
+    VkDrawIndirectCommand* BeginFrame(uint32_t frameIndex, const std::vector<InstanceData>& instances);
+
+    // Targets are keyed by the viewport id.
+    // Create the pyramid of a viewport, or resize it. The GPU must be done with the previous one.
+    bool PrepareTarget(uint32_t viewport, VkExtent2D depthExtent);
+    bool HasTarget(uint32_t viewport) const;
+    // Once the viewport is gone. The GPU must be done with the pyramid.
+    void ReleaseTarget(uint32_t viewport);
+
+    // Cull the instances of the frame for a viewport, outside of a render pass. Once recorded, the draws are ready
+    // for the draw indirect stage.
+    bool RecordCull(VkCommandBuffer commandBuffer, uint32_t viewport, const glm::mat4& viewProj, UniformRing& ring,
+                    DescriptorAllocator& allocator);
+    VkBuffer GetDrawBuffer(uint32_t viewport) const;
+    static VkDeviceSize GetDrawOffset(uint32_t instance) { return instance * sizeof(VkDrawIndirectCommand); }
+
+    // Reduce the depth just rendered in the viewport with viewProj, for the next frame. The render pass left it
+    // in the depth read only layout, its writes visible to compute shaders. Only its top left depthExtent was
+    // rendered, at most the extent of the target.
+    bool RecordPyramid(VkCommandBuffer commandBuffer, uint32_t viewport, VkImageView depthView,
+                       VkExtent2D depthExtent, const glm::mat4& viewProj, DescriptorAllocator& allocator);
+
+private:
+    struct Buffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+    };
+
+    struct Target
+    {
+        VkImage pyramid = VK_NULL_HANDLE;
+        VkDeviceMemory pyramidMemory = VK_NULL_HANDLE;
+        // All the levels, read by the culling
+        VkImageView pyramidView = VK_NULL_HANDLE;
+        // One per level, written by the reduction
+        std::vector<VkImageView> levelViews;
+        VkExtent2D depthExtent{};
+        VkExtent2D pyramidExtent{};
+
+        // Camera and extent of the depth reduced in the pyramid, false until the first reduction
+        glm::mat4 pyramidViewProj{1.f};
+        VkExtent2D reducedExtent{};
+        bool pyramidBuilt = false;
+        // Image layout defined, the culling can bind it before the first reduction
+        bool pyramidInitialized = false;
+
+        // Per frame in flight
+        std::vector<Buffer> culledDraws;
+    };
+
+    struct Frame
+    {
+        Buffer instances;
+        Buffer draws;
+    };
+
+    bool CreateTarget(Target& target, VkExtent2D depthExtent);
+    void DestroyTarget(Target& target);
+    // Keep the buffer if big enough, otherwise replace it. Its previous content is lost.
+    bool ReserveBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+    void DestroyBuffer(Buffer& buffer);
+    void ReduceLevel(VkCommandBuffer commandBuffer, ComputePipeline& pipeline, VkDescriptorSet descriptorSet,
+                     VkExtent2D sourceExtent, VkExtent2D levelExtent);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    VkSampleCountFlagBits m_depthSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_cullSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_pyramidSetLayout = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePipeline> m_cullPipeline;
+    std::unique_ptr<ComputePipeline> m_pyramidPipeline;
+    // Only for multisampled depth buffers, for the first level
+    std::unique_ptr<ComputePipeline> m_pyramidMultisamplePipeline;
+
+    std::vector<Frame> m_frames;
+    uint32_t m_currentFrame = 0;
+    uint32_t m_instanceCount = 0;
+
+    // By viewport id
+    std::unordered_map<uint32_t, Target> m_targets;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <pipelineRegistry.h>
+#include <shaderInterface.h>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class ComputePipeline;
+class ComputeScheduler;
+class DescriptorAllocator;
+class DescriptorLayoutCache;
+class Shader;
+
+// Modes of shaders/particleControl.comp
+enum class ParticleControlMode : uint32_t
+{
+    Init = 0,
+    PrepareSimulation,
+    PrepareDraw
+};
+
+struct ParticleSystemConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    VkPipelineCache pipelineCache;
+    DescriptorLayoutCache* layoutCache;
+    PipelineRegistry* registry;
+    // Any render pass compatible with those the particles are drawn in, and the subpass they are drawn in
+    VkRenderPass renderPass;
+    uint32_t subpass;
+    VkSampleCountFlagBits samples;
+    const char* emitShaderFile;
+    const char* simulateShaderFile;
+    const char* controlShaderFile;
+    const char* vertShaderFile;
+    const char* fragShaderFile;
+    // Particles alive at once, the emitters wait for free ones past it
+    uint32_t capacity;
+    uint32_t maxEmitters;
+    glm::vec3 gravity;
+    // Fraction of the velocity lost per second
+    float drag;
+};
+
+// Particles simulated and drawn without the CPU ever touching one.
+// Emitters and particles live in device local storage buffers. Each frame, compute passes emit new particles from
+// the free ones, simulate the live ones, and compact them: the survivors are appended to a second list, the dead
+// are given back. The draw of the live particles is a single indirect draw, its instance count written by the
+// compute passes. The CPU only uploads an emitter when it is added.
+class ParticleSystem
+{
+public:
+    ParticleSystem(ParticleSystemConfig& config);
+    // The GPU must be done with the particles
+    ~ParticleSystem();
+
+    bool IsValid() const;
+
+    // Emits from the next update on. False when there is no room left for it.
+    bool AddEmitter(const ParticleEmitterData& emitter);
+
+    // Upload the new emitters, then emit, simulate and compact the particles, on the compute command buffer of the
+    // frame. The buffers the draw reads are then handed to graphics, ready for the draw indirect stage once the
+    // graphics command buffer acquired them (see ComputeScheduler). The sets are allocated from the frame allocator.
+    bool RecordUpdate(ComputeScheduler& scheduler, float deltaTime, DescriptorAllocator& allocator);
+
+    // Draw the particles alive after the last update, in the subpass given at creation. Nothing before the first
+    // update.
+    void RecordDraw(VkCommandBuffer commandBuffer, const CameraData& camera) const;
+
+    uint32_t GetCapacity() const { return m_capacity; }
+    uint32_t GetEmitterCount() const { return static_cast<uint32_t>(m_emitters.size()); }
+
+private:
+    struct Buffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+    };
+
+    bool CreateBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+    void DestroyBuffer(Buffer& buffer);
+    bool CreateDrawPipeline(ParticleSystemConfig& config);
+    void UploadEmitters(VkCommandBuffer commandBuffer);
+    void Dispatch(VkCommandBuffer commandBuffer, ComputePipeline& pipeline, ParticleFrameData frame,
+                  uint32_t groupCount) const;
+    // Between two passes, their writes visible to the next ones, indirect arguments included
+    static void ComputeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage,
+                               VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    PipelineRegistry* m_registry = nullptr;
+    uint32_t m_capacity = 0;
+    uint32_t m_maxEmitters = 0;
+    glm::vec4 m_gravity{0.f};
+
+    Buffer m_emitterBuffer;
+    Buffer m_particleBuffer;
+    Buffer m_deadListBuffer;
+    Buffer m_aliveListBuffer;
+    // Counters and indirect arguments
+    Buffer m_stateBuffer;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePipeline> m_emitPipeline;
+    std::unique_ptr<ComputePipeline> m_simulatePipeline;
+    std::unique_ptr<ComputePipeline> m_controlPipeline;
+
+    std::unique_ptr<Shader> m_vertShader;
+    std::unique_ptr<Shader> m_fragShader;
+    VkPipelineLayout m_drawLayout = VK_NULL_HANDLE;
+    PipelineRegistry::Handle m_drawPipeline = nullptr;
+
+    // Kept to know which ones are uploaded, the GPU has the only up to date remainders
+    std::vector<ParticleEmitterData> m_emitters;
+    uint32_t m_uploadedEmitters = 0;
+
+    bool m_initialized = false;
+    float m_time = 0.f;
+    // Alive list the next update emits to, flipped by each update
+    uint32_t m_aliveList = 0;
+    // Set of the last update, the draws read the particles through it
+    VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace VulkanRenderer
+{
+struct PipelineCacheConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    // Content of a previous run, can be empty. Ignored if it was made by another device or driver.
+    const std::vector<char>* initialData;
+};
+
+// VkPipelineCache persisted between runs, so pipelines already compiled by the driver are not compiled again.
+class PipelineCache
+{
+public:
+    PipelineCache(PipelineCacheConfig& config);
+    ~PipelineCache();
+
+    bool IsValid() const { return m_cache != VK_NULL_HANDLE; }
+    VkPipelineCache GetCache() const { return m_cache; }
+
+    bool Save(const char* filePath) const;
+
+private:
+    // Check the header against the current device, drivers are not all robust to foreign data.
+    static bool IsCompatible(const std::vector<char>& data, VkPhysicalDevice physicalDevice);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <jobSystem.h>
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanRenderer
+{
+// Everything a graphics pipeline is created from, viewport and scissors being dynamic.
+// Equal states give the same pipeline.
+struct GraphicPipelineState
+{
+    struct Stage
+    {
+        VkShaderStageFlagBits stage;
+        // Compared by the hash of their code, another module with the same code gives the same pipeline
+        VkShaderModule module;
+        uint64_t codeHash;
+        std::string entryPoint;
+    };
+
+    std::vector<Stage> stages;
+    // Specialization constants, shared by all the stages
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    std::vector<uint8_t> specializationData;
+
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    bool depthTest = true;
+    bool depthWrite = true;
+    VkCompareOp depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+
+    // One per color attachment of the subpass
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlend;
+    std::vector<VkDynamicState> dynamicStates;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+
+    bool operator==(const GraphicPipelineState& other) const;
+};
+
+struct GraphicPipelineStateHash
+{
+    size_t operator()(const GraphicPipelineState& state) const;
+};
+
+struct PipelineRegistryConfig
+{
+    VkDevice device;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    // Compile the pipelines from libraries, VK_EXT_graphics_pipeline_library is enabled on the device
+    bool useLibraries = false;
+    // Optimizes the fast linked pipelines, only with libraries
+    JobSystem* jobSystem = nullptr;
+    // Frames the command buffers may still use a pipeline after it is replaced
+    uint32_t framesInFlight = 1;
+};
+
+// Graphics pipelines shared by state, so the same state is never compiled twice.
+// The map is split in shards, each behind a reader writer lock: looking up a known state only takes a shared lock
+// on its shard, recording threads don't contend. A new state is compiled once, outside of the locks, the threads
+// asking for it meanwhile wait for that compilation only.
+// Pipelines are reference counted, and destroyed when the last user releases them.
+//
+// With graphics pipeline libraries, the four parts of a state (vertex input, pre-rasterization shaders, fragment
+// shader, fragment output) are compiled on their own and shared by all the states using them. A new state is then
+// only a fast link of its parts, cheap enough for the render thread. The link time optimized pipeline is compiled
+// on a worker, and replaces the fast one at the start of a later frame: users hold a handle, not the pipeline.
+class PipelineRegistry
+{
+    struct Entry;
+
+public:
+    // Stays valid until released, the pipeline behind it may change between frames
+    using Handle = Entry*;
+
+    PipelineRegistry(PipelineRegistryConfig& config);
+    // Wait for the background compilations. The GPU must be done with all the pipelines.
+    ~PipelineRegistry();
+
+    static bool IsLibrarySupported(VkPhysicalDevice physicalDevice);
+    static std::vector<const char*> GetLibraryDeviceExtensions();
+    static VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT GetLibraryFeatures();
+
+    // Take a reference to the pipeline of this state, compiling it on first use. Thread safe.
+    Handle Acquire(const GraphicPipelineState& state);
+    // Give back a reference, the GPU must be done with the pipeline if it is the last one. Thread safe.
+    void Release(Handle handle);
+    // Pipeline to bind now, VK_NULL_HANDLE if it failed to compile. Thread safe.
+    static VkPipeline Get(Handle handle);
+
+    // To be called once the fence of a frame has been waited on, from the thread recording the frames.
+    // Swap in the optimized pipelines compiled since the last frame, destroy those no frame uses anymore.
+    void BeginFrame();
+
+    // Pipelines alive, and compiled since the start, libraries and links included
+    size_t GetPipelineCount() const;
+    uint64_t GetCompileCount() const { return m_compileCount.load(std::memory_order_relaxed); }
+
+private:
+    // The four parts a pipeline is linked from
+    enum class LibraryPart : uint32_t
+    {
+        VertexInput = 0,
+        PreRasterization,
+        FragmentShader,
+        FragmentOutput,
+        Count
+    };
+    static constexpr uint32_t libraryPartCount = static_cast<uint32_t>(LibraryPart::Count);
+    using LibraryParts = std::array<VkPipeline, libraryPartCount>;
+
+    struct Entry
+    {
+        std::once_flag compiled;
+        // Set once compiled, swapped once optimized
+        std::atomic<VkPipeline> pipeline = VK_NULL_HANDLE;
+        // Changed under a lock of the shard, shared to acquire and exclusive to release
+        std::atomic<uint32_t> references = 0;
+        // Key of the entry in its shard
+        const GraphicPipelineState* state = nullptr;
+        uint32_t shard = 0;
+    };
+
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<GraphicPipelineState, std::unique_ptr<Entry>, GraphicPipelineStateHash> entries;
+    };
+
+    static constexpr size_t shardCount = 16;
+    using Shards = std::array<Shard, shardCount>;
+
+    struct Optimized
+    {
+        Entry* entry;
+        VkPipeline pipeline;
+    };
+
+    struct Retired
+    {
+        VkPipeline pipeline;
+        uint32_t framesLeft;
+    };
+
+    template <typename CompileFunc>
+    Entry* AcquireEntry(Shards& shards, const GraphicPipelineState& state, CompileFunc&& compile);
+    void ReleaseEntry(Shards& shards, Entry* entry);
+    size_t CountEntries(const Shards& shards) const;
+
+    VkPipeline Compile(const GraphicPipelineState& state);
+    // Fast link its parts, and start the optimized link. Compiled as a whole if a part fails.
+    VkPipeline CompileFromLibraries(const GraphicPipelineState& state, Entry* entry);
+    VkPipeline CompileLibraryPart(const GraphicPipelineState& partState, LibraryPart part);
+    VkPipeline Link(const LibraryParts& parts, VkPipelineLayout layout, bool optimize);
+    // Only the members of the state the part is created from
+    static GraphicPipelineState GetPartState(const GraphicPipelineState& state, LibraryPart part);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+    bool m_useLibraries = false;
+    JobSystem* m_jobSystem = nullptr;
+    uint32_t m_framesInFlight = 1;
+
+    Shards m_pipelines;
+    // Kept until the registry is destroyed, few of them are shared by many pipelines
+    std::array<Shards, libraryPartCount> m_libraries;
+
+    // Optimized links waiting for the next frame, and the pipelines they replaced
+    std::mutex m_optimizedMutex;
+    std::vector<Optimized> m_optimized;
+    std::vector<Retired> m_retired;
+    JobCounter m_optimizations;
+
+    std::atomic<uint64_t> m_compileCount = 0;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <shaderInterface.h>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class ComputePipeline;
+class DescriptorAllocator;
+class DescriptorLayoutCache;
+class RenderTarget;
+
+// Effects of the chain, in the order they are applied.
+// The value is the bit in PostProcessData::effects (see shaders/postProcess.comp).
+enum class PostEffect : uint32_t
+{
+    Tonemap = 0,
+    ColorGrading,
+    Sharpen,
+    Vignette,
+    FilmGrain,
+
+    Count
+};
+
+using PostEffectMask = uint32_t;
+
+constexpr PostEffectMask PostEffectBit(PostEffect effect) { return PostEffectMask(1) << static_cast<uint32_t>(effect); }
+
+struct PostProcessConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    VkPipelineCache pipelineCache;
+    DescriptorLayoutCache* layoutCache;
+    const char* shaderFile;
+    // Format of the pipelines render pass, the scene is rendered in it before being post-processed
+    VkFormat sceneFormat;
+    VkSampleCountFlagBits samples;
+    VkFormat depthFormat;
+    bool depthPrepass;
+    // Scene depth left readable by compute shaders once rendered
+    bool keepDepth;
+    PostEffectMask effects;
+};
+
+// Post-processing run after the main pass, as a single compute dispatch working on shared memory tiles.
+// All the enabled effects are fused: the scene is read once and the result written once, instead of one
+// full-screen pass per effect. The result is then blitted into the viewport image, upscaled when the scene was
+// rendered at a lower resolution. With no effect, the scene is blitted directly.
+// When the formats can't be blitted, the result is copied instead: the shader writes it in the viewport encoding,
+// and the scene is never upscaled.
+// Each viewport gets its own target: the scene image it is rendered to, and the output of the dispatch.
+class PostProcess
+{
+public:
+    PostProcess(PostProcessConfig& config);
+    // The GPU must be done with the targets
+    ~PostProcess();
+
+    bool IsValid() const;
+
+    // Comma separated effect names: tonemap, grading, sharpen, vignette, grain. False on an unknown name.
+    static bool ParseEffects(const std::string& text, PostEffectMask& outEffects);
+
+    PostProcessData& GetSettings() { return m_settings; }
+
+    // The scene can be rendered at a lower resolution than the viewports
+    bool CanUpscale() const { return m_settings.effects != 0 ? m_blitOutput : m_blitScene; }
+
+    // Compatible with the pipelines, the color is left ready to be sampled
+    VkRenderPass GetSceneRenderPass() const { return m_sceneRenderPass; }
+
+    // Targets are keyed by the viewport id.
+    // Create the target of a viewport, or resize it. The GPU must be done with the previous one.
+    bool PrepareTarget(uint32_t viewport, VkExtent2D extent);
+    bool HasTarget(uint32_t viewport) const;
+    // Once the viewport is gone. The GPU must be done with the target.
+    void ReleaseTarget(uint32_t viewport);
+    VkFramebuffer GetSceneFramebuffer(uint32_t viewport) const;
+    VkImageView GetSceneDepthView(uint32_t viewport) const;
+
+    // Post-process the scene rendered in the top left renderExtent of the target framebuffer, and blit the result
+    // into the whole dstImage, left in dstFinalLayout. dstImage content is discarded, its first use must be
+    // synchronized on the color attachment output stage, like a render pass would. The descriptor set lives for
+    // the frame.
+    bool Record(VkCommandBuffer commandBuffer, uint32_t viewport, DescriptorAllocator& allocator, uint32_t frame,
+                VkExtent2D renderExtent, VkImage dstImage, VkImageLayout dstFinalLayout);
+
+private:
+    struct Target
+    {
+        std::unique_ptr<RenderTarget> scene;
+        VkImage output = VK_NULL_HANDLE;
+        VkDeviceMemory outputMemory = VK_NULL_HANDLE;
+        VkImageView outputView = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+    };
+
+    bool CreateTarget(Target& target, VkExtent2D extent);
+    void DestroyTarget(Target& target);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    VkFormat m_sceneFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits m_samples = VK_SAMPLE_COUNT_1_BIT;
+    VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
+    bool m_keepDepth = false;
+
+    // Formats support the blits into the viewports, otherwise the results are copied
+    bool m_blitScene = false;
+    bool m_blitOutput = false;
+    uint32_t m_copyOutputFlags = 0;
+
+    VkRenderPass m_sceneRenderPass = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePipeline> m_pipeline;
+    PostProcessData m_settings{};
+
+    // By viewport id
+    std::unordered_map<uint32_t, Target> m_targets;
+};
+} // namespace VulkanRenderer
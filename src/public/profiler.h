@@ -0,0 +1,56 @@
+#pragma once
+
+// CPU profiler zones. Only compiled with the VULKAN_RENDERER_PROFILER CMake option, otherwise all the macros
+// are empty and the profiler costs nothing.
+//
+// PROFILE_SCOPE("Name") records a begin event, and the matching end event when the scope exits.
+// Names must have static storage (string literals), only the pointer is recorded.
+// PROFILE_DUMP("file.json") writes all the recorded events as a Chrome trace, to open in Perfetto
+// or chrome://tracing.
+
+#if defined(VULKAN_RENDERER_PROFILER)
+
+#include <cstdint>
+
+namespace VulkanRenderer
+{
+namespace Profiler
+{
+// Each thread writes in its own lock free ring buffer, oldest events are overwritten when it is full.
+void BeginEvent(const char* name);
+void EndEvent();
+
+// Name shown for the calling thread in the trace
+void SetThreadName(const char* name);
+
+// Can be called from any thread, while the others keep recording.
+bool DumpChromeTrace(const char* filePath);
+} // namespace Profiler
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) { Profiler::BeginEvent(name); }
+    ~ProfileScope() { Profiler::EndEvent(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+} // namespace VulkanRenderer
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(name) VulkanRenderer::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD_NAME(name) VulkanRenderer::Profiler::SetThreadName(name)
+#define PROFILE_DUMP(filePath) VulkanRenderer::Profiler::DumpChromeTrace(filePath)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_DUMP(filePath) false
+
+#endif
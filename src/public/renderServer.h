@@ -0,0 +1,162 @@
+#pragma once
+
+#include <frameCapture.h>
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace VulkanRenderer
+{
+// One line per request, space separated key=value pairs:
+//   id=NAME                    Echoed in the replies. Defaults to the index of the request on the connection.
+//   width=W height=H           Required.
+//   frames=N                   Default 1.
+//   scene=NAME                 Only "default" for now.
+//   camera=EX,EY,EZ,TX,TY,TZ[,FOV]  Eye and target, vertical field of view in degrees. Default identity.
+//   format=png|raw             Default png. Raw pixels are sent as rendered, bgra or rgba.
+// Replies, several requests of a connection may be answered interleaved:
+//   frame ID INDEX ENCODING WIDTH HEIGHT SIZE\n followed by SIZE bytes
+//   done ID\n
+//   error ID MESSAGE\n
+struct RenderRequest
+{
+    std::string id;
+    std::string scene = "default";
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t frameCount = 1;
+    // Same as the interactive mode when no camera is given
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    CaptureFormat format = CaptureFormat::Png;
+};
+
+// A client socket. Shared by the jobs of the client, closed once the client is gone and its last job answered.
+// Sends never block: a reply is written as far as the socket takes it, the rest is queued and flushed by the I/O
+// thread. A client that stops reading is dropped.
+class RenderConnection
+{
+public:
+    // The socket must be non-blocking
+    explicit RenderConnection(int socket);
+    ~RenderConnection();
+    RenderConnection(const RenderConnection&) = delete;
+    RenderConnection& operator=(const RenderConnection&) = delete;
+
+    int GetSocket() const { return m_socket; }
+
+    // Replies are sent in the order they were reserved, whichever thread completes them first.
+    // Reserve count replies and return the first one.
+    uint64_t ReserveReplies(uint32_t count);
+
+    // Thread safe, each message is sent whole. Return false once the client is gone.
+    bool SendFrame(uint64_t reply, const std::string& id, uint32_t frame, const char* encoding, uint32_t width,
+                   uint32_t height, const std::vector<uint8_t>& data);
+    bool SendDone(uint64_t reply, const std::string& id);
+    // Reserves its reply
+    bool SendError(const std::string& id, const std::string& message);
+
+    // Too many replies not sent yet, its next jobs should wait
+    bool IsBacklogged() const;
+    bool IsBroken() const;
+
+    // I/O thread, when the socket is writable or the queue not empty. Return false once the client is gone.
+    bool HasOutput() const;
+    bool Flush();
+
+private:
+    // m_sendMutex held
+    bool Complete(uint64_t reply, std::string message);
+    void WriteOutput();
+    void Drop(const char* reason);
+
+    int m_socket = -1;
+    mutable std::mutex m_sendMutex;
+    uint64_t m_reservedReplies = 0;
+    // Moved to the output, in order
+    uint64_t m_queuedReplies = 0;
+    // Completed before the replies reserved ahead of them
+    std::map<uint64_t, std::string> m_completedReplies;
+    // Only from m_outputOffset on is left to send
+    std::string m_output;
+    size_t m_outputOffset = 0;
+    // Last time the client read some of the output, or when it stopped being empty
+    std::chrono::steady_clock::time_point m_lastProgress;
+    bool m_broken = false;
+};
+
+struct RenderJob
+{
+    RenderRequest request;
+    std::shared_ptr<RenderConnection> connection;
+    // Frames already rendered, a job can span several batches
+    uint32_t renderedFrames = 0;
+};
+
+struct RenderServerConfig
+{
+    // Unix domain socket, replaced if it already exists
+    std::string socketPath;
+    uint32_t maxImageSize;
+    uint32_t maxFrameCount;
+};
+
+// Accept render jobs over a Unix domain socket. A thread reads the requests, the renderer takes the jobs
+// with WaitForJobs and answers them through their connection.
+class RenderServer
+{
+public:
+    RenderServer(RenderServerConfig& config);
+    // Stop accepting requests, the replies already queued get a moment to be flushed.
+    // Connections stay open until their pending jobs are answered.
+    ~RenderServer();
+
+    bool IsValid() const { return m_listenSocket >= 0; }
+
+    // SIGINT or SIGTERM received
+    bool IsStopRequested() const;
+
+    // Wait until jobs are waiting, or the timeout, and take them all
+    std::vector<RenderJob> WaitForJobs(std::chrono::milliseconds timeout);
+
+    // Return false with a message if the request is malformed or out of the limits
+    bool ParseRequest(const std::string& line, RenderRequest& outRequest, std::string& outError) const;
+
+private:
+    struct Client
+    {
+        std::shared_ptr<RenderConnection> connection;
+        std::string pending; // Received, not a whole line yet
+        uint32_t requestCount = 0;
+        // Kept until its replies are flushed once it stopped sending
+        bool receiving = true;
+    };
+
+    void IoLoop();
+    void Accept();
+    // Return false when the client stopped sending
+    bool Receive(Client& client);
+
+    std::string m_socketPath;
+    uint32_t m_maxImageSize = 0;
+    uint32_t m_maxFrameCount = 0;
+
+    int m_listenSocket = -1;
+    std::vector<Client> m_clients; // Only touched by the I/O thread
+    std::thread m_ioThread;
+    std::atomic<bool> m_stop = false;
+
+    std::mutex m_jobsMutex;
+    std::condition_variable m_jobsAvailable;
+    std::vector<RenderJob> m_jobs;
+};
+} // namespace VulkanRenderer
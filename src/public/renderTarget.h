@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class Attachment;
+
+// Attachments and subpasses of the render passes drawing the scene.
+// Passes created from the same description are compatible, whatever their final layouts and store operations.
+struct SceneRenderPassDesc
+{
+    VkFormat colorFormat;
+    // Reverse-Z: cleared to 0, nearer fragments have a greater depth
+    VkFormat depthFormat;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    // Depth only subpass first, the color subpass then only shades the visible fragments
+    bool depthPrepass = false;
+};
+
+struct RenderTargetConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    // Any render pass compatible with the pipelines drawing into the target
+    VkRenderPass renderPass;
+    VkFormat format;
+    VkExtent2D extent;
+    // Also create a host visible buffer the image can be copied to
+    bool readback = false;
+    // Added to the color attachment and transfer source usages
+    VkImageUsageFlags usage = 0;
+    // Rendered multisampled, and resolved in the image at the end of the render pass
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkFormat depthFormat;
+    // Depth stored and left readable by compute shaders, see CreateRenderPass
+    bool keepDepth = false;
+};
+
+// Color image rendered offscreen, with its depth buffer, view and framebuffer.
+class RenderTarget
+{
+public:
+    RenderTarget(RenderTargetConfig& config);
+    // The GPU must be done with the target
+    ~RenderTarget();
+
+    bool IsValid() const { return m_framebuffer != VK_NULL_HANDLE; }
+
+    // Color attachment cleared then stored, left in finalLayout, and the depth attachment.
+    // Attachments are the color samples, the depth, then the image they are resolved in when multisampled.
+    // The depth is transient, unless kept: then it is stored and left in the depth read only layout, its writes
+    // made visible to compute shaders.
+    static VkRenderPass CreateRenderPass(VkDevice device, const SceneRenderPassDesc& desc, VkImageLayout finalLayout,
+                                         bool keepDepth = false);
+
+    // Record the copy of the image, in the transfer source layout, to the readback buffer.
+    // The data can be read once the submission is done.
+    void RecordReadback(VkCommandBuffer commandBuffer) const;
+    // Pixels tightly packed, 4 bytes each
+    const void* GetReadbackData() const { return m_readbackMapped; }
+
+    VkImage GetImage() const { return m_image; }
+    VkImageView GetImageView() const { return m_imageView; }
+    VkFramebuffer GetFramebuffer() const { return m_framebuffer; }
+    VkImageView GetDepthView() const;
+    VkFormat GetFormat() const { return m_format; }
+    VkExtent2D GetExtent() const { return m_extent; }
+    // Allocations of the image, attachments and readback buffer
+    std::vector<VkDeviceMemory> GetMemories() const;
+
+private:
+    bool CreateImage(RenderTargetConfig& config);
+    bool CreateReadback(RenderTargetConfig& config);
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkFormat m_format = VK_FORMAT_UNDEFINED;
+    VkExtent2D m_extent{};
+
+    VkImage m_image = VK_NULL_HANDLE;
+    VkDeviceMemory m_imageMemory = VK_NULL_HANDLE;
+    VkImageView m_imageView = VK_NULL_HANDLE;
+    VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+    std::unique_ptr<Attachment> m_multisample;
+    std::unique_ptr<Attachment> m_depth;
+
+    VkBuffer m_readbackBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_readbackMemory = VK_NULL_HANDLE;
+    void* m_readbackMapped = nullptr;
+};
+} // namespace VulkanRenderer
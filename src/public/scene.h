@@ -0,0 +1,94 @@
+#pragma once
+
+#include <shaderInterface.h>
+#include <shaderPermutation.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanRenderer
+{
+class JobSystem;
+
+using EntityId = uint32_t;
+constexpr EntityId invalidEntity = ~0u;
+
+// Bounding sphere, in the local space of the node
+struct Bounds
+{
+    glm::vec3 center = glm::vec3(0.f);
+    float radius = 0.f;
+};
+
+struct RenderComponent
+{
+    uint32_t mesh = 0;
+    uint32_t material = 0;
+    ShaderFeatureMask features = 0;
+};
+
+// Scene nodes, stored as structure of arrays indexed by EntityId.
+// Nodes are also grouped by depth in the hierarchy: Update goes through the levels in order,
+// and the nodes of a level are processed in parallel since they only read their parent, from a previous level.
+// Only nodes whose local transform changed, and their children, are recomputed.
+// Renderable nodes get an InstanceData, packed in a contiguous array ready to be uploaded.
+class Scene
+{
+public:
+    Scene(JobSystem& jobSystem);
+
+    void Reserve(size_t nodeCount);
+
+    // Parent must already exist, so a parent is always in a lower level than its children.
+    EntityId CreateNode(EntityId parent = invalidEntity);
+
+    void SetLocalTransform(EntityId entity, const glm::mat4& transform);
+    void SetBounds(EntityId entity, const Bounds& bounds);
+    // Make the node renderable, or update its render data
+    void SetRenderComponent(EntityId entity, const RenderComponent& component);
+
+    const glm::mat4& GetLocalTransform(EntityId entity) const { return m_localTransforms[entity]; }
+    // Up to date after Update
+    const glm::mat4& GetWorldTransform(EntityId entity) const { return m_worldTransforms[entity]; }
+    EntityId GetParent(EntityId entity) const { return m_parents[entity]; }
+
+    // Recompute world transforms and instances of dirty subtrees
+    void Update();
+
+    const std::vector<InstanceData>& GetInstances() const { return m_instances; }
+    size_t GetNodeCount() const { return m_parents.size(); }
+    // Number of nodes recomputed by the last Update
+    size_t GetLastUpdatedCount() const { return m_lastUpdatedCount; }
+
+private:
+    void MarkDirty(EntityId entity);
+    void UpdateNode(EntityId entity);
+    void WriteInstance(EntityId entity);
+
+    JobSystem& m_jobSystem;
+
+    // Per node
+    std::vector<EntityId> m_parents;
+    std::vector<uint32_t> m_levelIndices;
+    std::vector<glm::mat4> m_localTransforms;
+    std::vector<glm::mat4> m_worldTransforms;
+    std::vector<Bounds> m_localBounds;
+    std::vector<uint8_t> m_dirty;
+    // Update index of the last world transform change, so children know when to follow.
+    std::vector<uint32_t> m_changedAt;
+    std::vector<uint32_t> m_instanceIndices;
+
+    // Per depth level, nodes in creation order
+    std::vector<std::vector<EntityId>> m_levels;
+    std::vector<uint8_t> m_dirtyLevels;
+
+    // Per renderable node
+    std::vector<RenderComponent> m_renderComponents;
+    std::vector<InstanceData> m_instances;
+
+    uint32_t m_updateIndex = 0;
+    size_t m_lastUpdatedCount = 0;
+};
+} // namespace VulkanRenderer
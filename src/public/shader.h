@@ -14,6 +14,7 @@ enum class ShaderType : uint8_t
 {
     Vertex = 0,
     Fragment = 1,
+    Compute = 2,
 
     Count = 255
 };
@@ -28,12 +29,18 @@ public:
     VkShaderModule_T* GetModule() { return m_module; }
     const VkShaderModule_T* GetConstModule() const { return m_module; }
     ShaderType GetType() const { return m_type; }
+    // Of the SPIR-V, equal for modules created from the same code
+    uint64_t GetCodeHash() const { return m_codeHash; }
 
     static std::unique_ptr<Shader> CreateFromFile(VkDevice_T* device, ShaderType type, const char* filePath);
+    // From the already loaded byte code when given, from the file otherwise. Null on failure.
+    static std::unique_ptr<Shader> Create(VkDevice_T* device, ShaderType type, const std::vector<char>* byteCode,
+                                          const char* filePath);
 
 private:
     VkDevice_T* m_deviceCache;
     VkShaderModule_T* m_module;
     ShaderType m_type;
+    uint64_t m_codeHash;
 };
 } // namespace VulkanRenderer
\ No newline at end of file
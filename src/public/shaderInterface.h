@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace VulkanRenderer
+{
+// Data shared with the shaders. Layouts must match the GLSL declarations.
+
+// Descriptor set indices
+constexpr uint32_t bindlessSetIndex = 0; // BindlessHeap, or an empty set when not supported
+constexpr uint32_t objectSetIndex = 1;   // UniformRing, per draw data through dynamic offsets
+
+// Per draw, uniform buffer (std140)
+struct ObjectData
+{
+    glm::mat4 model;
+};
+
+// Per instance, storage buffer (std430). Written by the Scene, ready for upload.
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::vec4 boundingSphere; // World space center (xyz) and radius (w)
+    uint32_t mesh;
+    uint32_t material;
+    uint32_t features; // ShaderFeatureMask
+    uint32_t entity;
+};
+
+static_assert(sizeof(InstanceData) % 16 == 0, "InstanceData must keep a std430 friendly size");
+
+// Push constants
+struct CameraData
+{
+    glm::mat4 viewProj;
+};
+
+// Occlusion culling parameters, uniform buffer (std140), see shaders/occlusionCull.comp
+struct CullData
+{
+    glm::mat4 viewProj;        // Frustum test, camera of this frame
+    glm::mat4 pyramidViewProj; // Occlusion test, camera the depth pyramid was rendered with
+    glm::vec2 depthSize;       // Size of the depth rendered, the pyramid was reduced from
+    uint32_t instanceCount;
+    uint32_t pyramidLevels; // 0 when there is no pyramid yet, only the frustum test is done
+};
+
+// Depth pyramid reduction push constants, see shaders/depthPyramid.glsl
+struct DepthReductionData
+{
+    glm::ivec2 sourceSize;
+    glm::ivec2 levelSize;
+};
+
+// Post-processing push constants, see shaders/postProcess.comp
+struct PostProcessData
+{
+    uint32_t effects; // PostEffectMask
+    uint32_t frame;   // Film grain seed
+    float exposure;
+    float saturation;
+    float contrast;
+    float sharpenStrength;
+    float vignetteStrength;
+    float grainStrength;
+    // Part of the scene rendered, in its top left corner
+    uint32_t renderWidth;
+    uint32_t renderHeight;
+    // Encoding of the output when it is copied into the viewport instead of blitted: red and blue swapped (bit 0),
+    // sRGB (bit 1)
+    uint32_t outputFlags;
+};
+
+// GPU particles, see shaders/particles.glsl
+// Per emitter, storage buffer (std430). Written once when the emitter is added, the GPU then updates the remainder.
+struct ParticleEmitterData
+{
+    glm::vec4 positionRadius; // Spawn sphere center (xyz) and radius (w)
+    glm::vec4 velocitySpread; // Initial velocity (xyz), and the random speed added in any direction (w)
+    glm::vec4 colorSize;      // Color (rgb), and the size of the particles in world units (w)
+    float rate;               // Particles per second
+    float lifetime;           // Seconds
+    float remainder;          // Fraction of a particle left to emit, carried over to the next frame
+    uint32_t padding;
+};
+
+static_assert(sizeof(ParticleEmitterData) % 16 == 0, "ParticleEmitterData must keep a std430 friendly size");
+
+// Particle compute passes push constants, see shaders/particleEmit.comp, particleSimulate.comp, particleControl.comp
+struct ParticleFrameData
+{
+    glm::vec4 gravity; // Acceleration (xyz), and the fraction of the velocity lost per second (w)
+    float deltaTime;
+    float time; // Seed of the random emission
+    uint32_t emitterCount;
+    uint32_t capacity;
+    uint32_t aliveList; // Alive list emitted to and simulated this frame, the survivors go to the other one
+    uint32_t mode;      // ParticleControlMode, only read by particleControl.comp
+};
+
+// Particle draw push constants, see shaders/particles.vert
+struct ParticleDrawData
+{
+    glm::mat4 viewProj;
+    uint32_t aliveList; // Alive list the simulation appended to
+    uint32_t capacity;
+};
+} // namespace VulkanRenderer
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+
+namespace VulkanRenderer
+{
+// Material features a shader can be specialized on.
+// The value is both the bit in the mask and the constant_id in the shaders (see shaders/features.glsl).
+enum class ShaderFeature : uint32_t
+{
+    VertexColor = 0,
+    Grayscale = 1,
+
+    Count
+};
+
+// One bit per ShaderFeature, used as a key for the pipeline variants.
+using ShaderFeatureMask = uint32_t;
+
+static_assert(static_cast<uint32_t>(ShaderFeature::Count) <= sizeof(ShaderFeatureMask) * 8,
+              "Too many shader features for the mask");
+
+constexpr ShaderFeatureMask ShaderFeatureBit(ShaderFeature feature)
+{
+    return ShaderFeatureMask(1) << static_cast<uint32_t>(feature);
+}
+
+constexpr ShaderFeatureMask allShaderFeatures = ShaderFeatureBit(ShaderFeature::Count) - 1;
+
+// Specialization constants for a feature mask, one VkBool32 per feature.
+// Constants not declared by a shader stage are simply ignored by the driver.
+// Not copyable: the info points to the members.
+class ShaderSpecialization
+{
+public:
+    ShaderSpecialization(ShaderFeatureMask features);
+
+    ShaderSpecialization(const ShaderSpecialization&) = delete;
+    ShaderSpecialization& operator=(const ShaderSpecialization&) = delete;
+
+    const VkSpecializationInfo* GetInfo() const { return &m_info; }
+
+private:
+    static constexpr uint32_t featureCount = static_cast<uint32_t>(ShaderFeature::Count);
+
+    std::array<VkBool32, featureCount> m_values;
+    std::array<VkSpecializationMapEntry, featureCount> m_entries;
+    VkSpecializationInfo m_info;
+};
+} // namespace VulkanRenderer
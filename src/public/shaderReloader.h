@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace VulkanRenderer
+{
+struct ShaderReloaderConfig
+{
+    // GLSL sources, watched for changes. Included files are looked for there too.
+    std::string sourceFolder;
+    // SPIR-V compiled by previous runs, named after the hash of their sources
+    std::string cacheFolder;
+    // GLSL to SPIR-V compiler command, glslc compatible
+    std::string compiler;
+    // File names in the source folder, the others are ignored
+    std::vector<std::string> shaders;
+};
+
+// Recompile the shaders when their sources change.
+// The source folder is watched with inotify, polled once a frame without blocking. A changed shader, or any shader
+// including a changed file, is compiled on a thread of its own: the compiler runs for a while, a job would hold a
+// worker the frames need. The SPIR-V is cached on disk under the hash of the source and of
+// its includes, so going back to a previous version of a file doesn't compile it again.
+// Only available on Linux.
+class ShaderReloader
+{
+public:
+    struct CompiledShader
+    {
+        // As given in the config
+        std::string name;
+        std::vector<char> code;
+    };
+
+    ShaderReloader(ShaderReloaderConfig& config);
+    // Wait for the compilation in progress, those not started are dropped
+    ~ShaderReloader();
+
+    bool IsValid() const { return m_watch >= 0; }
+
+    // Read the file events, and start compiling the shaders they touch
+    void Poll();
+
+    // Shaders compiled since the last call, only the last version of each. Failed compilations are only logged.
+    std::vector<CompiledShader> TakeCompiled();
+
+private:
+    struct Request
+    {
+        std::string name;
+        uint64_t generation;
+    };
+
+    void CompileLoop();
+    // On the compile thread
+    void Compile(const std::string& name, uint64_t generation);
+    bool ReadSource(const std::string& fileName, std::string& outSource) const;
+    // Hash of the source and of all the files it includes, recursively
+    bool HashSource(const std::string& fileName, uint64_t& hash, std::unordered_set<std::string>& visited) const;
+    bool RunCompiler(const std::string& sourcePath, const std::string& outputPath) const;
+
+    std::string m_sourceFolder;
+    std::string m_cacheFolder;
+    std::string m_compiler;
+    std::vector<std::string> m_shaders;
+
+    int m_inotify = -1;
+    int m_watch = -1;
+
+    std::thread m_compileThread;
+    std::mutex m_requestsMutex;
+    std::condition_variable m_requestsAvailable;
+    // One per shader at most, the latest generation
+    std::deque<Request> m_requests;
+    bool m_stop = false;
+
+    // Latest compilation started per shader, the results of older ones are dropped
+    std::mutex m_compiledMutex;
+    std::unordered_map<std::string, uint64_t> m_generations;
+    std::vector<CompiledShader> m_compiled;
+};
+} // namespace VulkanRenderer
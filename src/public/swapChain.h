@@ -8,6 +8,8 @@ struct GLFWwindow;
 
 namespace VulkanRenderer
 {
+struct QueueFamilyIndices;
+
 struct SwapChainSupportDetails
 {
     VkSurfaceCapabilitiesKHR capabilities;
@@ -18,7 +20,9 @@ struct SwapChainSupportDetails
 class SwapChain
 {
 public:
+    // Formats and present modes come from the cached support details, only the capabilities are queried again.
     SwapChain(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, GLFWwindow* window,
+              const QueueFamilyIndices& queueFamilies, const SwapChainSupportDetails& supportDetails,
               SwapChain* oldSwapChain = nullptr);
     ~SwapChain();
 
@@ -29,6 +33,7 @@ public:
     std::vector<VkImageView>& GetImageViews() { return m_imageViews; }
     VkFormat GetFormat() const { return m_surfaceFormat.format; }
     VkExtent2D GetExtent() const { return m_extent; }
+    VkImageUsageFlags GetImageUsage() const { return m_imageUsage; }
 
     static void FillSwapChainSupportDetails(VkPhysicalDevice device, VkSurfaceKHR surface,
                                             SwapChainSupportDetails& outDetails);
@@ -47,5 +52,6 @@ private:
     VkSurfaceFormatKHR m_surfaceFormat;
     VkPresentModeKHR m_presentMode;
     VkExtent2D m_extent;
+    VkImageUsageFlags m_imageUsage = 0;
 };
 } // namespace VulkanRenderer
\ No newline at end of file
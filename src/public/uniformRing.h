@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace VulkanRenderer
+{
+class DescriptorAllocator;
+class DescriptorLayoutCache;
+
+struct UniformRingConfig
+{
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    DescriptorLayoutCache* layoutCache;
+    // The set of each frame comes from it, its BeginFrame must be called before the one of the ring
+    DescriptorAllocator* descriptorAllocator;
+    // Bytes available to a single frame
+    VkDeviceSize sizePerFrame;
+    // Size visible by the shaders from a dynamic offset, should cover the biggest per-draw struct.
+    VkDeviceSize bindingRange;
+    uint32_t framesInFlight;
+};
+
+struct RingAllocation
+{
+    void* data = nullptr;
+    uint32_t offset = 0; // To be used as a dynamic offset
+    VkDeviceSize size = 0;
+
+    bool IsValid() const { return data != nullptr; }
+};
+
+// A single buffer, persistently mapped, split in one region per frame in flight.
+// Per-draw data is bump allocated in the current frame region and bound with dynamic offsets,
+// so there is no map/unmap nor buffer creation while drawing.
+// Exposed as set with a dynamic uniform buffer (binding 0) and a dynamic storage buffer (binding 1), allocated each
+// frame from the descriptor allocator like the other per frame sets.
+class UniformRing
+{
+public:
+    UniformRing(UniformRingConfig& config);
+    ~UniformRing();
+
+    bool IsValid() const;
+
+    // To be called once the fence of this frame has been waited on.
+    void BeginFrame(uint32_t frameIndex);
+
+    // Return an invalid allocation when the frame region is full, or the frame has no set.
+    RingAllocation Allocate(VkDeviceSize size);
+
+    template <typename T>
+    RingAllocation Push(const T& value)
+    {
+        RingAllocation allocation = Allocate(sizeof(T));
+        if (allocation.IsValid())
+            std::memcpy(allocation.data, &value, sizeof(T));
+
+        return allocation;
+    }
+
+    void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+              uint32_t setIndex, uint32_t uniformOffset, uint32_t storageOffset = 0) const;
+
+    VkBuffer GetBuffer() const { return m_buffer; }
+    VkDescriptorSetLayout GetLayout() const { return m_layout; }
+    VkDeviceSize GetAlignment() const { return m_alignment; }
+    VkDeviceSize GetUsedBytes() const { return m_head - m_frameBegin; }
+
+private:
+    void CreateLayout(DescriptorLayoutCache& layoutCache);
+    void AllocateDescriptorSet();
+
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkBuffer m_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    uint8_t* m_mapped = nullptr;
+
+    DescriptorAllocator* m_descriptorAllocator = nullptr;
+    VkDescriptorSetLayout m_layout = VK_NULL_HANDLE; // Owned by the layout cache
+    // Of the current frame
+    VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+    VkDeviceSize m_alignment = 1;
+    VkDeviceSize m_sizePerFrame = 0;
+    VkDeviceSize m_bindingRange = 0;
+    uint32_t m_framesInFlight = 1;
+
+    VkDeviceSize m_frameBegin = 0;
+    VkDeviceSize m_frameEnd = 0;
+    VkDeviceSize m_head = 0;
+};
+} // namespace VulkanRenderer
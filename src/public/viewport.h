@@ -0,0 +1,127 @@
+#pragma once
+
+#include <shaderInterface.h>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace VulkanRenderer
+{
+class Attachment;
+struct QueueFamilyIndices;
+class RenderTarget;
+class SwapChain;
+struct SwapChainSupportDetails;
+
+struct ViewportConfig
+{
+    VkInstance instance;
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    const QueueFamilyIndices* queueFamilies;
+    uint32_t framesInFlight;
+    // Unique for the lifetime of the application, unlike the index of the viewport
+    uint32_t id = 0;
+    // Same as the pipelines, the multisampled attachment is resolved in the viewport image
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkFormat depthFormat;
+    // Depth left readable by compute shaders once rendered, for the occlusion culling
+    bool keepDepth = false;
+
+    // Window viewports. The viewport owns the window and its surface from now on.
+    GLFWwindow* window = nullptr;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    // Already queried for the surface the device was picked with, queried here when null
+    const SwapChainSupportDetails* swapChainSupport = nullptr;
+
+    // Offscreen viewports, rendered to an image left in the transfer source layout
+    VkRenderPass offscreenRenderPass = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+};
+
+// Where the scene is rendered each frame: a window through its swap chain, or an offscreen image.
+// Viewports share the device and the pipelines, and all of them are recorded, submitted and presented together.
+class Viewport
+{
+public:
+    Viewport(ViewportConfig& config);
+    // The GPU must be done with the viewport
+    ~Viewport();
+
+    bool IsValid() const;
+    bool IsOffscreen() const { return m_window == nullptr; }
+    uint32_t GetId() const { return m_id; }
+
+    // Window viewports, once the render pass exists. Offscreen viewports already have theirs.
+    bool CreateFramebuffers(VkRenderPass renderPass);
+
+    // Acquire the image rendered this frame, signaling the image available semaphore of frameIndex.
+    // VK_ERROR_OUT_OF_DATE_KHR when the swap chain must be recreated first. Always succeeds offscreen.
+    VkResult AcquireImage(uint32_t frameIndex);
+    // Resized or reported out of date. Recreated on the next acquire.
+    void MarkOutOfDate() { m_outOfDate = true; }
+    // Nothing to render into until the window is restored
+    bool IsMinimized() const;
+    // New swap chain and framebuffers. The GPU must be idle.
+    bool Recreate();
+
+    // Target of the current image
+    VkRenderPass GetRenderPass() const { return m_renderPass; }
+    VkFramebuffer GetFramebuffer() const;
+    VkImage GetImage() const;
+    VkFormat GetFormat() const;
+    VkExtent2D GetExtent() const;
+    VkImageUsageFlags GetImageUsage() const;
+    // Layout the render pass leaves the image in
+    VkImageLayout GetFinalLayout() const;
+    // Left in the depth read only layout when kept
+    VkImageView GetDepthView() const;
+
+    // Window viewports only
+    GLFWwindow* GetWindow() const { return m_window; }
+    VkSwapchainKHR GetSwapChain() const;
+    uint32_t GetImageIndex() const { return m_imageIndex; }
+    VkSemaphore GetImageAvailableSemaphore(uint32_t frameIndex) const { return m_imageAvailable[frameIndex]; }
+    VkSemaphore GetRenderFinishedSemaphore(uint32_t frameIndex) const { return m_renderFinished[frameIndex]; }
+
+    const CameraData& GetCamera() const { return m_camera; }
+    void SetCamera(const CameraData& camera) { m_camera = camera; }
+
+private:
+    bool CreateSwapChain();
+    void DestroyFramebuffers();
+
+    VkInstance m_instanceCache = VK_NULL_HANDLE;
+    VkDevice m_deviceCache = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    const QueueFamilyIndices* m_queueFamilies = nullptr;
+    uint32_t m_id = 0;
+
+    GLFWwindow* m_window = nullptr;
+    VkSurfaceKHR m_surface = VK_NULL_HANDLE;
+    std::unique_ptr<SwapChainSupportDetails> m_swapChainSupport;
+    std::unique_ptr<SwapChain> m_swapChain;
+    std::vector<VkFramebuffer> m_framebuffers;
+    // Shared by the framebuffers, sized like the swap chain
+    std::unique_ptr<Attachment> m_multisample;
+    std::unique_ptr<Attachment> m_depth;
+    VkSampleCountFlagBits m_samples = VK_SAMPLE_COUNT_1_BIT;
+    VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
+    bool m_keepDepth = false;
+    std::vector<VkSemaphore> m_imageAvailable;
+    std::vector<VkSemaphore> m_renderFinished;
+    uint32_t m_imageIndex = 0;
+    bool m_outOfDate = false;
+
+    std::unique_ptr<RenderTarget> m_renderTarget;
+
+    VkRenderPass m_renderPass = VK_NULL_HANDLE;
+    CameraData m_camera{glm::mat4(1.0f)};
+};
+} // namespace VulkanRenderer